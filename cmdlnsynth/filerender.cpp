@@ -0,0 +1,295 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "filerender.h"
+#include "filewrapper.h"
+#include "loudnessmeter.h"
+#include "rendercache.h"
+#include "synthengine.h"
+#include "wavwriter.h"
+
+/* frames rendered between two EAS_State calls */
+static const std::size_t RENDER_STEP = 1024;
+/* a tail this long below the threshold ends the rendering */
+static const int TAIL_WINDOW_MILLIS = 200;
+/* notes held until the end of the file may never fade out */
+static const int MAX_TAIL_MILLIS = 10000;
+
+/* feeds the meter, and writes the frames; after the song stopped, the
+   quiet frames are held back until something louder follows */
+class MeasuredOutput
+{
+public:
+    MeasuredOutput(int sampleRate, int channels, double threshold)
+        : m_meter(sampleRate, channels)
+        , m_channels(channels)
+        , m_threshold(int(32768.0 * std::pow(10.0, threshold / 20.0)))
+        , m_windowFrames(std::uint64_t(TAIL_WINDOW_MILLIS) * sampleRate / 1000)
+        , m_maxTailFrames(std::uint64_t(MAX_TAIL_MILLIS) * sampleRate / 1000)
+        , m_stopFrame(0)
+        , m_renderedFrames(0)
+        , m_stopped(false)
+        , m_ok(true)
+    {}
+
+    bool open(const QString &path, int sampleRate)
+    {
+        return m_wav.open(QFile::encodeName(path).constData(), sampleRate, m_channels);
+    }
+
+    void setStopped()
+    {
+        if (!m_stopped) {
+            m_stopped = true;
+            m_stopFrame = m_renderedFrames;
+        }
+    }
+
+    /* returns true once the tail is over */
+    bool add(const std::int16_t *samples, std::size_t frames)
+    {
+        m_meter.process(samples, frames);
+        m_renderedFrames += frames;
+        if (!m_stopped) {
+            m_ok = m_wav.write(samples, frames) && m_ok;
+            return false;
+        }
+        std::size_t loud = 0;
+        for (std::size_t i = frames * m_channels; i > 0; --i) {
+            if (std::abs(samples[i - 1]) > m_threshold) {
+                loud = (i - 1) / m_channels + 1;
+                break;
+            }
+        }
+        if (loud > 0) {
+            m_ok = m_wav.write(m_pending.data(), m_pending.size() / m_channels) && m_ok;
+            m_ok = m_wav.write(samples, loud) && m_ok;
+            m_pending.clear();
+        }
+        m_pending.insert(m_pending.end(), samples + loud * m_channels, samples + frames * m_channels);
+        return m_pending.size() / m_channels >= m_windowFrames
+               || m_renderedFrames - m_stopFrame >= m_maxTailFrames;
+    }
+
+    bool close()
+    {
+        const bool closed = m_wav.close();
+        return closed && m_ok;
+    }
+
+    const LoudnessMeter &meter() const { return m_meter; }
+    std::uint64_t writtenFrames() const { return m_wav.frames(); }
+    std::uint64_t renderedFrames() const { return m_renderedFrames; }
+    std::uint64_t stopFrame() const { return m_stopped ? m_stopFrame : m_renderedFrames; }
+
+private:
+    LoudnessMeter m_meter;
+    WavWriter m_wav;
+    std::vector<std::int16_t> m_pending;
+    int m_channels;
+    int m_threshold;
+    std::uint64_t m_windowFrames;
+    std::uint64_t m_maxTailFrames;
+    std::uint64_t m_stopFrame;
+    std::uint64_t m_renderedFrames;
+    bool m_stopped;
+    bool m_ok;
+};
+
+/* JSON has no infinities: the loudness of silence is null */
+static QJsonValue measure(double value)
+{
+    if (!std::isfinite(value)) {
+        return QJsonValue();
+    }
+    return std::round(value * 100.0) / 100.0;
+}
+
+FileRender::FileRender(const BounceSettings &settings)
+    : m_settings(settings)
+    , m_directory(QStringLiteral("."))
+    , m_tailThreshold(-60.0)
+    , m_renderCache(false)
+{}
+
+void FileRender::setDirectory(const QString &directory)
+{
+    m_directory = directory;
+}
+
+void FileRender::setTailThreshold(double decibels)
+{
+    m_tailThreshold = decibels;
+}
+
+void FileRender::setRenderCache(bool enabled)
+{
+    m_renderCache = enabled;
+}
+
+bool FileRender::renderFile(const QString &fileName)
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (!QDir().mkpath(m_directory)) {
+        fprintf(stderr, "Cannot create the directory %s\n", qPrintable(m_directory));
+        return false;
+    }
+    const QString baseName = QDir(m_directory).filePath(QFileInfo(fileName).completeBaseName());
+    const QString wavName = baseName + QStringLiteral(".wav");
+
+    /* a cached render is only measured and trimmed */
+    std::vector<std::int16_t> cached;
+    int sampleRate = 0, channels = 0, duration = 0;
+    bool fromCache = false;
+    if (m_renderCache) {
+        QFile file(fileName);
+        if (file.open(QIODevice::ReadOnly)) {
+            const QByteArray key = RenderCache::instance()->key(file.readAll(), m_settings);
+            fromCache = RenderCache::instance()->lookup(key, cached, sampleRate, channels, duration);
+        }
+    }
+
+    std::unique_ptr<MeasuredOutput> output;
+    if (fromCache) {
+        output.reset(new MeasuredOutput(sampleRate, channels, m_tailThreshold));
+        if (!output->open(wavName, sampleRate)) {
+            fprintf(stderr, "Cannot create %s\n", qPrintable(wavName));
+            return false;
+        }
+        const std::size_t frames = cached.size() / channels;
+        const std::size_t stopFrame = std::size_t(duration) * sampleRate / 1000;
+        for (std::size_t position = 0; position < frames; position += RENDER_STEP) {
+            if (position >= stopFrame) {
+                output->setStopped();
+            }
+            if (output->add(cached.data() + position * channels, std::min(RENDER_STEP, frames - position))) {
+                break;
+            }
+        }
+    } else {
+        SynthEngine engine;
+        if (!engine.init(m_settings.soundLib,
+                         m_settings.soundfont.empty() ? nullptr : m_settings.soundfont.c_str())) {
+            fprintf(stderr, "Cannot initialize the synthesizer\n");
+            return false;
+        }
+        /* the file drives the engine, so it must never be idled */
+        engine.setIdleDetection(false);
+        if (m_settings.reverbType >= 0) {
+            engine.setReverb(m_settings.reverbType);
+        }
+        if (m_settings.reverbWet >= 0) {
+            engine.setReverbWet(m_settings.reverbWet);
+        }
+        if (m_settings.chorusType >= 0) {
+            engine.setChorus(m_settings.chorusType);
+        }
+        if (m_settings.chorusLevel >= 0) {
+            engine.setChorusLevel(m_settings.chorusLevel);
+        }
+        FileWrapper file(fileName);
+        EAS_HANDLE handle = nullptr;
+        if (!file.ok() || EAS_OpenFile(engine.easData(), file.getLocator(), &handle) != EAS_SUCCESS) {
+            fprintf(stderr, "Cannot open %s\n", qPrintable(fileName));
+            return false;
+        }
+        if (EAS_Prepare(engine.easData(), handle) != EAS_SUCCESS) {
+            EAS_CloseFile(engine.easData(), handle);
+            fprintf(stderr, "Cannot play %s\n", qPrintable(fileName));
+            return false;
+        }
+        sampleRate = engine.sampleRate();
+        channels = engine.channels();
+        output.reset(new MeasuredOutput(sampleRate, channels, m_tailThreshold));
+        if (!output->open(wavName, sampleRate)) {
+            EAS_CloseFile(engine.easData(), handle);
+            fprintf(stderr, "Cannot create %s\n", qPrintable(wavName));
+            return false;
+        }
+        std::vector<std::int16_t> buffer(RENDER_STEP * channels);
+        for (;;) {
+            engine.render(buffer.data(), RENDER_STEP);
+            if (output->add(buffer.data(), RENDER_STEP)) {
+                break;
+            }
+            EAS_STATE state = EAS_STATE_EMPTY;
+            EAS_State(engine.easData(), handle, &state);
+            if (state == EAS_STATE_STOPPED || state == EAS_STATE_ERROR || state == EAS_STATE_EMPTY) {
+                output->setStopped();
+            }
+        }
+        EAS_CloseFile(engine.easData(), handle);
+    }
+    if (!output->close()) {
+        fprintf(stderr, "Cannot write %s\n", qPrintable(wavName));
+        return false;
+    }
+    const double seconds = timer.nsecsElapsed() / 1e9;
+
+    const LoudnessMeter::Values values = output->meter().values();
+    QJsonObject json;
+    json.insert(QStringLiteral("file"), QFileInfo(fileName).absoluteFilePath());
+    json.insert(QStringLiteral("audio"), QFileInfo(wavName).fileName());
+    json.insert(QStringLiteral("sampleRate"), sampleRate);
+    json.insert(QStringLiteral("channels"), channels);
+    json.insert(QStringLiteral("frames"), double(output->writtenFrames()));
+    json.insert(QStringLiteral("duration"), double(output->writtenFrames()) / sampleRate);
+    json.insert(QStringLiteral("songEnd"), double(output->stopFrame()) / sampleRate);
+    json.insert(QStringLiteral("trimmedFrames"), double(output->renderedFrames() - output->writtenFrames()));
+    json.insert(QStringLiteral("tailThreshold"), m_tailThreshold);
+    json.insert(QStringLiteral("integratedLoudness"), measure(values.integrated));
+    json.insert(QStringLiteral("loudnessRange"), measure(values.range));
+    json.insert(QStringLiteral("maxMomentaryLoudness"), measure(values.maxMomentary));
+    json.insert(QStringLiteral("maxShortTermLoudness"), measure(values.maxShortTerm));
+    json.insert(QStringLiteral("samplePeak"), measure(values.samplePeak));
+    json.insert(QStringLiteral("truePeak"), measure(values.truePeak));
+    json.insert(QStringLiteral("cached"), fromCache);
+    json.insert(QStringLiteral("renderSeconds"), measure(seconds));
+    const QString jsonName = baseName + QStringLiteral(".json");
+    QFile sidecar(jsonName);
+    if (!sidecar.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || sidecar.write(QJsonDocument(json).toJson()) < 0) {
+        fprintf(stderr, "Cannot write %s\n", qPrintable(jsonName));
+        return false;
+    }
+
+    fprintf(stdout,
+            "%s: %.1f s, %.1f LUFS, %.1f LU, true peak %.1f dBTP%s (%.3f s)\n",
+            qPrintable(fileName),
+            double(output->writtenFrames()) / sampleRate,
+            values.integrated,
+            values.range,
+            values.truePeak,
+            fromCache ? ", cached" : "",
+            seconds);
+    return true;
+}
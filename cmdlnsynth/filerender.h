@@ -0,0 +1,54 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FILERENDER_H
+#define FILERENDER_H
+
+#include <QString>
+
+#include "songbouncer.h"
+
+/**
+ * Offline render of MIDI files into WAVE files, measured on the way. The
+ * EBU R128 loudness, true peak and end of the audible tail are computed
+ * block by block as EAS renders them, and written to a JSON file next to
+ * the audio. Once EAS_State reports the song stopped, the rendering ends
+ * as soon as the tail stays below the threshold, and that quiet end is
+ * not written.
+ */
+class FileRender
+{
+public:
+    explicit FileRender(const BounceSettings &settings);
+
+    void setDirectory(const QString &directory);
+    /* in dBFS */
+    void setTailThreshold(double decibels);
+    /* measures the renders found in RenderCache instead of rendering again */
+    void setRenderCache(bool enabled);
+
+    bool renderFile(const QString &fileName);
+
+private:
+    BounceSettings m_settings;
+    QString m_directory;
+    double m_tailThreshold;
+    bool m_renderCache;
+};
+
+#endif // FILERENDER_H
@@ -19,16 +19,32 @@
 #include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QDebug>
+#include <QFile>
 #include <QFileInfo>
 #include <QScopedPointer>
+#include <QTimer>
 #include <csignal>
 #include <cstdio>
 
 #include <eas_reverb.h>
+#include "metadatacache.h"
+#include "metricsserver.h"
+#include "nulloutput.h"
 #include "synthcontroller.h"
 #include "programsettings.h"
+#include "soaktest.h"
+#include "filerender.h"
+#include "stemexport.h"
+#include "tracer.h"
+#if defined(SVOXEAS_RT_CHECKS)
+#include "rtsafety.h"
+#endif
 
 QScopedPointer<SynthController> synth;
+#if defined(SIGUSR1)
+/* the flight record is written by the event loop, not by the handler */
+volatile sig_atomic_t flightRecordRequested = 0;
+#endif
 
 void signalHandler(int sig)
 {
@@ -40,6 +56,13 @@ void signalHandler(int sig)
     qApp->quit();
 }
 
+#if defined(SIGUSR1)
+void flightRecordHandler(int)
+{
+    flightRecordRequested = 1;
+}
+#endif
+
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
@@ -48,11 +71,14 @@ int main(int argc, char *argv[])
     QCoreApplication::setApplicationVersion(QT_STRINGIFY(VERSION));
     signal(SIGINT, signalHandler);
     signal(SIGTERM, signalHandler);
+#if defined(SIGUSR1)
+    signal(SIGUSR1, flightRecordHandler);
+#endif
     QCommandLineParser parser;
     parser.setApplicationDescription("Command Line MIDI Synthesizer and Player");
     parser.addVersionOption();
     parser.addHelpOption();
-    QCommandLineOption driverOption({"m", "driver"}, "MIDI Driver.", "midi_driver");
+    QCommandLineOption driverOption({"m", "driver"}, "MIDI Driver (a Drumstick backend or RawMIDI).", "midi_driver");
     QCommandLineOption portOption({"p", "port"}, "MIDI Port.", "port");
     QCommandLineOption listOption({"s", "subs"}, "List available MIDI Ports.");
     QCommandLineOption bufferOption({"b", "buffer"},"Audio buffer time in milliseconds.", "buffer_time", "100");
@@ -61,11 +87,36 @@ int main(int argc, char *argv[])
     QCommandLineOption wetOption({"w", "wet"}, "Reverb wet (0..32765).", "reverb_wet", "25800");
     QCommandLineOption chorusOption({"c", "chorus"}, "Chorus type (none=-1,presets=0,1,2,3).", "chorus_type", "-1");
     QCommandLineOption levelOption({"l", "level"}, "Chorus level (0..32765).", "chorus_level", "0");
-    QCommandLineOption deviceOption({"a", "audiodevice"}, "Audio Device Name", "device_name", "default");
+    QCommandLineOption deviceOption({"a", "audiodevice"}, "Audio Device Name (alsa:<pcm> for direct ALSA output, null to discard the audio)", "device_name", "default");
     QCommandLineOption sndLibOption({"s", "soundlib"},
                                     "Sound Library (1=WT, 2=FM)",
                                     "sound_lib",
                                     "1");
+    QCommandLineOption lyricsOption({"k", "lyrics"}, "Print lyrics and text events of the files.");
+    QCommandLineOption tempoOption({"t", "tempo"}, "Playback rate factor (0.5..2.0).", "tempo", "1.0");
+    QCommandLineOption noIdleOption("no-idle", "Keep rendering while the synthesizer is silent.");
+    QCommandLineOption prewarmOption("prewarm", "Load the instruments of each file, muted, before it starts playing.");
+    QCommandLineOption bounceOption("bounce", "Render the whole files ahead in the background and play the result.");
+    QCommandLineOption renderCacheOption("render-cache", "Keep the renders of --bounce on disk, and play cached renders of files.");
+    QCommandLineOption deterministicOption("deterministic", "Bit-exact file playback, each file starting from a fresh synthesizer.");
+    QCommandLineOption checksumOption("checksum", "Print a checksum of the audio every N rendered blocks.", "blocks");
+    QCommandLineOption captureOption("capture", "Log the live MIDI input and parameter changes, for mp_replaysynth.", "file.svcp");
+    QCommandLineOption flightRecordOption("flight-record", "File written with the recent render history on underruns, stalls and SIGUSR1.", "file");
+    QCommandLineOption traceOption("trace", "Write a timeline of the audio pipeline in Chrome trace format.", "file.json");
+    QCommandLineOption metricsOption("metrics", "Serve Prometheus metrics on a localhost TCP port or a local socket.", "port|socket");
+    QCommandLineOption soakOption("soak", "Soak test: loop the files and random MIDI for this long, on the null audio device.", "minutes");
+    QCommandLineOption soakIntervalOption("soak-interval", "Seconds between soak test samples.", "seconds", "60");
+    QCommandLineOption soakCycleOption("soak-cycle", "Seconds between soak test restarts.", "seconds", "300");
+    QCommandLineOption soakLimitsOption("soak-limits", "Soak test failure limits: RSS and heap growth in MiB, open files growth, callback time drift in percent.", "rss,heap,files,drift", "32,16,8,50");
+    QCommandLineOption stemsOption("stems", "Render each MIDI channel of the files into a WAVE file in this directory, without playing them.", "directory");
+    QCommandLineOption jobsOption("jobs", "Threads rendering the stems at once.", "count");
+    QCommandLineOption renderOption("render", "Render the files into WAVE files in this directory, measuring their loudness, without playing them.", "directory");
+    QCommandLineOption tailThresholdOption("tail-threshold", "Level in dBFS below which the tail of a rendered file is cut.", "dB", "-60");
+    QCommandLineOption layerOption("layer", "Play this file too, at the same time as the others and on the same synthesizer (repeatable).", "file");
+    QCommandLineOption rtMemoryOption("rt-memory", "Lock and prefault the audio memory, warming up the synthesizer on start.");
+    QCommandLineOption statsOption("stats", "Print render statistics at exit.");
+    QCommandLineOption periodOption("period", "ALSA period size in frames (0=from buffer time).", "frames", "0");
+    QCommandLineOption periodsOption("periods", "ALSA period count (2..16).", "count", "3");
     parser.addOption(driverOption);
     parser.addOption(portOption);
     parser.addOption(listOption);
@@ -77,6 +128,31 @@ int main(int argc, char *argv[])
     parser.addOption(levelOption);
     parser.addOption(deviceOption);
     parser.addOption(sndLibOption);
+    parser.addOption(tempoOption);
+    parser.addOption(lyricsOption);
+    parser.addOption(noIdleOption);
+    parser.addOption(prewarmOption);
+    parser.addOption(bounceOption);
+    parser.addOption(renderCacheOption);
+    parser.addOption(deterministicOption);
+    parser.addOption(checksumOption);
+    parser.addOption(captureOption);
+    parser.addOption(flightRecordOption);
+    parser.addOption(traceOption);
+    parser.addOption(metricsOption);
+    parser.addOption(soakOption);
+    parser.addOption(soakIntervalOption);
+    parser.addOption(soakCycleOption);
+    parser.addOption(soakLimitsOption);
+    parser.addOption(stemsOption);
+    parser.addOption(jobsOption);
+    parser.addOption(renderOption);
+    parser.addOption(tailThresholdOption);
+    parser.addOption(layerOption);
+    parser.addOption(rtMemoryOption);
+    parser.addOption(statsOption);
+    parser.addOption(periodOption);
+    parser.addOption(periodsOption);
     parser.addPositionalArgument("files", "MIDI Files (.mid;.kar;.xmf)", "[files ...]");
     parser.process(app);
     ProgramSettings::instance()->ReadFromNativeStorage();
@@ -158,6 +234,122 @@ int main(int argc, char *argv[])
             parser.showHelp(1);
         }
     }
+    qreal tempo = 1.0;
+    if (parser.isSet(tempoOption)) {
+        tempo = parser.value(tempoOption).toDouble();
+        if (tempo < 0.5 || tempo > 2.0) {
+            fputs("Wrong playback rate.\n", stderr);
+            parser.showHelp(1);
+        }
+    }
+    int checksumInterval = 0;
+    if (parser.isSet(checksumOption)) {
+        checksumInterval = parser.value(checksumOption).toInt();
+        if (checksumInterval <= 0) {
+            fputs("Wrong checksum interval.\n", stderr);
+            parser.showHelp(1);
+        }
+    }
+    int periodSize = 0;
+    if (parser.isSet(periodOption)) {
+        periodSize = parser.value(periodOption).toInt();
+        if (periodSize < 0) {
+            fputs("Wrong period size.\n", stderr);
+            parser.showHelp(1);
+        }
+    }
+    int periodCount = 0;
+    if (parser.isSet(periodsOption)) {
+        periodCount = parser.value(periodsOption).toInt();
+        if (periodCount < 2 || periodCount > 16) {
+            fputs("Wrong period count.\n", stderr);
+            parser.showHelp(1);
+        }
+    }
+    const bool soak = parser.isSet(soakOption);
+    SoakTest::Limits soakLimits;
+    const int soakMinutes = parser.value(soakOption).toInt();
+    const int soakInterval = parser.value(soakIntervalOption).toInt();
+    const int soakCycle = parser.value(soakCycleOption).toInt();
+    if (soak) {
+        const QStringList limits = parser.value(soakLimitsOption).split(',');
+        if (soakMinutes <= 0 || soakInterval <= 0 || soakCycle <= 0 || limits.size() != 4) {
+            fputs("Wrong soak test duration, interval, cycle or limits.\n", stderr);
+            parser.showHelp(1);
+        }
+        soakLimits.rssMiB = limits.at(0).toDouble();
+        soakLimits.heapMiB = limits.at(1).toDouble();
+        soakLimits.files = limits.at(2).toInt();
+        soakLimits.drift = limits.at(3).toDouble();
+    }
+    if (parser.isSet(stemsOption) || parser.isSet(renderOption)) {
+        /* offline: neither the controller nor an audio device are needed */
+        BounceSettings settings;
+        settings.soundLib = ProgramSettings::instance()->soundLib();
+        settings.soundfont = QFile::encodeName(ProgramSettings::instance()->Soundfont()).toStdString();
+        settings.reverbType = ProgramSettings::instance()->reverbType();
+        settings.reverbWet = ProgramSettings::instance()->reverbWet();
+        settings.chorusType = ProgramSettings::instance()->chorusType();
+        settings.chorusLevel = ProgramSettings::instance()->chorusLevel();
+        const QStringList files = parser.positionalArguments();
+        if (files.isEmpty()) {
+            fputs("No MIDI files to render.\n", stderr);
+            parser.showHelp(1);
+        }
+        bool ok = true;
+        if (parser.isSet(stemsOption)) {
+            StemExport stems(settings);
+            stems.setDirectory(parser.value(stemsOption));
+            if (parser.isSet(jobsOption)) {
+                const int jobs = parser.value(jobsOption).toInt();
+                if (jobs <= 0) {
+                    fputs("Wrong number of jobs.\n", stderr);
+                    parser.showHelp(1);
+                }
+                stems.setJobs(jobs);
+            }
+            for (const auto &file : files) {
+                ok = stems.exportFile(file) && ok;
+            }
+        }
+        if (parser.isSet(renderOption)) {
+            bool valid = false;
+            const double threshold = parser.value(tailThresholdOption).toDouble(&valid);
+            if (!valid || threshold >= 0.0) {
+                fputs("Wrong tail threshold.\n", stderr);
+                parser.showHelp(1);
+            }
+            FileRender render(settings);
+            render.setDirectory(parser.value(renderOption));
+            render.setTailThreshold(threshold);
+            render.setRenderCache(parser.isSet(renderCacheOption));
+            for (const auto &file : files) {
+                ok = render.renderFile(file) && ok;
+            }
+        }
+        return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    /* started before the controller, to see the engine initialization too */
+    QTimer traceTimer;
+    if (parser.isSet(traceOption)) {
+        if (Tracer::open(QFile::encodeName(parser.value(traceOption)).constData())) {
+            Tracer::setThreadName("main");
+            QObject::connect(&traceTimer, &QTimer::timeout, &app, &Tracer::flush);
+            traceTimer.start(100);
+            QObject::connect(&app, &QCoreApplication::aboutToQuit, &app, [] {
+                Tracer::close();
+                if (Tracer::dropped() > 0) {
+                    fprintf(stderr, "Trace events dropped: %llu\n", (unsigned long long) Tracer::dropped());
+                }
+                if (Tracer::untracedThreads() > 0) {
+                    fprintf(stderr, "Threads without a trace buffer: %llu\n",
+                            (unsigned long long) Tracer::untracedThreads());
+                }
+            });
+        } else {
+            fputs("Cannot create the trace file.\n", stderr);
+        }
+    }
     synth.reset(new SynthController(ProgramSettings::instance()->bufferTime()));
     synth->setMidiDriver(ProgramSettings::instance()->midiDriver());
     if (parser.isSet(listOption)) {
@@ -179,32 +371,196 @@ int main(int argc, char *argv[])
         }
         return EXIT_SUCCESS;
     }
-    synth->subscribe(ProgramSettings::instance()->portName());
-    synth->setReverbWet(ProgramSettings::instance()->reverbWet());
-    synth->initReverb(ProgramSettings::instance()->reverbType());
-    synth->setChorusLevel(ProgramSettings::instance()->chorusLevel());
-    synth->initChorus(ProgramSettings::instance()->chorusType());
-    synth->initSoundfont(ProgramSettings::instance()->Soundfont());
+    /* a restart makes a new renderer: the soak test applies these again */
+    const auto applySettings = [] {
+        synth->subscribe(ProgramSettings::instance()->portName());
+        synth->setReverbWet(ProgramSettings::instance()->reverbWet());
+        synth->initReverb(ProgramSettings::instance()->reverbType());
+        synth->setChorusLevel(ProgramSettings::instance()->chorusLevel());
+        synth->initChorus(ProgramSettings::instance()->chorusType());
+        synth->initSoundfont(ProgramSettings::instance()->Soundfont());
+    };
+    applySettings();
+    synth->setPeriodSize(periodSize);
+    synth->setPeriodCount(periodCount);
     synth->setAudioDeviceName(ProgramSettings::instance()->audioDeviceName());
+    if (soak && !parser.isSet(deviceOption)) {
+        /* not stored in the settings, unlike the -a option */
+        synth->setAudioDeviceName(NullOutput::DEVICE_NAME);
+        applySettings();
+    }
+    synth->setPlaybackRate(tempo);
+    synth->setIdleDetection(!parser.isSet(noIdleOption));
+    synth->setRealtimeMemory(parser.isSet(rtMemoryOption));
+    synth->setPrewarm(parser.isSet(prewarmOption));
+    synth->setBounce(parser.isSet(bounceOption));
+    synth->setRenderCache(parser.isSet(renderCacheOption));
+    synth->setDeterministic(parser.isSet(deterministicOption));
+    synth->setChecksumInterval(checksumInterval);
+    if (parser.isSet(captureOption)) {
+        synth->setCaptureFile(parser.value(captureOption));
+    }
+    if (parser.isSet(flightRecordOption)) {
+        synth->setFlightRecordFile(parser.value(flightRecordOption));
+    }
+    if (parser.isSet(metricsOption)) {
+        MetricsServer *metrics = new MetricsServer(synth.get(), &app);
+        if (!metrics->listen(parser.value(metricsOption))) {
+            fprintf(stderr, "Cannot serve metrics: %s\n", qPrintable(metrics->errorString()));
+            return EXIT_FAILURE;
+        }
+    }
+#if defined(SIGUSR1)
+    QTimer flightRecordTimer;
+    QObject::connect(&flightRecordTimer, &QTimer::timeout, &app, [] {
+        if (flightRecordRequested) {
+            flightRecordRequested = 0;
+            if (synth->dumpFlightRecord(QStringLiteral("SIGUSR1"))) {
+                fprintf(stderr, "Flight record written to %s\n", qPrintable(synth->flightRecordFile()));
+            }
+        }
+    });
+    flightRecordTimer.start(100);
+#endif
+    if (checksumInterval > 0) {
+        QObject::connect(synth.get(), &SynthController::renderChecksum, &app,
+                         [](quint64 firstBlock, int blocks, quint64 value) {
+            fprintf(stdout, "checksum %llu+%d %016llx\n",
+                    (unsigned long long) firstBlock, blocks, (unsigned long long) value);
+            fflush(stdout);
+        });
+    }
     QObject::connect(synth.get(), &SynthController::underrunDetected, &app, []{
         fputs("Underrun error detected. Please increase the audio buffer size.\n", stderr);
     });
-    QObject::connect(synth.get(), &SynthController::stallDetected, &app, []{
+    QObject::connect(synth.get(), &SynthController::stallDetected, &app, [soak]{
         fputs("Audio stall error detected. Please increase the audio buffer size.\n", stderr);
-        synth->stop();
-        qApp->quit();
+        /* the soak test reports it as a failure and quits by itself */
+        if (!soak) {
+            synth->stop();
+            qApp->quit();
+        }
     });
     QObject::connect(&app, &QCoreApplication::aboutToQuit, ProgramSettings::instance(), &ProgramSettings::SaveToNativeStorage);
-    QObject::connect(synth.get(), &SynthController::playbackStopped, synth.get(), [=] {
-        synth->stop();
-        qApp->quit();
+    MetadataCache::instance()->load();
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, MetadataCache::instance(), [] {
+        MetadataCache::instance()->waitForDone();
+        MetadataCache::instance()->save();
     });
+    if (parser.isSet(statsOption)) {
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, &app, [] {
+            RenderStats::Values stats;
+            if (synth->readRenderStats(stats)) {
+                fprintf(stderr,
+                        "Rendered blocks: %llu (%.3f ms, peak %.3f ms)\n"
+                        "Idle blocks: %llu (%.3f ms)\n"
+                        "Idle wake-ups: %llu\n"
+                        "Pre-warm blocks: %llu (%.3f ms)\n",
+                        (unsigned long long) stats.renderedBlocks, stats.renderNanos / 1e6,
+                        stats.peakRenderNanos / 1e6,
+                        (unsigned long long) stats.idleBlocks, stats.idleNanos / 1e6,
+                        (unsigned long long) stats.wakeups,
+                        (unsigned long long) stats.prewarmBlocks, stats.prewarmNanos / 1e6);
+            }
+            RenderErrors::Counters errors;
+            synth->readRenderErrors(errors);
+            for (int i = 0; i < RenderErrors::CodeCount; ++i) {
+                if (errors.count[i] > 0) {
+                    fprintf(stderr, "%s errors: %llu\n", RenderErrors::codeName(i),
+                            (unsigned long long) errors.count[i]);
+                }
+            }
+            if (errors.dropped > 0) {
+                fprintf(stderr, "Unlogged errors (queue full): %llu\n", (unsigned long long) errors.dropped);
+            }
+#if defined(SVOXEAS_RT_CHECKS)
+            RtSafety::Counters rt;
+            RtSafety::read(rt);
+            fprintf(stderr,
+                    "RT violations: %llu allocations, %llu frees, %llu locks, %llu file opens, "
+                    "%llu file reads and writes\n",
+                    (unsigned long long) rt.allocations, (unsigned long long) rt.deallocations,
+                    (unsigned long long) rt.locks, (unsigned long long) rt.fileOpens,
+                    (unsigned long long) rt.fileIo);
+#endif
+        });
+    }
     QStringList args = parser.positionalArguments();
-    if (!args.isEmpty()) {
+    const QStringList layers = parser.values(layerOption);
+    if (!soak) {
+        /* the files and each layer end on their own; the last one quits */
+        static int pendingPlayback = 0;
+        const auto playbackFinished = [] {
+            if (--pendingPlayback <= 0) {
+                synth->stop();
+                qApp->quit();
+            }
+        };
+        QObject::connect(synth.get(), &SynthController::playbackStopped, synth.get(), playbackFinished);
+        QObject::connect(synth.get(), &SynthController::playerStopped, synth.get(),
+                         [=](int) { playbackFinished(); });
+        if (!args.isEmpty()) {
+            ++pendingPlayback;
+        }
+        for (int i = 0; i < layers.length(); ++i) {
+            if (i >= SynthRenderer::MAX_PLAYERS) {
+                fprintf(stderr, "Too many layers, only %d are played\n", SynthRenderer::MAX_PLAYERS);
+                break;
+            }
+            if (synth->openPlayer(i, QFileInfo(layers[i]).absoluteFilePath())) {
+                ++pendingPlayback;
+            }
+        }
+    }
+    if (parser.isSet(lyricsOption)) {
+        QObject::connect(synth.get(), &SynthController::metaDataEvent, &app,
+                         [](int type, const QString &text, int, qint64) {
+            if (type != MetaEvent::Lyric && type != MetaEvent::Text) {
+                return;
+            }
+            /* karaoke conventions: '@' headers, backslash new paragraph, slash new line */
+            if (text.startsWith('@')) {
+                return;
+            }
+            QString line = text;
+            if (line.startsWith('\\') || line.startsWith('/')) {
+                fputs("\n", stdout);
+                line.remove(0, 1);
+            }
+            fputs(line.toLocal8Bit(), stdout);
+            fflush(stdout);
+        });
+    }
+    if (soak) {
+        SoakTest *soakTest = new SoakTest(synth.get(), &app);
+        soakTest->setDuration(soakMinutes);
+        soakTest->setSampleInterval(soakInterval);
+        soakTest->setCycleInterval(soakCycle);
+        soakTest->setLimits(soakLimits);
+        soakTest->setPlaylist(args);
+        soakTest->setSoundfont(ProgramSettings::instance()->Soundfont());
+        soakTest->setSettingsCallback([=] {
+            applySettings();
+            synth->setPlaybackRate(tempo);
+        });
+        QObject::connect(soakTest, &SoakTest::finished, &app, [](bool passed) {
+            synth->stop();
+            QCoreApplication::exit(passed ? EXIT_SUCCESS : EXIT_FAILURE);
+        });
+        soakTest->start();
+    } else if (!args.isEmpty()) {
+        /* the first file starts the playback, the rest are queued after it */
+        bool first = true;
         for(int i = 0; i < args.length();  ++i) {
             QFileInfo argFile(args[i]);
-            if (argFile.exists()) {
+            if (!argFile.exists()) {
+                continue;
+            }
+            if (first) {
                 synth->startPlayback(argFile.absoluteFilePath());
+                first = false;
+            } else {
+                synth->playFile(argFile.absoluteFilePath());
             }
         }
     }
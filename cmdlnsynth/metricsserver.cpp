@@ -0,0 +1,245 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QList>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "metricsserver.h"
+#include "synthcontroller.h"
+
+namespace {
+
+/* requests are a handful of short lines; anything larger is not a scraper */
+const qint64 MAX_REQUEST_SIZE = 8192;
+
+void describe(QByteArray &out, const char *name, const char *type, const char *help)
+{
+    out += QByteArray("# HELP ") + name + ' ' + help + '\n';
+    out += QByteArray("# TYPE ") + name + ' ' + type + '\n';
+}
+
+void sampleCount(QByteArray &out, const char *name, quint64 value, const QByteArray &labels = QByteArray())
+{
+    out += name;
+    if (!labels.isEmpty()) {
+        out += '{' + labels + '}';
+    }
+    out += ' ' + QByteArray::number(value) + '\n';
+}
+
+void sampleValue(QByteArray &out, const char *name, double value, const QByteArray &labels = QByteArray())
+{
+    out += name;
+    if (!labels.isEmpty()) {
+        out += '{' + labels + '}';
+    }
+    out += ' ' + QByteArray::number(value, 'g', 9) + '\n';
+}
+
+void closeSocket(QTcpSocket *socket)
+{
+    socket->disconnectFromHost();
+}
+
+void closeSocket(QLocalSocket *socket)
+{
+    socket->disconnectFromServer();
+}
+
+} // namespace
+
+MetricsServer::MetricsServer(SynthController *controller, QObject *parent)
+    : QObject(parent)
+    , m_controller(controller)
+{}
+
+template<typename Socket>
+void MetricsServer::serve(Socket *socket)
+{
+    connect(socket, &Socket::disconnected, socket, &QObject::deleteLater);
+    connect(socket, &QIODevice::readyRead, this, [this, socket] {
+        /* only the request line matters; the headers are skipped */
+        QByteArray request = socket->property("request").toByteArray();
+        while (socket->canReadLine()) {
+            const QByteArray line = socket->readLine().trimmed();
+            if (request.isEmpty()) {
+                request = line;
+                socket->setProperty("request", request);
+            } else if (line.isEmpty()) {
+                socket->write(reply(request));
+                closeSocket(socket);
+                return;
+            }
+        }
+        if (socket->bytesAvailable() > MAX_REQUEST_SIZE) {
+            socket->abort();
+            socket->deleteLater();
+        }
+    });
+}
+
+bool MetricsServer::listen(const QString &address)
+{
+    bool isPort = false;
+    const quint16 port = address.toUShort(&isPort);
+    if (isPort) {
+        m_tcpServer = new QTcpServer(this);
+        if (!m_tcpServer->listen(QHostAddress::LocalHost, port)) {
+            m_errorString = m_tcpServer->errorString();
+            return false;
+        }
+        connect(m_tcpServer, &QTcpServer::newConnection, this, [this] {
+            while (QTcpSocket *socket = m_tcpServer->nextPendingConnection()) {
+                serve(socket);
+            }
+        });
+        return true;
+    }
+    m_localServer = new QLocalServer(this);
+    /* a socket file left behind by a crashed instance would make listen() fail */
+    QLocalServer::removeServer(address);
+    if (!m_localServer->listen(address)) {
+        m_errorString = m_localServer->errorString();
+        return false;
+    }
+    connect(m_localServer, &QLocalServer::newConnection, this, [this] {
+        while (QLocalSocket *socket = m_localServer->nextPendingConnection()) {
+            serve(socket);
+        }
+    });
+    return true;
+}
+
+QString MetricsServer::errorString() const
+{
+    return m_errorString;
+}
+
+QByteArray MetricsServer::reply(const QByteArray &request) const
+{
+    //qDebug() << Q_FUNC_INFO << request;
+    const QList<QByteArray> parts = request.split(' ');
+    const bool head = !parts.isEmpty() && parts.first() == "HEAD";
+    QByteArray status("200 OK");
+    QByteArray body;
+    if (parts.size() < 2 || (parts.first() != "GET" && !head)) {
+        status = "405 Method Not Allowed";
+    } else {
+        const QByteArray path = parts.at(1).split('?').first();
+        if (path == "/metrics" || path == "/") {
+            body = metrics();
+        } else {
+            status = "404 Not Found";
+        }
+    }
+    QByteArray response = "HTTP/1.0 " + status + "\r\n"
+                          "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                          "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+                          "Connection: close\r\n\r\n";
+    if (!head) {
+        response += body;
+    }
+    return response;
+}
+
+QByteArray MetricsServer::metrics() const
+{
+    QByteArray out;
+    RenderStats::Values stats{};
+    RenderErrors::Counters errors{};
+    SynthSnapshot::State state{};
+    m_controller->readRenderStats(stats);
+    m_controller->readRenderErrors(errors);
+    m_controller->readSnapshot(state);
+
+    describe(out, "svoxeas_callback_duration_seconds", "histogram",
+             "Time spent in each audio callback.");
+    quint64 callbacks = 0;
+    for (int i = 0; i < RenderStats::CALLBACK_BUCKETS; ++i) {
+        callbacks += stats.callbackBuckets[i];
+        const QByteArray bound = (i < RenderStats::CALLBACK_BUCKETS - 1)
+                                     ? QByteArray::number(RenderStats::CALLBACK_BUCKET_MICROS[i] / 1e6)
+                                     : QByteArray("+Inf");
+        sampleCount(out, "svoxeas_callback_duration_seconds_bucket", callbacks, "le=\"" + bound + '"');
+    }
+    sampleValue(out, "svoxeas_callback_duration_seconds_sum", stats.callbackNanos / 1e9);
+    sampleCount(out, "svoxeas_callback_duration_seconds_count", callbacks);
+
+    describe(out, "svoxeas_callbacks_total", "counter", "Audio callbacks served.");
+    sampleCount(out, "svoxeas_callbacks_total", stats.callbacks);
+
+    describe(out, "svoxeas_blocks_total", "counter", "Synthesizer blocks, by how they were produced.");
+    sampleCount(out, "svoxeas_blocks_total", stats.renderedBlocks, "kind=\"rendered\"");
+    sampleCount(out, "svoxeas_blocks_total", stats.idleBlocks, "kind=\"idle\"");
+    sampleCount(out, "svoxeas_blocks_total", stats.prewarmBlocks, "kind=\"prewarm\"");
+
+    describe(out, "svoxeas_block_render_seconds_total", "counter", "Time spent in EAS_Render.");
+    sampleValue(out, "svoxeas_block_render_seconds_total", stats.renderNanos / 1e9);
+
+    describe(out, "svoxeas_block_render_peak_seconds", "gauge", "Slowest EAS_Render call so far.");
+    sampleValue(out, "svoxeas_block_render_peak_seconds", stats.peakRenderNanos / 1e9);
+
+    describe(out, "svoxeas_underruns_total", "counter", "Audio output underruns.");
+    sampleCount(out, "svoxeas_underruns_total", m_controller->underruns());
+
+    describe(out, "svoxeas_stalls_total", "counter", "Audio output stalls.");
+    sampleCount(out, "svoxeas_stalls_total", m_controller->stalls());
+
+    describe(out, "svoxeas_midi_events_total", "counter", "Live MIDI messages fed to the synthesizer.");
+    sampleCount(out, "svoxeas_midi_events_total", stats.midiEvents);
+
+    describe(out, "svoxeas_dropped_events_total", "counter", "Events lost because a queue was full.");
+    sampleCount(out, "svoxeas_dropped_events_total", errors.count[RenderErrors::MidiQueueFull], "queue=\"midi\"");
+    sampleCount(out, "svoxeas_dropped_events_total", errors.dropped, "queue=\"errors\"");
+
+    describe(out, "svoxeas_render_errors_total", "counter", "Failed calls in the render path.");
+    for (int i = 0; i < RenderErrors::CodeCount; ++i) {
+        if (i != RenderErrors::MidiQueueFull) {
+            sampleCount(out, "svoxeas_render_errors_total", errors.count[i],
+                        QByteArray("call=\"") + RenderErrors::codeName(i) + '"');
+        }
+    }
+
+    int notes = 0;
+    for (int chan = 0; chan < SynthSnapshot::NUM_CHANNELS; ++chan) {
+        for (int note = 0; note < SynthSnapshot::NUM_KEYS; ++note) {
+            if (state.isNoteOn(chan, note)) {
+                ++notes;
+            }
+        }
+    }
+    describe(out, "svoxeas_active_notes", "gauge", "Notes held by the live MIDI input.");
+    sampleCount(out, "svoxeas_active_notes", notes);
+
+    describe(out, "svoxeas_buffer_fill_seconds", "gauge", "Audio queued in the output buffer.");
+    sampleValue(out, "svoxeas_buffer_fill_seconds", m_controller->outputLatency() / 1e3);
+
+    describe(out, "svoxeas_idle", "gauge", "1 while the synthesizer skips rendering silence.");
+    sampleCount(out, "svoxeas_idle", m_controller->isIdle() ? 1 : 0);
+
+    describe(out, "svoxeas_playing", "gauge", "1 while a MIDI file is playing.");
+    sampleCount(out, "svoxeas_playing", state.playing ? 1 : 0);
+
+    describe(out, "svoxeas_playback_position_seconds", "gauge", "Position of the MIDI file being played.");
+    sampleValue(out, "svoxeas_playback_position_seconds", state.playing ? state.playbackTime / 1e3 : 0.0);
+
+    return out;
+}
@@ -0,0 +1,58 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+class QLocalServer;
+class QTcpServer;
+class SynthController;
+
+/**
+ * Serves the health of a SynthController over HTTP, in the Prometheus text
+ * exposition format. It lives in the main thread and only reads counters
+ * that the audio path updates without locks.
+ */
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetricsServer(SynthController *controller, QObject *parent = nullptr);
+
+    /* a port number listens on 127.0.0.1; anything else is a local socket name or path */
+    bool listen(const QString &address);
+    QString errorString() const;
+    QByteArray metrics() const;
+
+private:
+    template<typename Socket>
+    void serve(Socket *socket);
+    QByteArray reply(const QByteArray &request) const;
+
+private:
+    SynthController *m_controller;
+    QTcpServer *m_tcpServer{nullptr};
+    QLocalServer *m_localServer{nullptr};
+    QString m_errorString;
+};
+
+#endif // METRICSSERVER_H
@@ -0,0 +1,373 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+#if defined(Q_OS_LINUX)
+#include <malloc.h>
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#elif defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+#include "soaktest.h"
+#include "synthcontroller.h"
+
+/* random live MIDI traffic, a few messages every interval, in milliseconds */
+static const int TRAFFIC_INTERVAL = 10;
+/* polling period of the output buffer fill, in milliseconds */
+static const int FILL_INTERVAL = 10;
+static const double MIB = 1024.0 * 1024.0;
+
+/* resident set size in bytes, or -1 where unknown */
+static qint64 residentMemory()
+{
+#if defined(Q_OS_LINUX)
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (statm.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> fields = statm.readAll().split(' ');
+        if (fields.size() > 1) {
+            return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+        }
+    }
+    return -1;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) == KERN_SUCCESS) {
+        return info.resident_size;
+    }
+    return -1;
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return -1;
+#else
+    return -1;
+#endif
+}
+
+/* bytes allocated with malloc and still in use, or -1 where unknown */
+static qint64 heapInUse()
+{
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    const struct mallinfo2 info = mallinfo2();
+    return qint64(info.uordblks + info.hblkhd);
+#elif defined(Q_OS_MACOS)
+    malloc_statistics_t stats;
+    malloc_zone_statistics(nullptr, &stats);
+    return stats.size_in_use;
+#else
+    return -1;
+#endif
+}
+
+/* open file descriptors (handles on Windows), or -1 where unknown */
+static int openFiles()
+{
+#if defined(Q_OS_LINUX) || defined(Q_OS_MACOS)
+#if defined(Q_OS_LINUX)
+    QDir dir(QStringLiteral("/proc/self/fd"));
+#else
+    QDir dir(QStringLiteral("/dev/fd"));
+#endif
+    if (!dir.exists()) {
+        return -1;
+    }
+    /* the descriptor used to read the directory is counted too, every time */
+    return dir.entryList(QDir::AllEntries | QDir::System | QDir::Hidden | QDir::NoDotAndDotDot).size();
+#elif defined(Q_OS_WIN)
+    DWORD count = 0;
+    if (GetProcessHandleCount(GetCurrentProcess(), &count)) {
+        return int(count);
+    }
+    return -1;
+#else
+    return -1;
+#endif
+}
+
+static QString megabytes(qint64 bytes)
+{
+    return bytes < 0 ? QStringLiteral("n/a") : QStringLiteral("%1 MiB").arg(bytes / MIB, 0, 'f', 1);
+}
+
+SoakTest::SoakTest(SynthController *controller, QObject *parent)
+    : QObject(parent)
+    , m_controller(controller)
+{
+    std::fill(std::begin(m_held), std::end(m_held), -1);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &SoakTest::takeSample);
+    connect(&m_cycleTimer, &QTimer::timeout, this, &SoakTest::cycle);
+    connect(&m_trafficTimer, &QTimer::timeout, this, &SoakTest::sendTraffic);
+    connect(&m_fillTimer, &QTimer::timeout, this, [this] {
+        m_fillPeak = qMax(m_fillPeak, m_controller->outputLatency());
+    });
+    connect(m_controller, &SynthController::playbackStopped, this, &SoakTest::playPlaylist);
+    connect(m_controller, &SynthController::stallDetected, this, [this] {
+        finish(QStringLiteral("audio stall"));
+    });
+}
+
+void SoakTest::setDuration(int minutes)
+{
+    m_duration = minutes;
+}
+
+void SoakTest::setSampleInterval(int seconds)
+{
+    m_sampleInterval = seconds;
+}
+
+void SoakTest::setCycleInterval(int seconds)
+{
+    m_cycleInterval = seconds;
+}
+
+void SoakTest::setLimits(const Limits &limits)
+{
+    m_limits = limits;
+}
+
+void SoakTest::setPlaylist(const QStringList &files)
+{
+    m_playlist = files;
+}
+
+void SoakTest::setSoundfont(const QString &soundfont)
+{
+    m_soundfont = soundfont;
+}
+
+void SoakTest::setSettingsCallback(std::function<void()> callback)
+{
+    m_settingsCallback = std::move(callback);
+}
+
+void SoakTest::start()
+{
+    /* the first tenth of the run, at least two samples, is the reference */
+    m_warmUpSamples = qMax(2, m_duration * 60 / m_sampleInterval / 10);
+    m_controller->readRenderStats(m_lastStats);
+    m_clock.start();
+    playPlaylist();
+    m_sampleTimer.start(m_sampleInterval * 1000);
+    m_cycleTimer.start(m_cycleInterval * 1000);
+    m_trafficTimer.start(TRAFFIC_INTERVAL);
+    m_fillTimer.start(FILL_INTERVAL);
+    fprintf(stdout, "Soak test: %d minutes, a sample every %d s, a restart every %d s\n",
+            m_duration, m_sampleInterval, m_cycleInterval);
+    fflush(stdout);
+}
+
+/* the first file replaces whatever is playing, the others are queued after it */
+void SoakTest::playPlaylist()
+{
+    bool first = true;
+    foreach(const QString &file, m_playlist) {
+        const QFileInfo info(file);
+        if (!info.exists()) {
+            continue;
+        }
+        if (first) {
+            m_controller->startPlayback(info.absoluteFilePath());
+            first = false;
+        } else {
+            m_controller->playFile(info.absoluteFilePath());
+        }
+    }
+}
+
+/* notes, controllers and pitch bends over all the channels, with an
+   occasional program change */
+void SoakTest::sendTraffic()
+{
+    static const int CONTROLS[] = {1, 7, 10, 11, 64, 74, 91, 93};
+    QRandomGenerator *random = QRandomGenerator::global();
+    for (int i = random->bounded(4); i > 0; --i) {
+        const int chan = random->bounded(16);
+        const int kind = random->bounded(100);
+        if (kind < 70) {
+            if (m_held[chan] >= 0) {
+                m_controller->noteOff(chan, m_held[chan], 0);
+                m_held[chan] = -1;
+            } else {
+                m_held[chan] = 36 + random->bounded(60);
+                m_controller->noteOn(chan, m_held[chan], 40 + random->bounded(88));
+            }
+        } else if (kind < 88) {
+            m_controller->controller(chan, CONTROLS[random->bounded(8)], random->bounded(128));
+        } else if (kind < 99) {
+            m_controller->pitchBend(chan, random->bounded(16384) - 8192);
+        } else {
+            m_controller->program(chan, random->bounded(128));
+        }
+    }
+}
+
+/* the lifecycle paths: stop and start, which makes a new renderer, and
+   every other time unloading and loading the soundfont while running,
+   which the controller does with the audio output stopped */
+void SoakTest::cycle()
+{
+    RenderStats::Values values{};
+    if (m_controller->readRenderStats(values)) {
+        collectCallbacks(values);
+    }
+    m_controller->stop();
+    m_controller->start();
+    m_lastStats = RenderStats::Values{};
+    if (m_settingsCallback) {
+        m_settingsCallback();
+    }
+    if (++m_cycles % 2 == 0 && !m_soundfont.isEmpty()) {
+        m_controller->initSoundfont(QString());
+        m_controller->initSoundfont(m_soundfont);
+    }
+    std::fill(std::begin(m_held), std::end(m_held), -1);
+    playPlaylist();
+}
+
+void SoakTest::collectCallbacks(const RenderStats::Values &values)
+{
+    m_callbacks += values.callbacks - m_lastStats.callbacks;
+    m_callbackNanos += values.callbackNanos - m_lastStats.callbackNanos;
+    for (int i = 0; i < RenderStats::CALLBACK_BUCKETS; ++i) {
+        m_buckets[i] += values.callbackBuckets[i] - m_lastStats.callbackBuckets[i];
+    }
+    m_lastStats = values;
+}
+
+void SoakTest::takeSample()
+{
+    RenderStats::Values values{};
+    if (m_controller->readRenderStats(values)) {
+        collectCallbacks(values);
+    }
+    Sample sample;
+    sample.seconds = m_clock.elapsed() / 1000;
+    sample.rss = residentMemory();
+    sample.heap = heapInUse();
+    sample.files = openFiles();
+    sample.fillPeak = m_fillPeak;
+    sample.meanMicros = m_callbacks > 0 ? m_callbackNanos / 1e3 / m_callbacks : 0.0;
+    sample.p50Micros = RenderStats::callbackPercentile(m_buckets, 0.5);
+    sample.p99Micros = RenderStats::callbackPercentile(m_buckets, 0.99);
+    sample.glitches = m_controller->underruns() + m_controller->stalls();
+    m_samples.append(sample);
+    m_fillPeak = 0;
+    m_callbacks = 0;
+    m_callbackNanos = 0;
+    std::fill(std::begin(m_buckets), std::end(m_buckets), 0);
+
+    fprintf(stdout,
+            "soak %6llds: rss %s, heap %s, files %d, fill peak %d ms, "
+            "callback mean %.1f us p50<=%u us p99<=%u us, glitches %llu, restarts %d\n",
+            (long long) sample.seconds, qPrintable(megabytes(sample.rss)), qPrintable(megabytes(sample.heap)),
+            sample.files, sample.fillPeak, sample.meanMicros, sample.p50Micros, sample.p99Micros,
+            (unsigned long long) sample.glitches, m_cycles);
+    fflush(stdout);
+
+    const QString failure = checkLimits();
+    if (!failure.isEmpty()) {
+        finish(failure);
+    } else if (m_clock.elapsed() >= qint64(m_duration) * 60000) {
+        finish(QString());
+    }
+}
+
+/* memory and files are compared with the highest reference sample, the
+   callback time with the mean of as many samples at each end of the run */
+QString SoakTest::checkLimits() const
+{
+    if (m_samples.size() <= m_warmUpSamples) {
+        return QString();
+    }
+    Sample reference = m_samples.first();
+    double referenceMean = 0.0;
+    for (int i = 0; i < m_warmUpSamples; ++i) {
+        const Sample &s = m_samples.at(i);
+        reference.rss = qMax(reference.rss, s.rss);
+        reference.heap = qMax(reference.heap, s.heap);
+        reference.files = qMax(reference.files, s.files);
+        referenceMean += s.meanMicros / m_warmUpSamples;
+    }
+    const Sample &last = m_samples.last();
+    if (reference.rss >= 0 && last.rss - reference.rss > m_limits.rssMiB * MIB) {
+        return QStringLiteral("resident memory grew by %1").arg(megabytes(last.rss - reference.rss));
+    }
+    if (reference.heap >= 0 && last.heap - reference.heap > m_limits.heapMiB * MIB) {
+        return QStringLiteral("heap grew by %1").arg(megabytes(last.heap - reference.heap));
+    }
+    if (reference.files >= 0 && last.files - reference.files > m_limits.files) {
+        return QStringLiteral("%1 more open files").arg(last.files - reference.files);
+    }
+    if (m_samples.size() >= 2 * m_warmUpSamples && referenceMean > 0.0) {
+        double recentMean = 0.0;
+        for (int i = m_samples.size() - m_warmUpSamples; i < m_samples.size(); ++i) {
+            recentMean += m_samples.at(i).meanMicros / m_warmUpSamples;
+        }
+        const double drift = (recentMean / referenceMean - 1.0) * 100.0;
+        if (drift > m_limits.drift) {
+            return QStringLiteral("mean callback time drifted %1% (%2 us to %3 us)")
+                .arg(drift, 0, 'f', 0).arg(referenceMean, 0, 'f', 1).arg(recentMean, 0, 'f', 1);
+        }
+    }
+    return QString();
+}
+
+void SoakTest::finish(const QString &failure)
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+    m_sampleTimer.stop();
+    m_cycleTimer.stop();
+    m_trafficTimer.stop();
+    m_fillTimer.stop();
+    for (int chan = 0; chan < 16; ++chan) {
+        if (m_held[chan] >= 0) {
+            m_controller->noteOff(chan, m_held[chan], 0);
+            m_held[chan] = -1;
+        }
+    }
+    if (failure.isEmpty()) {
+        fprintf(stdout, "Soak test passed after %lld s\n", (long long) m_clock.elapsed() / 1000);
+    } else {
+        fprintf(stdout, "Soak test FAILED after %lld s: %s\n", (long long) m_clock.elapsed() / 1000,
+                qPrintable(failure));
+    }
+    fflush(stdout);
+    emit finished(failure.isEmpty());
+}
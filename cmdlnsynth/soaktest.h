@@ -0,0 +1,116 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOAKTEST_H
+#define SOAKTEST_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <functional>
+
+#include "renderstats.h"
+
+class SynthController;
+
+/**
+ * Long unattended run of a SynthController: loops a playlist, sends random
+ * live MIDI traffic and periodically stops, restarts and reloads the
+ * soundfont. Memory, open files, output buffer fill and callback times are
+ * sampled along the way, and the run fails as soon as the growth against
+ * the first samples exceeds the limits.
+ */
+class SoakTest : public QObject
+{
+    Q_OBJECT
+public:
+    struct Limits {
+        double rssMiB{32};
+        double heapMiB{16};
+        int files{8};
+        /* growth of the mean callback time, in percent */
+        double drift{50};
+    };
+
+    explicit SoakTest(SynthController *controller, QObject *parent = nullptr);
+
+    void setDuration(int minutes);
+    void setSampleInterval(int seconds);
+    void setCycleInterval(int seconds);
+    void setLimits(const Limits &limits);
+    void setPlaylist(const QStringList &files);
+    void setSoundfont(const QString &soundfont);
+    /* applies the synthesizer settings again after each restart */
+    void setSettingsCallback(std::function<void()> callback);
+
+    void start();
+
+signals:
+    void finished(bool passed);
+
+private:
+    struct Sample {
+        qint64 seconds;
+        qint64 rss;
+        qint64 heap;
+        int files;
+        int fillPeak;
+        double meanMicros;
+        std::uint32_t p50Micros;
+        std::uint32_t p99Micros;
+        quint64 glitches;
+    };
+
+    void takeSample();
+    void cycle();
+    void sendTraffic();
+    void playPlaylist();
+    void collectCallbacks(const RenderStats::Values &values);
+    QString checkLimits() const;
+    void finish(const QString &failure);
+
+private:
+    SynthController *m_controller;
+    std::function<void()> m_settingsCallback;
+    QStringList m_playlist;
+    QString m_soundfont;
+    Limits m_limits;
+    int m_duration{60};
+    int m_sampleInterval{60};
+    int m_cycleInterval{300};
+    int m_cycles{0};
+    int m_fillPeak{0};
+    /* MIDI note held on each channel by the random traffic, or -1 */
+    int m_held[16];
+    QTimer m_sampleTimer;
+    QTimer m_cycleTimer;
+    QTimer m_trafficTimer;
+    QTimer m_fillTimer;
+    QElapsedTimer m_clock;
+    /* callback counters of the current interval, kept across restarts */
+    RenderStats::Values m_lastStats{};
+    std::uint64_t m_callbacks{0};
+    std::uint64_t m_callbackNanos{0};
+    std::uint64_t m_buckets[RenderStats::CALLBACK_BUCKETS]{};
+    QList<Sample> m_samples;
+    int m_warmUpSamples{2};
+    bool m_finished{false};
+};
+
+#endif // SOAKTEST_H
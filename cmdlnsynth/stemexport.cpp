@@ -0,0 +1,138 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "stemexport.h"
+#include "stemrenderer.h"
+#include "wavwriter.h"
+
+StemExport::StemExport(const BounceSettings &settings)
+    : m_settings(settings)
+    , m_directory(QStringLiteral("."))
+    , m_jobs(QThread::idealThreadCount())
+{}
+
+void StemExport::setDirectory(const QString &directory)
+{
+    m_directory = directory;
+}
+
+void StemExport::setJobs(int jobs)
+{
+    m_jobs = qMax(1, jobs);
+}
+
+bool StemExport::exportFile(const QString &fileName)
+{
+    StemRenderer renderer;
+    if (!renderer.open(QFile::encodeName(fileName).constData())) {
+        fprintf(stderr, "Cannot read %s as a Standard MIDI File\n", qPrintable(fileName));
+        return false;
+    }
+    const std::vector<int> channels = renderer.noteChannels();
+    if (channels.empty()) {
+        fprintf(stderr, "%s has no notes\n", qPrintable(fileName));
+        return false;
+    }
+    if (!QDir().mkpath(m_directory)) {
+        fprintf(stderr, "Cannot create the directory %s\n", qPrintable(m_directory));
+        return false;
+    }
+
+    /* the mix first, then one file per channel, numbered from 1 */
+    const QString baseName = QDir(m_directory).filePath(QFileInfo(fileName).completeBaseName());
+    std::vector<std::unique_ptr<WavWriter>> writers;
+    const auto openWriter = [&](const QString &path) {
+        writers.emplace_back(new WavWriter);
+        if (!writers.back()->open(QFile::encodeName(path).constData(),
+                                  renderer.sampleRate(),
+                                  renderer.audioChannels())) {
+            fprintf(stderr, "Cannot create %s\n", qPrintable(path));
+            return false;
+        }
+        return true;
+    };
+    if (!openWriter(baseName + QStringLiteral("-mix.wav"))) {
+        return false;
+    }
+    for (int chan : channels) {
+        if (!openWriter(baseName + QStringLiteral("-ch%1.wav").arg(chan + 1, 2, 10, QLatin1Char('0')))) {
+            return false;
+        }
+    }
+    /* each stem has its own writer, so the workers never share one */
+    WavWriter *byChannel[17] = {nullptr};
+    byChannel[0] = writers[0].get();
+    for (std::size_t i = 0; i < channels.size(); ++i) {
+        byChannel[channels[i] + 1] = writers[i + 1].get();
+    }
+    const StemRenderer::Sink sink = [&byChannel](int channel, const std::int16_t *samples, std::size_t frames) {
+        return byChannel[channel + 1]->write(samples, frames);
+    };
+
+    QElapsedTimer timer;
+    timer.start();
+    bool ok = renderer.render({StemRenderer::MIX}, m_settings, 1, sink);
+    const double mixSeconds = timer.nsecsElapsed() / 1e9;
+    timer.restart();
+    ok = renderer.render(channels, m_settings, m_jobs, sink) && ok;
+    const double stemSeconds = timer.nsecsElapsed() / 1e9;
+    double renderSeconds = 0.0;
+    for (const auto &stem : renderer.stems()) {
+        renderSeconds += stem.seconds;
+    }
+
+    /* the tails differ, so the shorter files get silence at the end */
+    std::uint64_t length = 0;
+    for (const auto &writer : writers) {
+        length = std::max(length, writer->frames());
+    }
+    for (const auto &writer : writers) {
+        const bool padded = writer->writeSilence(length - writer->frames());
+        if (!writer->close() || !padded) {
+            ok = false;
+        }
+    }
+    if (!ok) {
+        fprintf(stderr, "Cannot render or write the stems of %s\n", qPrintable(fileName));
+        return false;
+    }
+
+    fprintf(stdout,
+            "%s: %.1f s of audio\n"
+            "  full mix:  %.3f s\n"
+            "  %zu stems: %.3f s on %d threads (%.3f s of rendering), %.2fx the full mix\n",
+            qPrintable(fileName),
+            double(length) / renderer.sampleRate(),
+            mixSeconds,
+            channels.size(),
+            stemSeconds,
+            qMin<int>(m_jobs, int(channels.size())),
+            renderSeconds,
+            mixSeconds > 0.0 ? stemSeconds / mixSeconds : 0.0);
+    return true;
+}
@@ -0,0 +1,49 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STEMEXPORT_H
+#define STEMEXPORT_H
+
+#include <QString>
+
+#include "songbouncer.h"
+
+/**
+ * Offline export of a MIDI file as one WAVE file per channel, rendered in
+ * parallel by StemRenderer, next to the full mix rendered alone for
+ * reference. All the files of a song are padded to the same length, so
+ * they line up in any editor. The times of both passes are printed.
+ */
+class StemExport
+{
+public:
+    explicit StemExport(const BounceSettings &settings);
+
+    void setDirectory(const QString &directory);
+    /* threads rendering the stems at once */
+    void setJobs(int jobs);
+
+    bool exportFile(const QString &fileName);
+
+private:
+    BounceSettings m_settings;
+    QString m_directory;
+    int m_jobs;
+};
+
+#endif // STEMEXPORT_H
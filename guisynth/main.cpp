@@ -16,6 +16,7 @@
     along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "metadatacache.h"
 #include "programsettings.h"
 #include "mainwindow.h"
 #include <QApplication>
@@ -91,6 +92,11 @@ int main(int argc, char *argv[])
             parser.showHelp(1);
         }
     }
+    MetadataCache::instance()->load();
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, MetadataCache::instance(), [] {
+        MetadataCache::instance()->waitForDone();
+        MetadataCache::instance()->save();
+    });
     MainWindow w;
     if (parser.isSet(listOption)) {
         w.listPorts();
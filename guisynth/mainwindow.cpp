@@ -20,6 +20,7 @@
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QMimeData>
+#include <QScreen>
 
 #include "mainwindow.h"
 #include "programsettings.h"
@@ -67,8 +68,7 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(m_ui->pianoKeybd, SIGNAL(noteOn(int,int)), this, SLOT(noteOn(int,int)));
     connect(m_ui->pianoKeybd, SIGNAL(noteOff(int,int)), this, SLOT(noteOff(int,int)));
     connect(m_ui->combo_sndlib, SIGNAL(currentIndexChanged(int)), this, SLOT(sndLibChanged(int)));
-    connect(m_synth, SIGNAL(midiNoteOn(int, int)), this, SLOT(showNoteOn(int, int)));
-    connect(m_synth, SIGNAL(midiNoteOff(int, int)), this, SLOT(showNoteOff(int, int)));
+    connect(&m_refreshTimer, &QTimer::timeout, this, &MainWindow::refreshKeyboard);
     connect(m_synth, SIGNAL(playbackStopped()), this, SLOT(songStopped()));
     connect(m_synth, &SynthController::underrunDetected, this, &MainWindow::underrunMessage);
     connect(m_synth, &SynthController::stallDetected, this, &MainWindow::stallMessage);
@@ -128,12 +128,15 @@ MainWindow::initializeSynth()
 void
 MainWindow::showEvent(QShowEvent* ev)
 {
+    qreal rate = screen()->refreshRate();
+    m_refreshTimer.start(qRound(1000.0 / (rate > 0 ? rate : 60.0)));
     ev->accept();
 }
 
 void
 MainWindow::closeEvent(QCloseEvent* ev)
 {
+    m_refreshTimer.stop();
     m_synth->stop();
     ProgramSettings::instance()->SaveToNativeStorage();
     ev->accept();
@@ -390,6 +393,29 @@ void MainWindow::showNoteOff(int midiNote, int vel)
     m_ui->pianoKeybd->showNoteOff(midiNote, vel);
 }
 
+void MainWindow::refreshKeyboard()
+{
+    const std::uint32_t serial = m_synth->snapshotSerial();
+    if (serial == m_keySerial) {
+        return;
+    }
+    m_keySerial = serial;
+    SynthSnapshot::State state{};
+    m_synth->readSnapshot(state);
+    /* the keyboard shows a note while any channel holds it */
+    for (int note = 0; note < SynthSnapshot::NUM_KEYS; ++note) {
+        const bool on = state.isNoteOn(note);
+        if (on != m_keyState.isNoteOn(note)) {
+            if (on) {
+                showNoteOn(note, state.noteVelocity(note));
+            } else {
+                showNoteOff(note, 0);
+            }
+        }
+    }
+    m_keyState = state;
+}
+
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
 {
     const QMimeData *mimeData = event->mimeData();
@@ -21,6 +21,7 @@
 
 #include <QMainWindow>
 #include <QFileInfo>
+#include <QTimer>
 #include "synthcontroller.h"
 
 enum PlayerState {
@@ -78,13 +79,17 @@ private slots:
     void noteOff(const int noteNumber, const int velocity);
     void showNoteOn(const int noteNumber, const int velocity);
     void showNoteOff(const int noteNumber, const int velocity);
-    
+    void refreshKeyboard();
+
 private:
     Ui::MainWindow *m_ui;
     SynthController *m_synth;
     QString m_songFile;
     QString m_soundFont;
     PlayerState m_state;
+    QTimer m_refreshTimer;
+    SynthSnapshot::State m_keyState{};
+    std::uint32_t m_keySerial{0};
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,362 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include <alsa/asoundlib.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+
+#include "alsaoutput.h"
+
+const QString AlsaOutput::DEVICE_PREFIX = QStringLiteral("alsa:");
+
+/* shortest period accepted when it is derived from the buffer time */
+static const int MIN_PERIOD_SIZE = 32;
+
+AlsaOutput::AlsaOutput(const QAudioFormat &format, QObject *parent)
+    : QObject(parent)
+    , m_format(format)
+    , m_deviceName(QStringLiteral("default"))
+    , m_requestedPeriodSize(0)
+    , m_requestedPeriodCount(DEFAULT_PERIOD_COUNT)
+    , m_requestedBufferTime(0)
+    , m_pcm(nullptr)
+    , m_mmap(false)
+    , m_periodSize(0)
+    , m_bufferSize(0)
+    , m_source(nullptr)
+    , m_wakeupPipe{-1, -1}
+    , m_running(false)
+    , m_delay(0)
+    , m_underruns(0)
+{}
+
+AlsaOutput::~AlsaOutput()
+{
+    stop();
+}
+
+QStringList AlsaOutput::availableDevices()
+{
+    QStringList result;
+    void **hints = nullptr;
+    if (snd_device_name_hint(-1, "pcm", &hints) < 0) {
+        return result;
+    }
+    for (void **n = hints; *n != nullptr; ++n) {
+        char *name = snd_device_name_get_hint(*n, "NAME");
+        char *ioid = snd_device_name_get_hint(*n, "IOID");
+        if (name != nullptr && (ioid == nullptr || strcmp(ioid, "Output") == 0)) {
+            result << DEVICE_PREFIX + QString::fromLocal8Bit(name);
+        }
+        free(name);
+        free(ioid);
+    }
+    snd_device_name_free_hint(hints);
+    return result;
+}
+
+bool AlsaOutput::isAlsaDevice(const QString &name)
+{
+    return name.startsWith(DEVICE_PREFIX);
+}
+
+QString AlsaOutput::deviceName() const
+{
+    return DEVICE_PREFIX + m_deviceName;
+}
+
+void AlsaOutput::setDeviceName(const QString &name)
+{
+    m_deviceName = isAlsaDevice(name) ? name.mid(DEVICE_PREFIX.length()) : name;
+    if (m_deviceName.isEmpty()) {
+        m_deviceName = QStringLiteral("default");
+    }
+}
+
+void AlsaOutput::setPeriodSize(int frames)
+{
+    m_requestedPeriodSize = frames;
+}
+
+void AlsaOutput::setPeriodCount(int count)
+{
+    m_requestedPeriodCount = count;
+}
+
+void AlsaOutput::setBufferTime(int milliseconds)
+{
+    m_requestedBufferTime = milliseconds;
+}
+
+int AlsaOutput::periodSize() const
+{
+    return m_periodSize;
+}
+
+int AlsaOutput::bufferSize() const
+{
+    return m_bufferSize;
+}
+
+qint64 AlsaOutput::delay() const
+{
+    return m_delay;
+}
+
+quint64 AlsaOutput::underruns() const
+{
+    return m_underruns;
+}
+
+bool AlsaOutput::isRunning() const
+{
+    return m_running;
+}
+
+bool AlsaOutput::openDevice()
+{
+    int err;
+    int dir = 0;
+    snd_pcm_hw_params_t *hw;
+    snd_pcm_sw_params_t *sw;
+    const QByteArray name = m_deviceName.toLocal8Bit();
+
+    err = snd_pcm_open(&m_pcm, name.constData(), SND_PCM_STREAM_PLAYBACK, SND_PCM_NONBLOCK);
+    if (err < 0) {
+        qWarning() << Q_FUNC_INFO << "snd_pcm_open" << m_deviceName << snd_strerror(err);
+        m_pcm = nullptr;
+        return false;
+    }
+
+    snd_pcm_hw_params_alloca(&hw);
+    snd_pcm_hw_params_any(m_pcm, hw);
+    m_mmap = snd_pcm_hw_params_set_access(m_pcm, hw, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (!m_mmap && (err = snd_pcm_hw_params_set_access(m_pcm, hw, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+        qWarning() << Q_FUNC_INFO << "snd_pcm_hw_params_set_access" << snd_strerror(err);
+        closeDevice();
+        return false;
+    }
+    err = snd_pcm_hw_params_set_format(m_pcm, hw, SND_PCM_FORMAT_S16);
+    if (err >= 0) {
+        err = snd_pcm_hw_params_set_channels(m_pcm, hw, m_format.channelCount());
+    }
+    if (err >= 0) {
+        err = snd_pcm_hw_params_set_rate(m_pcm, hw, m_format.sampleRate(), 0);
+    }
+    if (err < 0) {
+        qWarning() << Q_FUNC_INFO << "unsupported audio format" << m_format << snd_strerror(err);
+        closeDevice();
+        return false;
+    }
+
+    unsigned int periods = qMax(2, m_requestedPeriodCount);
+    snd_pcm_uframes_t period = m_requestedPeriodSize;
+    if (period == 0) {
+        const qint64 bufferFrames = qint64(m_format.sampleRate()) * m_requestedBufferTime / 1000;
+        period = qMax<qint64>(MIN_PERIOD_SIZE, bufferFrames / periods);
+    }
+    snd_pcm_hw_params_set_period_size_near(m_pcm, hw, &period, &dir);
+    snd_pcm_hw_params_set_periods_near(m_pcm, hw, &periods, &dir);
+    err = snd_pcm_hw_params(m_pcm, hw);
+    if (err < 0) {
+        qWarning() << Q_FUNC_INFO << "snd_pcm_hw_params" << snd_strerror(err);
+        closeDevice();
+        return false;
+    }
+    snd_pcm_uframes_t buffer = 0;
+    snd_pcm_hw_params_get_period_size(hw, &period, &dir);
+    snd_pcm_hw_params_get_buffer_size(hw, &buffer);
+    m_periodSize = period;
+    m_bufferSize = buffer;
+
+    /* wake up once per period; start as soon as all the whole periods are written */
+    snd_pcm_sw_params_alloca(&sw);
+    snd_pcm_sw_params_current(m_pcm, sw);
+    snd_pcm_sw_params_set_avail_min(m_pcm, sw, period);
+    snd_pcm_sw_params_set_start_threshold(m_pcm, sw, (buffer / period) * period);
+    err = snd_pcm_sw_params(m_pcm, sw);
+    if (err < 0) {
+        qWarning() << Q_FUNC_INFO << "snd_pcm_sw_params" << snd_strerror(err);
+        closeDevice();
+        return false;
+    }
+    if (!m_mmap) {
+        m_writeBuffer.resize(m_format.bytesForFrames(m_periodSize));
+    }
+    //qDebug() << Q_FUNC_INFO << m_deviceName << "mmap:" << m_mmap << "period:" << m_periodSize << "buffer:" << m_bufferSize;
+    return snd_pcm_prepare(m_pcm) == 0;
+}
+
+void AlsaOutput::closeDevice()
+{
+    if (m_pcm != nullptr) {
+        snd_pcm_drop(m_pcm);
+        snd_pcm_close(m_pcm);
+        m_pcm = nullptr;
+    }
+}
+
+bool AlsaOutput::start(QIODevice *source)
+{
+    stop();
+    if (source == nullptr || !openDevice()) {
+        return false;
+    }
+    if (pipe2(m_wakeupPipe, O_CLOEXEC | O_NONBLOCK) < 0) {
+        qWarning() << Q_FUNC_INFO << "pipe2" << strerror(errno);
+        closeDevice();
+        return false;
+    }
+    m_source = source;
+    m_delay = 0;
+    m_running = true;
+    m_thread = std::thread(&AlsaOutput::run, this);
+    return true;
+}
+
+void AlsaOutput::stop()
+{
+    if (m_thread.joinable()) {
+        m_running = false;
+        const char c = 0;
+        if (write(m_wakeupPipe[1], &c, 1) < 0) {
+            qWarning() << Q_FUNC_INFO << "cannot wake up the output thread" << strerror(errno);
+        }
+        m_thread.join();
+    }
+    m_running = false;
+    for (auto &fd : m_wakeupPipe) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    closeDevice();
+    m_source = nullptr;
+}
+
+/* xruns are counted and reported; the next transfers refill the buffer */
+bool AlsaOutput::recover(int err)
+{
+    if (err == -EPIPE) {
+        ++m_underruns;
+        emit underrunDetected();
+    }
+    err = snd_pcm_recover(m_pcm, err, 1);
+    if (err < 0) {
+        qWarning() << Q_FUNC_INFO << "snd_pcm_recover" << snd_strerror(err);
+        return false;
+    }
+    return true;
+}
+
+bool AlsaOutput::transfer(long frames)
+{
+    const int frameBytes = m_format.bytesPerFrame();
+    while (frames > 0) {
+        char *ptr;
+        snd_pcm_uframes_t offset = 0;
+        snd_pcm_uframes_t size = frames;
+        if (m_mmap) {
+            const snd_pcm_channel_area_t *areas;
+            int err = snd_pcm_mmap_begin(m_pcm, &areas, &offset, &size);
+            if (err < 0) {
+                return recover(err);
+            }
+            ptr = static_cast<char *>(areas[0].addr) + (areas[0].first + offset * areas[0].step) / 8;
+        } else {
+            size = qMin<snd_pcm_uframes_t>(size, m_periodSize);
+            ptr = m_writeBuffer.data();
+        }
+        const qint64 bytes = size * frameBytes;
+        const qint64 count = m_source->read(ptr, bytes);
+        if (count < bytes) {
+            memset(ptr + qMax<qint64>(count, 0), 0, bytes - qMax<qint64>(count, 0));
+        }
+        snd_pcm_sframes_t written = m_mmap ? snd_pcm_mmap_commit(m_pcm, offset, size)
+                                           : snd_pcm_writei(m_pcm, ptr, size);
+        if (written == -EAGAIN) {
+            return true;
+        }
+        if (written < 0) {
+            return recover(written);
+        }
+        if (written == 0) {
+            break;
+        }
+        frames -= written;
+    }
+    return true;
+}
+
+void AlsaOutput::run()
+{
+    /* best effort: realtime scheduling needs privileges or rtkit limits */
+    sched_param param{};
+    param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 10;
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0) {
+        //qDebug() << Q_FUNC_INFO << "running without realtime priority";
+    }
+
+    const int count = snd_pcm_poll_descriptors_count(m_pcm);
+    std::vector<pollfd> fds(count + 1);
+    snd_pcm_poll_descriptors(m_pcm, fds.data(), count);
+    fds[count].fd = m_wakeupPipe[0];
+    fds[count].events = POLLIN;
+
+    while (m_running) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(m_pcm);
+        if (avail < 0) {
+            if (!recover(avail)) {
+                break;
+            }
+            continue;
+        }
+        if (avail < m_periodSize) {
+            if (snd_pcm_state(m_pcm) == SND_PCM_STATE_PREPARED) {
+                snd_pcm_start(m_pcm);
+            }
+            if (poll(fds.data(), fds.size(), -1) < 0 && errno != EINTR) {
+                qWarning() << Q_FUNC_INFO << "poll" << strerror(errno);
+                break;
+            }
+            unsigned short revents = 0;
+            snd_pcm_poll_descriptors_revents(m_pcm, fds.data(), count, &revents);
+            if (revents & POLLERR) {
+                if (!recover(snd_pcm_state(m_pcm) == SND_PCM_STATE_XRUN ? -EPIPE : -ESTRPIPE)) {
+                    break;
+                }
+            }
+            continue;
+        }
+        if (!transfer(avail - avail % m_periodSize)) {
+            break;
+        }
+        snd_pcm_sframes_t delay = 0;
+        if (snd_pcm_delay(m_pcm, &delay) == 0) {
+            m_delay = delay;
+        }
+    }
+    m_running = false;
+}
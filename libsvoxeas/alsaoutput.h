@@ -0,0 +1,101 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ALSAOUTPUT_H
+#define ALSAOUTPUT_H
+
+#include <QAudioFormat>
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <thread>
+
+#include "mp_svoxeas_visibility.h"
+
+struct _snd_pcm;
+
+/**
+ * Direct ALSA PCM output, bypassing Qt Multimedia. A dedicated thread
+ * waits on the PCM poll descriptors and pulls one period at a time from
+ * the source device straight into the mmap area of the PCM (or through
+ * snd_pcm_writei when the device does not support mmap access).
+ * Only available on Linux when built with ALSA support.
+ */
+class MP_SVOXEAS_PUBLIC AlsaOutput : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const QString DEVICE_PREFIX;
+    static const int DEFAULT_PERIOD_COUNT = 3;
+
+    explicit AlsaOutput(const QAudioFormat &format, QObject *parent = nullptr);
+    virtual ~AlsaOutput();
+
+    static QStringList availableDevices();
+    static bool isAlsaDevice(const QString &name);
+
+    QString deviceName() const;
+    void setDeviceName(const QString &name);
+    void setPeriodSize(int frames);
+    void setPeriodCount(int count);
+    void setBufferTime(int milliseconds);
+
+    bool start(QIODevice *source);
+    void stop();
+    bool isRunning() const;
+
+    /* actual values negotiated with the device, in frames */
+    int periodSize() const;
+    int bufferSize() const;
+    /* frames written but not yet played, from snd_pcm_delay() */
+    qint64 delay() const;
+    quint64 underruns() const;
+
+signals:
+    void underrunDetected();
+
+private:
+    bool openDevice();
+    void closeDevice();
+    void run();
+    bool transfer(long frames);
+    bool recover(int err);
+
+    QAudioFormat m_format;
+    QString m_deviceName;
+    int m_requestedPeriodSize;
+    int m_requestedPeriodCount;
+    int m_requestedBufferTime;
+
+    struct _snd_pcm *m_pcm;
+    bool m_mmap;
+    long m_periodSize;
+    long m_bufferSize;
+    QByteArray m_writeBuffer;
+    QIODevice *m_source;
+    int m_wakeupPipe[2];
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<qint64> m_delay;
+    std::atomic<quint64> m_underruns;
+};
+
+#endif // ALSAOUTPUT_H
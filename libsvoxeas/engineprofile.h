@@ -0,0 +1,84 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINEPROFILE_H
+#define ENGINEPROFILE_H
+
+#include <cstddef>
+
+/*
+ * Compile-time sizes of the engine storage. The defaults fit the
+ * EAS_Config() of the usual sonivox builds; the static profile sets them
+ * from CMake to the exact values of the target, so that every buffer and
+ * queue is embedded in the objects and nothing is allocated after init.
+ */
+#ifndef SVOXEAS_MAX_BLOCK_FRAMES
+#define SVOXEAS_MAX_BLOCK_FRAMES 1024
+#endif
+#ifndef SVOXEAS_MAX_CHANNELS
+#define SVOXEAS_MAX_CHANNELS 2
+#endif
+#ifndef SVOXEAS_MIDI_QUEUE_SIZE
+#define SVOXEAS_MIDI_QUEUE_SIZE 1024
+#endif
+#ifndef SVOXEAS_META_QUEUE_SIZE
+#define SVOXEAS_META_QUEUE_SIZE 256
+#endif
+#ifndef SVOXEAS_ERROR_QUEUE_SIZE
+#define SVOXEAS_ERROR_QUEUE_SIZE 64
+#endif
+/* MAX_NUMBER_STREAMS of the sonivox build: MIDI streams and files open at once */
+#ifndef SVOXEAS_MAX_STREAMS
+#define SVOXEAS_MAX_STREAMS 4
+#endif
+
+template<std::size_t BlockFrames,
+         std::size_t Channels,
+         std::size_t MidiQueueSize,
+         std::size_t MetaQueueSize,
+         std::size_t ErrorQueueSize,
+         int Streams>
+struct EngineLimits
+{
+    static_assert(BlockFrames > 0 && Channels > 0, "empty engine block");
+
+    static constexpr std::size_t MAX_BLOCK_FRAMES = BlockFrames;
+    static constexpr std::size_t MAX_CHANNELS = Channels;
+    static constexpr std::size_t BLOCK_SAMPLES = BlockFrames * Channels;
+    static constexpr std::size_t MIDI_QUEUE_SIZE = MidiQueueSize;
+    static constexpr std::size_t META_QUEUE_SIZE = MetaQueueSize;
+    static constexpr std::size_t ERROR_QUEUE_SIZE = ErrorQueueSize;
+    static constexpr int MAX_STREAMS = Streams;
+
+    /* whether an EAS_Config() fits in the storage */
+    static constexpr bool fits(long mixBufferSize, long numChannels)
+    {
+        return mixBufferSize > 0 && numChannels > 0 && std::size_t(mixBufferSize) <= BlockFrames
+               && std::size_t(numChannels) <= Channels;
+    }
+};
+
+typedef EngineLimits<SVOXEAS_MAX_BLOCK_FRAMES,
+                     SVOXEAS_MAX_CHANNELS,
+                     SVOXEAS_MIDI_QUEUE_SIZE,
+                     SVOXEAS_META_QUEUE_SIZE,
+                     SVOXEAS_ERROR_QUEUE_SIZE,
+                     SVOXEAS_MAX_STREAMS>
+    EngineProfile;
+
+#endif // ENGINEPROFILE_H
@@ -18,10 +18,7 @@
 
 #include "filewrapper.h"
 #include <cstdio>
-
-FileWrapper::FileWrapper(const QString &path)
-    : FileWrapper(path.toLocal8Bit().data())
-{}
+#include <cstring>
 
 FileWrapper::FileWrapper(const char *path)
     : m_ok{false}
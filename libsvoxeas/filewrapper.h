@@ -19,13 +19,22 @@
 #ifndef FILEWRAPPER_H
 #define FILEWRAPPER_H
 
-#include <QString>
 #include <eas_types.h>
+#if defined(QT_CORE_LIB)
+#include <QString>
+#endif
+
+#include "mp_svoxeas_core_visibility.h"
 
-class FileWrapper
+class MP_SVOXEAS_CORE_PUBLIC FileWrapper
 {
 public:
-    explicit FileWrapper(const QString &path);
+#if defined(QT_CORE_LIB)
+    /* inline, so the core library itself does not depend on Qt */
+    explicit FileWrapper(const QString &path)
+        : FileWrapper(path.toLocal8Bit().constData())
+    {}
+#endif
     explicit FileWrapper(const char *path);
     ~FileWrapper();
     EAS_FILE_LOCATOR getLocator();
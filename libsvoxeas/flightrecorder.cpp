@@ -0,0 +1,157 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "flightrecorder.h"
+
+static_assert((FlightRecorder::CAPACITY & (FlightRecorder::CAPACITY - 1)) == 0,
+              "FlightRecorder capacity must be a power of two");
+
+static std::int64_t steadyNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+FlightRecorder::FlightRecorder()
+    : m_next(0)
+{
+    for (auto &slot : m_slots) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char *FlightRecorder::typeName(int type)
+{
+    switch (type) {
+    case Callback:
+        return "callback";
+    case BufferFill:
+        return "buffer";
+    case FileOpened:
+        return "file-open";
+    case FileClosed:
+        return "file-close";
+    case Parameter:
+        return "parameter";
+    case Underrun:
+        return "underrun";
+    case Stall:
+        return "stall";
+    default:
+        return "unknown";
+    }
+}
+
+/* each slot carries a sequence lock: odd while being written, and
+   2 * (index + 1) once record number index is complete */
+void FlightRecorder::record(Type type, std::int64_t value0, std::int64_t value1, std::int64_t value2)
+{
+    const std::uint64_t index = m_next.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = m_slots[index & (CAPACITY - 1)];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.nanos.store(steadyNanos(), std::memory_order_relaxed);
+    slot.type.store(type, std::memory_order_relaxed);
+    slot.values[0].store(value0, std::memory_order_relaxed);
+    slot.values[1].store(value1, std::memory_order_relaxed);
+    slot.values[2].store(value2, std::memory_order_relaxed);
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+std::size_t FlightRecorder::snapshot(Record *records, std::size_t maxRecords) const
+{
+    const std::uint64_t next = m_next.load(std::memory_order_acquire);
+    const std::uint64_t count = std::min<std::uint64_t>({next, CAPACITY, maxRecords});
+    std::size_t taken = 0;
+    for (std::uint64_t index = next - count; index < next; ++index) {
+        const Slot &slot = m_slots[index & (CAPACITY - 1)];
+        const std::uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != 2 * (index + 1)) {
+            continue;
+        }
+        Record &record = records[taken];
+        record.nanos = slot.nanos.load(std::memory_order_relaxed);
+        record.type = slot.type.load(std::memory_order_relaxed);
+        for (int i = 0; i < 3; ++i) {
+            record.values[i] = slot.values[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            ++taken;
+        }
+    }
+    return taken;
+}
+
+bool FlightRecorder::dump(const char *path, const char *reason) const
+{
+    std::unique_ptr<Record[]> records(new Record[CAPACITY]);
+    const std::size_t count = snapshot(records.get(), CAPACITY);
+    const std::int64_t now = steadyNanos();
+    const std::string temporary = std::string(path) + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "w");
+    if (file == nullptr) {
+        return false;
+    }
+    std::fprintf(file, "# flight record: %s, %zu records\n", reason, count);
+    std::fprintf(file, "# milliseconds before the dump, event, values\n");
+    for (std::size_t i = 0; i < count; ++i) {
+        const Record &record = records[i];
+        std::fprintf(file, "%.3f %s", (record.nanos - now) / 1e6, typeName(record.type));
+        switch (record.type) {
+        case Callback:
+            std::fprintf(file, " frames=%lld render_us=%.1f midi=%lld\n",
+                         (long long) record.values[0], record.values[1] / 1e3,
+                         (long long) record.values[2]);
+            break;
+        case BufferFill:
+            std::fprintf(file, " queued=%lld\n", (long long) record.values[0]);
+            break;
+        case FileOpened:
+            std::fprintf(file, " duration_ms=%lld\n", (long long) record.values[0]);
+            break;
+        case FileClosed:
+            std::fprintf(file, " location_ms=%lld\n", (long long) record.values[0]);
+            break;
+        case Parameter:
+            std::fprintf(file, " id=%lld value=%lld\n",
+                         (long long) record.values[0], (long long) record.values[1]);
+            break;
+        default:
+            std::fputc('\n', file);
+            break;
+        }
+    }
+    const bool written = std::fflush(file) == 0;
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+#if defined(_WIN32)
+    /* rename does not replace existing files on Windows */
+    std::remove(path);
+#endif
+    return std::rename(temporary.c_str(), path) == 0;
+}
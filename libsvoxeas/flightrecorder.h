@@ -0,0 +1,92 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FLIGHTRECORDER_H
+#define FLIGHTRECORDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "mp_svoxeas_tools_visibility.h"
+
+/**
+ * Fixed-size history of the render path, always recording, to be dumped
+ * after a glitch. Any thread appends records without locking; once the
+ * ring is full the oldest ones are overwritten. A dump taken while
+ * writers are active skips the slots being written.
+ */
+class MP_SVOXEAS_TOOLS_PUBLIC FlightRecorder
+{
+public:
+    enum Type {
+        Callback,    // frames requested, render nanoseconds, MIDI events applied
+        BufferFill,  // frames queued in the audio output
+        FileOpened,  // file duration in milliseconds
+        FileClosed,  // playback location in milliseconds
+        Parameter,   // parameter, value
+        Underrun,
+        Stall,
+        TypeCount
+    };
+
+    enum ParameterId {
+        Reverb,
+        ReverbWet,
+        Chorus,
+        ChorusLevel,
+        PlaybackRate, // thousandths of the factor
+        Seek,
+        Volume
+    };
+
+    /* about 20 s of callbacks and buffer fill samples at 10 ms periods */
+    static const std::size_t CAPACITY = 4096;
+
+    struct Record {
+        std::int64_t nanos; // steady clock
+        int type;
+        std::int64_t values[3];
+    };
+
+    FlightRecorder();
+
+    static const char *typeName(int type);
+
+    /* any thread, lock-free */
+    void record(Type type, std::int64_t value0 = 0, std::int64_t value1 = 0, std::int64_t value2 = 0);
+
+    /* copies up to maxRecords of the newest records, oldest first */
+    std::size_t snapshot(Record *records, std::size_t maxRecords) const;
+    /* writes the history as text to a temporary file renamed over path;
+       allocates, so not from the render thread */
+    bool dump(const char *path, const char *reason) const;
+
+private:
+    struct Slot {
+        std::atomic<std::uint64_t> sequence;
+        std::atomic<std::int64_t> nanos;
+        std::atomic<int> type;
+        std::atomic<std::int64_t> values[3];
+    };
+
+    Slot m_slots[CAPACITY];
+    std::atomic<std::uint64_t> m_next;
+};
+
+#endif // FLIGHTRECORDER_H
@@ -0,0 +1,187 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOCKFREERING_H
+#define LOCKFREERING_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Bounded wait-free ring buffer for one producer and one consumer thread.
+ * Storage is embedded in the object, so it never allocates after
+ * construction. Capacity must be a power of two.
+ */
+template<typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing()
+        : m_head{0}
+        , m_tail{0}
+    {}
+
+    /* producer side; returns false when full */
+    bool push(const T &item)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= Capacity) {
+            return false;
+        }
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* consumer side; returns nullptr when empty */
+    const T *front() const
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        return &m_items[head & (Capacity - 1)];
+    }
+
+    /* consumer side; returns false when empty */
+    bool pop(T &item)
+    {
+        const T *p = front();
+        if (p == nullptr) {
+            return false;
+        }
+        item = *p;
+        m_head.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    /* consumer side */
+    void clear()
+    {
+        m_head.store(m_tail.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    std::size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    bool isEmpty() const { return size() == 0; }
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    T m_items[Capacity];
+    alignas(64) std::atomic<std::size_t> m_head;
+    alignas(64) std::atomic<std::size_t> m_tail;
+};
+
+/**
+ * Bounded lock-free queue for many producer threads and one consumer
+ * thread, with embedded storage. Capacity must be a power of two.
+ */
+template<typename T, std::size_t Capacity>
+class MpscRing
+{
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0,
+                  "MpscRing capacity must be a power of two");
+
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+public:
+    MpscRing()
+        : m_enqueue{0}
+        , m_dequeue{0}
+    {
+        for (std::size_t i = 0; i < Capacity; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /* any thread; returns false when full */
+    bool push(const T &item)
+    {
+        Cell *cell;
+        std::size_t pos = m_enqueue.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & (Capacity - 1)];
+            const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const std::ptrdiff_t dif = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+            if (dif == 0) {
+                if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = m_enqueue.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /* consumer side; returns nullptr when empty */
+    const T *front() const
+    {
+        const std::size_t pos = m_dequeue.load(std::memory_order_relaxed);
+        const Cell &cell = m_cells[pos & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return nullptr;
+        }
+        return &cell.data;
+    }
+
+    /* consumer side; returns false when empty */
+    bool pop(T &item)
+    {
+        const T *p = front();
+        if (p == nullptr) {
+            return false;
+        }
+        item = *p;
+        const std::size_t pos = m_dequeue.load(std::memory_order_relaxed);
+        m_cells[pos & (Capacity - 1)].sequence.store(pos + Capacity, std::memory_order_release);
+        m_dequeue.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /* consumer side */
+    void clear()
+    {
+        T item;
+        while (pop(item)) {
+        }
+    }
+
+    bool isEmpty() const { return front() == nullptr; }
+    static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+    Cell m_cells[Capacity];
+    alignas(64) std::atomic<std::size_t> m_enqueue;
+    alignas(64) std::atomic<std::size_t> m_dequeue;
+};
+
+#endif // LOCKFREERING_H
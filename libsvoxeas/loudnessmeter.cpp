@@ -0,0 +1,235 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "loudnessmeter.h"
+
+static const double PI = 3.14159265358979323846;
+static const double ABSOLUTE_GATE = -70.0;
+static const double RELATIVE_GATE = -10.0;
+static const double RANGE_RELATIVE_GATE = -20.0;
+
+/* ITU-R BS.1770-4 Annex 2: the four phases of the 48 tap interpolator */
+static const float TRUE_PEAK_FILTER[4][12] = {
+    {0.0017089843750f, 0.0109863281250f, -0.0196533203125f, 0.0332031250000f,
+     -0.0594482421875f, 0.1373291015625f, 0.9721679687500f, -0.1022949218750f,
+     0.0476074218750f, -0.0266113281250f, 0.0148925781250f, -0.0083007812500f},
+    {-0.0291748046875f, 0.0292968750000f, -0.0517578125000f, 0.0891113281250f,
+     -0.1665039062500f, 0.4650878906250f, 0.7797851562500f, -0.2003173828125f,
+     0.1015625000000f, -0.0582275390625f, 0.0330810546875f, -0.0189208984375f},
+    {-0.0189208984375f, 0.0330810546875f, -0.0582275390625f, 0.1015625000000f,
+     -0.2003173828125f, 0.7797851562500f, 0.4650878906250f, -0.1665039062500f,
+     0.0891113281250f, -0.0517578125000f, 0.0292968750000f, -0.0291748046875f},
+    {-0.0083007812500f, 0.0148925781250f, -0.0266113281250f, 0.0476074218750f,
+     -0.1022949218750f, 0.9721679687500f, 0.1373291015625f, -0.0594482421875f,
+     0.0332031250000f, -0.0196533203125f, 0.0109863281250f, 0.0017089843750f}};
+
+static double loudness(double energy)
+{
+    return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : -HUGE_VAL;
+}
+
+static double decibels(double amplitude)
+{
+    return amplitude > 0.0 ? 20.0 * std::log10(amplitude) : -HUGE_VAL;
+}
+
+/* mean energy of the blocks above the gate, or 0 when there are none */
+static double gatedEnergy(const std::vector<double> &blocks, double gate)
+{
+    double sum = 0.0;
+    std::size_t count = 0;
+    for (double energy : blocks) {
+        if (loudness(energy) > gate) {
+            sum += energy;
+            ++count;
+        }
+    }
+    return count > 0 ? sum / count : 0.0;
+}
+
+LoudnessMeter::LoudnessMeter(int sampleRate, int channels)
+    : m_sampleRate(sampleRate)
+    , m_channels(std::max(1, std::min(channels, int(MAX_CHANNELS))))
+    , m_stepFrames(std::max<std::size_t>(1, std::size_t(sampleRate + 5) / 10))
+{
+    /* the BS.1770 filters, given at 48 kHz, designed again for the actual rate */
+    double f0 = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = std::tan(PI * f0 / sampleRate);
+    const double vh = std::pow(10.0, gain / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m_shelf = {(vh + vb * k / q + k * k) / a0,
+               2.0 * (k * k - vh) / a0,
+               (vh - vb * k / q + k * k) / a0,
+               2.0 * (k * k - 1.0) / a0,
+               (1.0 - k / q + k * k) / a0};
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(PI * f0 / sampleRate);
+    a0 = 1.0 + k / q + k * k;
+    m_highPass = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+    reset();
+}
+
+void LoudnessMeter::reset()
+{
+    m_stepPosition = 0;
+    m_stepEnergy = 0.0;
+    m_stepCount = 0;
+    memset(m_state, 0, sizeof(m_state));
+    memset(m_input, 0, sizeof(m_input));
+    std::fill(std::begin(m_steps), std::end(m_steps), 0.0);
+    m_momentary.clear();
+    m_shortTerm.clear();
+    m_maxMomentary = 0.0;
+    m_maxShortTerm = 0.0;
+    m_samplePeak = 0.0f;
+    m_truePeak = 0.0f;
+}
+
+void LoudnessMeter::process(const std::int16_t *samples, std::size_t frames)
+{
+    const float scale = 1.0f / 32768.0f;
+    while (frames > 0) {
+        /* never across the end of a 100 ms step */
+        const std::size_t count = std::min({frames, CHUNK_FRAMES, m_stepFrames - m_stepPosition});
+        for (int c = 0; c < m_channels; ++c) {
+            float *input = m_input[c] + TRUE_PEAK_TAPS - 1;
+            float peak = 0.0f;
+            for (std::size_t i = 0; i < count; ++i) {
+                input[i] = samples[i * m_channels + c] * scale;
+                peak = std::max(peak, std::fabs(input[i]));
+            }
+            m_samplePeak = std::max(m_samplePeak, peak);
+            m_truePeak = std::max(m_truePeak, truePeakChannel(input, count));
+            /* both channels weigh 1.0 */
+            m_stepEnergy += filterChannel(c, input, count);
+            memmove(m_input[c], m_input[c] + count, (TRUE_PEAK_TAPS - 1) * sizeof(float));
+        }
+        samples += count * m_channels;
+        frames -= count;
+        m_stepPosition += count;
+        if (m_stepPosition == m_stepFrames) {
+            endStep();
+        }
+    }
+}
+
+/* K-weighting of a chunk; returns the sum of the squared output */
+double LoudnessMeter::filterChannel(int channel, const float *input, std::size_t count)
+{
+    double *z = m_state[channel];
+    double energy = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const double x = input[i];
+        const double y = m_shelf.b0 * x + z[0];
+        z[0] = m_shelf.b1 * x - m_shelf.a1 * y + z[1];
+        z[1] = m_shelf.b2 * x - m_shelf.a2 * y;
+        const double w = m_highPass.b0 * y + z[2];
+        z[2] = m_highPass.b1 * y - m_highPass.a1 * w + z[3];
+        z[3] = m_highPass.b2 * y - m_highPass.a2 * w;
+        energy += w * w;
+    }
+    /* a decaying tail would otherwise end in denormals, which are slow */
+    for (int i = 0; i < 4; ++i) {
+        if (std::fabs(z[i]) < 1e-30) {
+            z[i] = 0.0;
+        }
+    }
+    return energy;
+}
+
+/* input is preceded by the history the filter needs; plain loops over
+   contiguous floats, which the compiler vectorizes */
+float LoudnessMeter::truePeakChannel(const float *input, std::size_t count) const
+{
+    float peak = 0.0f;
+    for (int phase = 0; phase < 4; ++phase) {
+        const float *h = TRUE_PEAK_FILTER[phase];
+        for (std::size_t i = 0; i < count; ++i) {
+            float y = 0.0f;
+            for (int k = 0; k < TRUE_PEAK_TAPS; ++k) {
+                y += h[k] * input[i - k];
+            }
+            peak = std::max(peak, std::fabs(y));
+        }
+    }
+    return peak;
+}
+
+void LoudnessMeter::endStep()
+{
+    m_steps[m_stepCount % SHORT_TERM_STEPS] = m_stepEnergy / m_stepFrames;
+    ++m_stepCount;
+    m_stepEnergy = 0.0;
+    m_stepPosition = 0;
+    if (m_stepCount >= std::size_t(MOMENTARY_STEPS)) {
+        double sum = 0.0;
+        for (int i = 1; i <= MOMENTARY_STEPS; ++i) {
+            sum += m_steps[(m_stepCount - i) % SHORT_TERM_STEPS];
+        }
+        const double energy = sum / MOMENTARY_STEPS;
+        m_momentary.push_back(energy);
+        m_maxMomentary = std::max(m_maxMomentary, energy);
+    }
+    if (m_stepCount >= std::size_t(SHORT_TERM_STEPS)) {
+        double sum = 0.0;
+        for (double energy : m_steps) {
+            sum += energy;
+        }
+        const double energy = sum / SHORT_TERM_STEPS;
+        m_shortTerm.push_back(energy);
+        m_maxShortTerm = std::max(m_maxShortTerm, energy);
+    }
+}
+
+LoudnessMeter::Values LoudnessMeter::values() const
+{
+    Values values;
+    /* gated over the 400 ms blocks: absolute, then relative to the result */
+    const double ungated = gatedEnergy(m_momentary, ABSOLUTE_GATE);
+    values.integrated = loudness(gatedEnergy(m_momentary, loudness(ungated) + RELATIVE_GATE));
+
+    /* EBU Tech 3342: spread of the gated short-term loudness, 10th to 95th percentile */
+    const double rangeGate = loudness(gatedEnergy(m_shortTerm, ABSOLUTE_GATE)) + RANGE_RELATIVE_GATE;
+    std::vector<double> levels;
+    for (double energy : m_shortTerm) {
+        const double level = loudness(energy);
+        if (level > ABSOLUTE_GATE && level > rangeGate) {
+            levels.push_back(level);
+        }
+    }
+    values.range = 0.0;
+    if (!levels.empty()) {
+        std::sort(levels.begin(), levels.end());
+        const std::size_t last = levels.size() - 1;
+        values.range = levels[std::size_t(std::lround(0.95 * last))]
+                       - levels[std::size_t(std::lround(0.10 * last))];
+    }
+    values.maxMomentary = loudness(m_maxMomentary);
+    values.maxShortTerm = loudness(m_maxShortTerm);
+    values.samplePeak = decibels(m_samplePeak);
+    values.truePeak = decibels(std::max(m_truePeak, m_samplePeak));
+    return values;
+}
@@ -0,0 +1,92 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mp_svoxeas_tools_visibility.h"
+
+/**
+ * EBU R128 loudness and true peak of 16-bit audio, measured block by
+ * block as it is rendered, so no second pass over the audio is needed.
+ * K-weighting and gating follow ITU-R BS.1770-4; the true peak uses its
+ * 4x oversampling filter. Loudness values are in LUFS and LU, peaks in
+ * dBFS and dBTP; a silent input gives -infinity.
+ */
+class MP_SVOXEAS_TOOLS_PUBLIC LoudnessMeter
+{
+public:
+    static const int MAX_CHANNELS = 2;
+
+    struct Values {
+        double integrated;
+        double range;
+        double maxMomentary;
+        double maxShortTerm;
+        double samplePeak;
+        double truePeak;
+    };
+
+    LoudnessMeter(int sampleRate, int channels);
+
+    void reset();
+    /* interleaved frames; allocates only to keep the gating blocks */
+    void process(const std::int16_t *samples, std::size_t frames);
+    Values values() const;
+
+private:
+    static const std::size_t CHUNK_FRAMES = 1024;
+    static const int TRUE_PEAK_TAPS = 12;
+    /* 100 ms steps: 4 make a momentary block, 30 a short-term one */
+    static const int SHORT_TERM_STEPS = 30;
+    static const int MOMENTARY_STEPS = 4;
+
+    struct Biquad {
+        double b0, b1, b2, a1, a2;
+    };
+
+    double filterChannel(int channel, const float *input, std::size_t count);
+    float truePeakChannel(const float *input, std::size_t count) const;
+    void endStep();
+
+    int m_sampleRate;
+    int m_channels;
+    std::size_t m_stepFrames;
+    std::size_t m_stepPosition;
+    Biquad m_shelf;
+    Biquad m_highPass;
+    /* filter states per channel: two per biquad, transposed direct form II */
+    double m_state[MAX_CHANNELS][4];
+    /* true peak filter history followed by the chunk being measured */
+    float m_input[MAX_CHANNELS][TRUE_PEAK_TAPS - 1 + CHUNK_FRAMES];
+    double m_stepEnergy;
+    double m_steps[SHORT_TERM_STEPS];
+    std::size_t m_stepCount;
+    std::vector<double> m_momentary;
+    std::vector<double> m_shortTerm;
+    double m_maxMomentary;
+    double m_maxShortTerm;
+    float m_samplePeak;
+    float m_truePeak;
+};
+
+#endif // LOUDNESSMETER_H
@@ -0,0 +1,291 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "eas.h"
+#include "filewrapper.h"
+#include "metadatacache.h"
+#include "programsettings.h"
+#include "smfscanner.h"
+
+static const quint32 CACHE_MAGIC = 0x53564d43; // "SVMC"
+static const quint32 CACHE_VERSION = 1;
+
+namespace {
+
+/* one EAS instance per pool thread, used only to measure durations */
+class DurationParser
+{
+public:
+    DurationParser()
+        : m_easData(nullptr)
+    {
+        if (EAS_Init(&m_easData) != EAS_SUCCESS) {
+            m_easData = nullptr;
+            return;
+        }
+        const char *name = EAS_GetDefaultSoundLibrary(
+            (E_EAS_SNDLIB_TYPE) ProgramSettings::DEFAULT_SOUND_LIB);
+        if (name != nullptr) {
+            EAS_SetSoundLibrary(m_easData, nullptr, EAS_GetSoundLibrary(m_easData, name));
+        }
+    }
+
+    ~DurationParser()
+    {
+        if (m_easData != nullptr) {
+            EAS_Shutdown(m_easData);
+        }
+    }
+
+    int duration(const QString &path)
+    {
+        EAS_HANDLE handle = nullptr;
+        EAS_I32 playTime = -1;
+        if (m_easData == nullptr) {
+            return -1;
+        }
+        FileWrapper file(path);
+        if (!file.ok() || EAS_OpenFile(m_easData, file.getLocator(), &handle) != EAS_SUCCESS) {
+            return -1;
+        }
+        if (EAS_Prepare(m_easData, handle) != EAS_SUCCESS
+            || EAS_ParseMetaData(m_easData, handle, &playTime) != EAS_SUCCESS) {
+            playTime = -1;
+        }
+        EAS_CloseFile(m_easData, handle);
+        return playTime;
+    }
+
+private:
+    EAS_DATA_HANDLE m_easData;
+};
+
+} // namespace
+
+static QDataStream &operator<<(QDataStream &out, const MidiFileInfo &info)
+{
+    out << info.path << info.size << info.modified << qint32(info.duration)
+        << qint32(info.tracks) << info.lyrics << info.hash;
+    return out;
+}
+
+static QDataStream &operator>>(QDataStream &in, MidiFileInfo &info)
+{
+    qint32 duration, tracks;
+    in >> info.path >> info.size >> info.modified >> duration >> tracks >> info.lyrics >> info.hash;
+    info.duration = duration;
+    info.tracks = tracks;
+    return in;
+}
+
+bool MidiFileInfo::isValid() const
+{
+    return size >= 0 && duration >= 0;
+}
+
+MetadataCache::MetadataCache(QObject *parent)
+    : QObject(parent)
+    , m_pending(0)
+    , m_dirty(false)
+{}
+
+MetadataCache *MetadataCache::instance()
+{
+    static MetadataCache inst;
+    return &inst;
+}
+
+MidiFileInfo MetadataCache::parseFile(const QString &path)
+{
+    static thread_local DurationParser parser;
+    MidiFileInfo info;
+    QFileInfo fi(path);
+    info.path = fi.absoluteFilePath();
+    QFile file(info.path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return info;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+    info.size = fi.size();
+    info.modified = fi.lastModified().toMSecsSinceEpoch();
+    info.hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+    SmfScanner smf;
+    if (smf.open(reinterpret_cast<const std::uint8_t *>(data.constData()), data.size())) {
+        info.tracks = smf.tracks();
+        info.lyrics = smf.hasLyrics();
+    }
+    info.duration = parser.duration(info.path);
+    return info;
+}
+
+void MetadataCache::insert(const MidiFileInfo &info)
+{
+    QWriteLocker locker(&m_lock);
+    m_entries.insert(info.path, info);
+    m_dirty = true;
+}
+
+bool MetadataCache::lookup(const QString &path, MidiFileInfo &info) const
+{
+    QFileInfo fi(path);
+    const QString key = fi.absoluteFilePath();
+    QReadLocker locker(&m_lock);
+    auto it = m_entries.constFind(key);
+    if (it == m_entries.constEnd() || !it->isValid() || it->size != fi.size()
+        || it->modified != fi.lastModified().toMSecsSinceEpoch()) {
+        return false;
+    }
+    info = *it;
+    return true;
+}
+
+MidiFileInfo MetadataCache::scanFile(const QString &path)
+{
+    MidiFileInfo info;
+    if (!lookup(path, info)) {
+        info = parseFile(path);
+        if (info.isValid()) {
+            insert(info);
+        }
+    }
+    return info;
+}
+
+void MetadataCache::scan(const QStringList &paths)
+{
+    foreach (const auto &path, paths) {
+        MidiFileInfo info;
+        if (lookup(path, info)) {
+            emit fileScanned(info.path);
+            continue;
+        }
+        m_pending.ref();
+        m_pool.start(QRunnable::create([this, path] {
+            MidiFileInfo info = parseFile(path);
+            if (info.isValid()) {
+                insert(info);
+            }
+            QMetaObject::invokeMethod(this, [this, info] {
+                emit fileScanned(info.path);
+                if (!m_pending.deref()) {
+                    emit scanFinished();
+                }
+            }, Qt::QueuedConnection);
+        }));
+    }
+    if (m_pending.loadAcquire() == 0) {
+        emit scanFinished();
+    }
+}
+
+bool MetadataCache::isScanning() const
+{
+    return m_pending.loadAcquire() > 0;
+}
+
+void MetadataCache::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+void MetadataCache::setMaxThreadCount(int count)
+{
+    m_pool.setMaxThreadCount(count);
+}
+
+QString MetadataCache::defaultCacheFile() const
+{
+    return QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+        .filePath(QStringLiteral("midimetadata.cache"));
+}
+
+bool MetadataCache::load(const QString &fileName)
+{
+    QFile file(fileName.isEmpty() ? defaultCacheFile() : fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic, version, count;
+    in >> magic >> version >> count;
+    if (magic != CACHE_MAGIC || version != CACHE_VERSION) {
+        qWarning() << Q_FUNC_INFO << "ignoring incompatible cache" << file.fileName();
+        return false;
+    }
+    QHash<QString, MidiFileInfo> entries;
+    entries.reserve(qMin<quint32>(count, 1u << 20));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        MidiFileInfo info;
+        in >> info;
+        entries.insert(info.path, info);
+    }
+    if (in.status() != QDataStream::Ok) {
+        qWarning() << Q_FUNC_INFO << "corrupted cache" << file.fileName();
+        return false;
+    }
+    QWriteLocker locker(&m_lock);
+    m_entries.swap(entries);
+    m_dirty = false;
+    return true;
+}
+
+bool MetadataCache::save(const QString &fileName)
+{
+    const QString path = fileName.isEmpty() ? defaultCacheFile() : fileName;
+    QReadLocker locker(&m_lock);
+    if (!m_dirty && fileName.isEmpty()) {
+        return true;
+    }
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << Q_FUNC_INFO << "cannot write" << path;
+        return false;
+    }
+    QDataStream out(&file);
+    out << CACHE_MAGIC << CACHE_VERSION << quint32(m_entries.size());
+    foreach (const auto &info, m_entries) {
+        out << info;
+    }
+    if (!file.commit()) {
+        return false;
+    }
+    locker.unlock();
+    QWriteLocker writer(&m_lock);
+    m_dirty = false;
+    return true;
+}
+
+void MetadataCache::clear()
+{
+    QWriteLocker locker(&m_lock);
+    m_entries.clear();
+    m_dirty = true;
+}
@@ -0,0 +1,84 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef METADATACACHE_H
+#define METADATACACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+#include "mp_svoxeas_visibility.h"
+
+struct MP_SVOXEAS_PUBLIC MidiFileInfo
+{
+    QString path;
+    qint64 size{-1};
+    qint64 modified{0};
+    int duration{-1};
+    int tracks{0};
+    bool lyrics{false};
+    QByteArray hash;
+
+    bool isValid() const;
+};
+
+/**
+ * Persistent cache of MIDI file metadata, keyed by path, size and
+ * modification time. Files can be scanned in parallel on a thread pool.
+ */
+class MP_SVOXEAS_PUBLIC MetadataCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MetadataCache *instance();
+
+    bool lookup(const QString &path, MidiFileInfo &info) const;
+    MidiFileInfo scanFile(const QString &path);
+    void scan(const QStringList &paths);
+    bool isScanning() const;
+    void waitForDone();
+    void setMaxThreadCount(int count);
+
+    bool load(const QString &fileName = QString());
+    bool save(const QString &fileName = QString());
+    void clear();
+    QString defaultCacheFile() const;
+
+signals:
+    void fileScanned(const QString &path);
+    void scanFinished();
+
+private:
+    explicit MetadataCache(QObject *parent = nullptr);
+    static MidiFileInfo parseFile(const QString &path);
+    void insert(const MidiFileInfo &info);
+
+    mutable QReadWriteLock m_lock;
+    QHash<QString, MidiFileInfo> m_entries;
+    QThreadPool m_pool;
+    QAtomicInt m_pending;
+    bool m_dirty;
+};
+
+#endif // METADATACACHE_H
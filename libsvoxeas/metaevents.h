@@ -0,0 +1,44 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef METAEVENTS_H
+#define METAEVENTS_H
+
+#include <cstdint>
+
+#include "engineprofile.h"
+#include "lockfreering.h"
+
+/**
+ * File metadata event (lyric, text, marker, tempo...) stamped with the
+ * position in the rendered sample stream where it became effective.
+ */
+struct MetaEvent
+{
+    enum Type { Unknown, Title, Author, Copyright, Lyric, Text, Marker, Tempo };
+    static const int MAX_TEXT = 128;
+
+    std::int64_t frame;
+    int type;
+    int value; // microseconds per quarter note, for Tempo events
+    char text[MAX_TEXT];
+};
+
+typedef SpscRing<MetaEvent, EngineProfile::META_QUEUE_SIZE> MetaEventQueue;
+
+#endif // METAEVENTS_H
@@ -0,0 +1,284 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+#include <cstring>
+
+#include "midicapture.h"
+
+static const char CAPTURE_MAGIC[4] = {'S', 'V', 'C', 'P'};
+
+static std::int64_t steadyNanos()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/* records from different threads may arrive slightly out of order, so the
+   deltas are signed, zigzag encoded */
+static void writeVarint(std::FILE *file, std::int64_t value)
+{
+    std::uint64_t v = (std::uint64_t(value) << 1) ^ std::uint64_t(value >> 63);
+    while (v >= 0x80) {
+        std::fputc(int((v & 0x7f) | 0x80), file);
+        v >>= 7;
+    }
+    std::fputc(int(v), file);
+}
+
+static bool readVarint(std::FILE *file, std::int64_t &value)
+{
+    std::uint64_t v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int c = std::fgetc(file);
+        if (c == EOF) {
+            return false;
+        }
+        v |= std::uint64_t(c & 0x7f) << shift;
+        if ((c & 0x80) == 0) {
+            value = std::int64_t(v >> 1) ^ -std::int64_t(v & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void writeU32(std::FILE *file, std::uint32_t value)
+{
+    const unsigned char bytes[4] = {static_cast<unsigned char>(value),
+                                    static_cast<unsigned char>(value >> 8),
+                                    static_cast<unsigned char>(value >> 16),
+                                    static_cast<unsigned char>(value >> 24)};
+    std::fwrite(bytes, 1, sizeof(bytes), file);
+}
+
+static bool readU32(std::FILE *file, std::uint32_t &value)
+{
+    unsigned char bytes[4];
+    if (std::fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) {
+        return false;
+    }
+    value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | (std::uint32_t(bytes[3]) << 24);
+    return true;
+}
+
+MidiCapture::MidiCapture()
+    : m_file(nullptr)
+    , m_active(false)
+    , m_origin(0)
+    , m_lastNanos(0)
+    , m_lastFrame(0)
+    , m_records(0)
+    , m_dropped(0)
+{}
+
+MidiCapture::~MidiCapture()
+{
+    close();
+}
+
+bool MidiCapture::open(const char *path, const Header &header)
+{
+    close();
+    m_file = std::fopen(path, "wb");
+    if (m_file == nullptr) {
+        return false;
+    }
+    std::fwrite(CAPTURE_MAGIC, 1, sizeof(CAPTURE_MAGIC), m_file);
+    writeU32(m_file, FORMAT_VERSION);
+    writeU32(m_file, header.sampleRate);
+    writeU32(m_file, header.channels);
+    writeU32(m_file, header.blockFrames);
+    m_queue.clear();
+    m_lastNanos = 0;
+    m_lastFrame = 0;
+    m_records = 0;
+    m_dropped = 0;
+    m_origin = steadyNanos();
+    m_active = true;
+    return true;
+}
+
+void MidiCapture::close()
+{
+    if (m_file == nullptr) {
+        return;
+    }
+    m_active = false;
+    flush();
+    std::fclose(m_file);
+    m_file = nullptr;
+}
+
+bool MidiCapture::isActive() const
+{
+    return m_active;
+}
+
+void MidiCapture::recordMidi(std::int64_t frame, const std::uint8_t *data, std::size_t length)
+{
+    if (!m_active.load(std::memory_order_relaxed) || length == 0
+        || length > MidiMessage::MAX_LENGTH) {
+        return;
+    }
+    CaptureRecord record;
+    record.type = CaptureRecord::Midi;
+    record.frame = frame;
+    record.value = 0;
+    record.length = std::uint8_t(length);
+    std::memcpy(record.data, data, length);
+    push(record);
+}
+
+void MidiCapture::record(CaptureRecord::Type type, std::int64_t frame, std::int32_t value)
+{
+    if (!m_active.load(std::memory_order_relaxed)) {
+        return;
+    }
+    CaptureRecord record;
+    record.type = type;
+    record.frame = frame;
+    record.value = value;
+    record.length = 0;
+    push(record);
+}
+
+void MidiCapture::push(CaptureRecord &record)
+{
+    record.nanos = steadyNanos() - m_origin.load(std::memory_order_relaxed);
+    if (!m_queue.push(record)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void MidiCapture::writeRecord(const CaptureRecord &record)
+{
+    std::fputc(record.type, m_file);
+    writeVarint(m_file, record.nanos - m_lastNanos);
+    writeVarint(m_file, record.frame - m_lastFrame);
+    if (record.type == CaptureRecord::Midi) {
+        std::fputc(record.length, m_file);
+        std::fwrite(record.data, 1, record.length, m_file);
+    } else {
+        writeVarint(m_file, record.value);
+    }
+    m_lastNanos = record.nanos;
+    m_lastFrame = record.frame;
+}
+
+bool MidiCapture::flush()
+{
+    if (m_file == nullptr) {
+        return false;
+    }
+    CaptureRecord record;
+    while (m_queue.pop(record)) {
+        writeRecord(record);
+        m_records.fetch_add(1, std::memory_order_relaxed);
+    }
+    return std::fflush(m_file) == 0;
+}
+
+std::uint64_t MidiCapture::records() const
+{
+    return m_records.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MidiCapture::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+MidiCaptureReader::MidiCaptureReader()
+    : m_file(nullptr)
+    , m_header{}
+    , m_lastNanos(0)
+    , m_lastFrame(0)
+{}
+
+MidiCaptureReader::~MidiCaptureReader()
+{
+    close();
+}
+
+bool MidiCaptureReader::open(const char *path)
+{
+    close();
+    m_file = std::fopen(path, "rb");
+    if (m_file == nullptr) {
+        return false;
+    }
+    char magic[sizeof(CAPTURE_MAGIC)];
+    std::uint32_t version;
+    if (std::fread(magic, 1, sizeof(magic), m_file) != sizeof(magic)
+        || std::memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) != 0
+        || !readU32(m_file, version) || version != MidiCapture::FORMAT_VERSION
+        || !readU32(m_file, m_header.sampleRate) || !readU32(m_file, m_header.channels)
+        || !readU32(m_file, m_header.blockFrames)) {
+        close();
+        return false;
+    }
+    m_lastNanos = 0;
+    m_lastFrame = 0;
+    return true;
+}
+
+void MidiCaptureReader::close()
+{
+    if (m_file != nullptr) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+const MidiCapture::Header &MidiCaptureReader::header() const
+{
+    return m_header;
+}
+
+bool MidiCaptureReader::next(CaptureRecord &record)
+{
+    if (m_file == nullptr) {
+        return false;
+    }
+    const int type = std::fgetc(m_file);
+    std::int64_t nanos, frame, value = 0;
+    if (type == EOF || type >= CaptureRecord::TypeCount || !readVarint(m_file, nanos)
+        || !readVarint(m_file, frame)) {
+        return false;
+    }
+    record.type = std::uint8_t(type);
+    record.length = 0;
+    if (type == CaptureRecord::Midi) {
+        const int length = std::fgetc(m_file);
+        if (length <= 0 || length > MidiMessage::MAX_LENGTH
+            || std::fread(record.data, 1, length, m_file) != std::size_t(length)) {
+            return false;
+        }
+        record.length = std::uint8_t(length);
+    } else if (!readVarint(m_file, value)) {
+        return false;
+    }
+    m_lastNanos += nanos;
+    m_lastFrame += frame;
+    record.nanos = m_lastNanos;
+    record.frame = m_lastFrame;
+    record.value = std::int32_t(value);
+    return true;
+}
@@ -0,0 +1,128 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MIDICAPTURE_H
+#define MIDICAPTURE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+
+#include "engineprofile.h"
+#include "lockfreering.h"
+#include "midiparser.h"
+#include "mp_svoxeas_tools_visibility.h"
+
+/**
+ * One captured call. nanos counts from the start of the capture; frame is
+ * the output position of the renderer when the call was made. The other
+ * records keep their argument in value: frames requested for Render,
+ * milliseconds for Seek and thousandths of the factor for PlaybackRate.
+ */
+struct CaptureRecord {
+    enum Type : std::uint8_t {
+        Midi,
+        Render,
+        Reverb,
+        ReverbWet,
+        Chorus,
+        ChorusLevel,
+        PlaybackRate,
+        Seek,
+        TypeCount
+    };
+
+    std::int64_t nanos;
+    std::int64_t frame;
+    std::int32_t value;
+    std::uint8_t type;
+    std::uint8_t length;
+    std::uint8_t data[MidiMessage::MAX_LENGTH];
+};
+
+/**
+ * Capture of the live input and parameter calls of a renderer, to replay
+ * an incident later. Any thread records into a lock-free queue without
+ * blocking; a non real-time thread writes the queue to the log with
+ * flush(). The log has a small header followed by records delta encoded
+ * with variable length integers.
+ */
+class MP_SVOXEAS_TOOLS_PUBLIC MidiCapture
+{
+public:
+    static const std::uint32_t FORMAT_VERSION = 1;
+
+    struct Header {
+        std::uint32_t sampleRate;
+        std::uint32_t channels;
+        std::uint32_t blockFrames;
+    };
+
+    MidiCapture();
+    ~MidiCapture();
+
+    bool open(const char *path, const Header &header);
+    void close();
+    bool isActive() const;
+
+    /* any thread, lock-free; ignored while not active */
+    void recordMidi(std::int64_t frame, const std::uint8_t *data, std::size_t length);
+    void record(CaptureRecord::Type type, std::int64_t frame, std::int32_t value);
+
+    /* writer thread: moves the queued records to the file */
+    bool flush();
+    std::uint64_t records() const;
+    std::uint64_t dropped() const;
+
+private:
+    void push(CaptureRecord &record);
+    void writeRecord(const CaptureRecord &record);
+
+    std::FILE *m_file;
+    std::atomic<bool> m_active;
+    std::atomic<std::int64_t> m_origin;
+    std::int64_t m_lastNanos;
+    std::int64_t m_lastFrame;
+    std::atomic<std::uint64_t> m_records;
+    std::atomic<std::uint64_t> m_dropped;
+    MpscRing<CaptureRecord, EngineProfile::MIDI_QUEUE_SIZE> m_queue;
+};
+
+/**
+ * Reads back a log written by MidiCapture.
+ */
+class MP_SVOXEAS_TOOLS_PUBLIC MidiCaptureReader
+{
+public:
+    MidiCaptureReader();
+    ~MidiCaptureReader();
+
+    bool open(const char *path);
+    void close();
+    const MidiCapture::Header &header() const;
+    /* returns false at the end of the log, or when it is truncated */
+    bool next(CaptureRecord &record);
+
+private:
+    std::FILE *m_file;
+    MidiCapture::Header m_header;
+    std::int64_t m_lastNanos;
+    std::int64_t m_lastFrame;
+};
+
+#endif // MIDICAPTURE_H
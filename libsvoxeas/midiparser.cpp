@@ -0,0 +1,115 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <utility>
+
+#include "midiparser.h"
+
+MidiParser::MidiParser(Callback callback)
+    : m_callback(std::move(callback))
+{
+    reset();
+}
+
+void MidiParser::setCallback(Callback callback)
+{
+    m_callback = std::move(callback);
+}
+
+void MidiParser::reset()
+{
+    m_message.length = 0;
+    m_runningStatus = 0;
+    m_expected = 0;
+    m_sysex = false;
+    m_overflow = false;
+}
+
+void MidiParser::deliver()
+{
+    /* system common messages are consumed but not useful to the synth */
+    if (m_callback && m_message.length > 0 && (m_message.data[0] < 0xf1 || m_message.data[0] == 0xf7)) {
+        m_callback(m_message);
+    }
+    m_message.length = 0;
+}
+
+void MidiParser::parse(const std::uint8_t *data, std::size_t length)
+{
+    for (std::size_t i = 0; i < length; ++i) {
+        const std::uint8_t c = data[i];
+        if (c >= 0xf8) {
+            /* real time messages may appear anywhere; clock and sensing are ignored */
+            continue;
+        }
+        if (c == 0xf0) {
+            m_sysex = true;
+            m_overflow = false;
+            m_runningStatus = 0;
+            m_message.length = 1;
+            m_message.data[0] = c;
+            continue;
+        }
+        if (c == 0xf7) {
+            if (m_sysex && !m_overflow && m_message.length < MidiMessage::MAX_LENGTH) {
+                m_message.data[m_message.length++] = c;
+                deliver();
+            }
+            m_message.length = 0;
+            m_sysex = false;
+            continue;
+        }
+        if (c & 0x80) {
+            /* any other status byte aborts an unterminated SysEx */
+            m_sysex = false;
+            m_message.length = 1;
+            m_message.data[0] = c;
+            if (c < 0xf0) {
+                m_runningStatus = c;
+                m_expected = ((c & 0xf0) == 0xc0 || (c & 0xf0) == 0xd0) ? 1 : 2;
+            } else {
+                m_runningStatus = 0;
+                m_expected = (c == 0xf2) ? 2 : (c == 0xf1 || c == 0xf3) ? 1 : 0;
+                if (m_expected == 0) {
+                    deliver();
+                }
+            }
+            continue;
+        }
+        /* data bytes */
+        if (m_sysex) {
+            if (m_message.length < MidiMessage::MAX_LENGTH) {
+                m_message.data[m_message.length++] = c;
+            } else {
+                m_overflow = true;
+            }
+            continue;
+        }
+        if (m_message.length == 0) {
+            if (m_runningStatus == 0) {
+                continue;
+            }
+            m_message.data[0] = m_runningStatus;
+            m_message.length = 1;
+        }
+        m_message.data[m_message.length++] = c;
+        if (m_message.length > m_expected) {
+            deliver();
+        }
+    }
+}
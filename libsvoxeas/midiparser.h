@@ -0,0 +1,77 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MIDIPARSER_H
+#define MIDIPARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+#include "engineprofile.h"
+#include "lockfreering.h"
+#include "mp_svoxeas_core_visibility.h"
+
+/**
+ * A complete MIDI message, small enough to travel through a lock-free queue.
+ * SysEx messages longer than MAX_LENGTH are discarded by the parser.
+ */
+struct MidiMessage
+{
+    static const int MAX_LENGTH = 32;
+
+    std::uint8_t length;
+    std::uint8_t data[MAX_LENGTH];
+};
+
+/* a message due at an engine output frame; -1 means as soon as possible */
+struct MidiEvent
+{
+    std::int64_t frame;
+    MidiMessage message;
+};
+
+typedef MpscRing<MidiEvent, EngineProfile::MIDI_QUEUE_SIZE> MidiEventQueue;
+
+/**
+ * Converts a raw MIDI byte stream into complete messages, handling running
+ * status, interleaved real time bytes and SysEx.
+ */
+class MP_SVOXEAS_CORE_PUBLIC MidiParser
+{
+public:
+    typedef std::function<void(const MidiMessage &)> Callback;
+
+    explicit MidiParser(Callback callback = Callback());
+
+    void setCallback(Callback callback);
+    void parse(const std::uint8_t *data, std::size_t length);
+    void reset();
+
+private:
+    void deliver();
+
+    Callback m_callback;
+    MidiMessage m_message;
+    std::uint8_t m_runningStatus;
+    int m_expected;
+    bool m_sysex;
+    bool m_overflow;
+};
+
+#endif // MIDIPARSER_H
@@ -0,0 +1,140 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QByteArray>
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+
+#include "nulloutput.h"
+
+const QString NullOutput::DEVICE_NAME = QStringLiteral("null");
+
+/* shortest period accepted when it is derived from the buffer time */
+static const int MIN_PERIOD_SIZE = 32;
+
+NullOutput::NullOutput(const QAudioFormat &format, QObject *parent)
+    : QObject(parent)
+    , m_format(format)
+    , m_requestedPeriodSize(0)
+    , m_requestedBufferTime(100)
+    , m_periodSize(0)
+    , m_bufferSize(0)
+    , m_source(nullptr)
+    , m_running(false)
+    , m_delay(0)
+    , m_underruns(0)
+{}
+
+NullOutput::~NullOutput()
+{
+    stop();
+}
+
+void NullOutput::setPeriodSize(int frames)
+{
+    m_requestedPeriodSize = frames;
+}
+
+void NullOutput::setBufferTime(int milliseconds)
+{
+    m_requestedBufferTime = milliseconds;
+}
+
+bool NullOutput::start(QIODevice *source)
+{
+    stop();
+    if (source == nullptr || m_format.sampleRate() <= 0) {
+        return false;
+    }
+    m_bufferSize = qMax(MIN_PERIOD_SIZE, m_format.sampleRate() * m_requestedBufferTime / 1000);
+    m_periodSize = m_requestedPeriodSize > 0 ? m_requestedPeriodSize
+                                             : qMax(MIN_PERIOD_SIZE, m_bufferSize / DEFAULT_PERIOD_COUNT);
+    m_bufferSize = qMax(m_bufferSize, m_periodSize);
+    //qDebug() << Q_FUNC_INFO << "period:" << m_periodSize << "buffer:" << m_bufferSize;
+    m_source = source;
+    m_delay = 0;
+    m_running = true;
+    m_thread = std::thread(&NullOutput::run, this);
+    return true;
+}
+
+void NullOutput::stop()
+{
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    m_source = nullptr;
+}
+
+bool NullOutput::isRunning() const
+{
+    return m_running;
+}
+
+int NullOutput::periodSize() const
+{
+    return m_periodSize;
+}
+
+int NullOutput::bufferSize() const
+{
+    return m_bufferSize;
+}
+
+qint64 NullOutput::delay() const
+{
+    return m_delay;
+}
+
+quint64 NullOutput::underruns() const
+{
+    return m_underruns;
+}
+
+/* the buffer is topped up every period; when the wall clock gets ahead of
+   the frames pulled, a device would have played silence: an underrun */
+void NullOutput::run()
+{
+    using namespace std::chrono;
+    QByteArray buffer(m_format.bytesForFrames(m_periodSize), 0);
+    const nanoseconds period(qint64(m_periodSize) * 1000000000 / m_format.sampleRate());
+    const auto startTime = steady_clock::now();
+    auto wakeup = startTime;
+    qint64 written = 0;
+    while (m_running) {
+        /* split, so that months of nanoseconds times the rate do not overflow */
+        const qint64 elapsed = duration_cast<nanoseconds>(steady_clock::now() - startTime).count();
+        const qint64 played = elapsed / 1000000000 * m_format.sampleRate()
+                              + elapsed % 1000000000 * m_format.sampleRate() / 1000000000;
+        if (written < played) {
+            ++m_underruns;
+            emit underrunDetected();
+            written = played;
+        }
+        while (m_running && written + m_periodSize <= played + m_bufferSize) {
+            m_source->read(buffer.data(), buffer.size());
+            written += m_periodSize;
+        }
+        m_delay = written - played;
+        /* after a long preemption, keep the pace from now instead of catching up */
+        wakeup = std::max(wakeup + period, steady_clock::now());
+        std::this_thread::sleep_until(wakeup);
+    }
+}
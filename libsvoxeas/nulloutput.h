@@ -0,0 +1,81 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NULLOUTPUT_H
+#define NULLOUTPUT_H
+
+#include <QAudioFormat>
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <thread>
+
+#include "mp_svoxeas_visibility.h"
+
+/**
+ * Audio output that discards the samples. A dedicated thread pulls one
+ * period at a time from the source at the pace of a real device with the
+ * same buffer, so the render path, the stall detector and the latency
+ * figures behave as with a sound card. For long unattended runs and
+ * machines without audio hardware.
+ */
+class MP_SVOXEAS_PUBLIC NullOutput : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const QString DEVICE_NAME;
+    static const int DEFAULT_PERIOD_COUNT = 3;
+
+    explicit NullOutput(const QAudioFormat &format, QObject *parent = nullptr);
+    virtual ~NullOutput();
+
+    void setPeriodSize(int frames);
+    void setBufferTime(int milliseconds);
+
+    bool start(QIODevice *source);
+    void stop();
+    bool isRunning() const;
+
+    /* in frames */
+    int periodSize() const;
+    int bufferSize() const;
+    /* frames pulled but not yet "played" by the wall clock */
+    qint64 delay() const;
+    quint64 underruns() const;
+
+signals:
+    void underrunDetected();
+
+private:
+    void run();
+
+    QAudioFormat m_format;
+    int m_requestedPeriodSize;
+    int m_requestedBufferTime;
+    int m_periodSize;
+    int m_bufferSize;
+    QIODevice *m_source;
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<qint64> m_delay;
+    std::atomic<quint64> m_underruns;
+};
+
+#endif // NULLOUTPUT_H
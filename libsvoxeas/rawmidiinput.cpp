@@ -0,0 +1,136 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "rawmidiinput.h"
+
+RawMidiInput::RawMidiInput(QObject *parent)
+    : QObject(parent)
+    , m_fd(-1)
+    , m_notifier(nullptr)
+{}
+
+RawMidiInput::~RawMidiInput()
+{
+    close();
+}
+
+QStringList RawMidiInput::availablePorts()
+{
+    QStringList result;
+#if defined(Q_OS_UNIX)
+    const QDir snd(QStringLiteral("/dev/snd"));
+    foreach (const auto &name, snd.entryList({QStringLiteral("midiC*D*")}, QDir::System)) {
+        result << snd.filePath(name);
+    }
+    const QDir dev(QStringLiteral("/dev"));
+    foreach (const auto &name, dev.entryList({QStringLiteral("midi*")}, QDir::System)) {
+        result << dev.filePath(name);
+    }
+    result << QStringLiteral("-");
+#endif
+    return result;
+}
+
+void RawMidiInput::setCallback(MidiParser::Callback callback)
+{
+    m_parser.setCallback(callback);
+}
+
+bool RawMidiInput::open(const QString &portName)
+{
+    close();
+#if defined(Q_OS_UNIX)
+    if (portName == QLatin1String("-")) {
+        m_fd = dup(STDIN_FILENO);
+    } else {
+        m_fd = ::open(QFile::encodeName(portName).constData(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    }
+    if (m_fd < 0) {
+        qWarning() << Q_FUNC_INFO << "cannot open" << portName << strerror(errno);
+        return false;
+    }
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+    m_portName = portName;
+    m_parser.reset();
+    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &RawMidiInput::readInput);
+    return true;
+#else
+    qWarning() << Q_FUNC_INFO << "raw MIDI input is not available on this platform";
+    Q_UNUSED(portName)
+    return false;
+#endif
+}
+
+void RawMidiInput::close()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+#if defined(Q_OS_UNIX)
+    if (m_fd >= 0) {
+        ::close(m_fd);
+    }
+#endif
+    m_fd = -1;
+    m_portName.clear();
+}
+
+bool RawMidiInput::isOpen() const
+{
+    return m_fd >= 0;
+}
+
+QString RawMidiInput::portName() const
+{
+    return m_portName;
+}
+
+void RawMidiInput::readInput()
+{
+#if defined(Q_OS_UNIX)
+    std::uint8_t buffer[256];
+    for (;;) {
+        ssize_t n = ::read(m_fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            m_parser.parse(buffer, n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else {
+            if (n == 0) {
+                /* end of file: the writer of a pipe went away */
+                m_notifier->setEnabled(false);
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                qWarning() << Q_FUNC_INFO << m_portName << strerror(errno);
+                m_notifier->setEnabled(false);
+            }
+            break;
+        }
+    }
+#endif
+}
@@ -0,0 +1,60 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RAWMIDIINPUT_H
+#define RAWMIDIINPUT_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QString>
+#include <QStringList>
+
+#include "midiparser.h"
+#include "mp_svoxeas_visibility.h"
+
+/**
+ * Built-in MIDI input reading raw MIDI bytes from a file descriptor: an ALSA
+ * rawmidi or OSS device node, a named pipe, or "-" for the standard input.
+ * It does not need any Drumstick plugin. Only available on Unix systems.
+ */
+class MP_SVOXEAS_PUBLIC RawMidiInput : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RawMidiInput(QObject *parent = nullptr);
+    virtual ~RawMidiInput();
+
+    static QStringList availablePorts();
+
+    void setCallback(MidiParser::Callback callback);
+    bool open(const QString &portName);
+    void close();
+    bool isOpen() const;
+    QString portName() const;
+
+private:
+    void readInput();
+
+    int m_fd;
+    QString m_portName;
+    QSocketNotifier *m_notifier;
+    MidiParser m_parser;
+};
+
+#endif // RAWMIDIINPUT_H
@@ -0,0 +1,241 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "eas.h"
+#include "rendercache.h"
+
+static const quint32 ENTRY_MAGIC = 0x53565243; // "SVRC"
+static const quint32 ENTRY_VERSION = 1;
+static const char ENTRY_SUFFIX[] = ".svrc";
+
+RenderCache::RenderCache()
+    : m_directory(QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation))
+                      .filePath(QStringLiteral("renders")))
+    , m_maxSize(DEFAULT_MAX_SIZE)
+{}
+
+RenderCache *RenderCache::instance()
+{
+    static RenderCache inst;
+    return &inst;
+}
+
+QByteArray RenderCache::soundfontHash(const QString &path)
+{
+    QFileInfo fi(path);
+    const qint64 modified = fi.lastModified().toMSecsSinceEpoch();
+    QMutexLocker locker(&m_mutex);
+    auto it = m_soundfontHashes.constFind(fi.absoluteFilePath());
+    if (it != m_soundfontHashes.constEnd() && it->first == modified) {
+        return it->second;
+    }
+    locker.unlock();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        hash.addData(&file);
+    }
+    const QByteArray result = hash.result();
+    locker.relock();
+    m_soundfontHashes.insert(fi.absoluteFilePath(), qMakePair(modified, result));
+    return result;
+}
+
+QByteArray RenderCache::key(const QByteArray &midiData, const BounceSettings &settings)
+{
+    const S_EAS_LIB_CONFIG *config = EAS_Config();
+    QByteArray params;
+    QDataStream out(&params, QIODevice::WriteOnly);
+    out << ENTRY_VERSION << qint32(settings.soundLib) << qint32(settings.reverbType)
+        << qint32(settings.reverbWet) << qint32(settings.chorusType) << qint32(settings.chorusLevel);
+    if (config != nullptr) {
+        out << qint64(config->libVersion) << qint32(config->sampleRate)
+            << qint32(config->numChannels) << qint32(config->mixBufferSize);
+    }
+    if (!settings.soundfont.empty()) {
+        out << soundfontHash(QFile::decodeName(settings.soundfont.c_str()));
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(midiData);
+    hash.addData(params);
+    return hash.result().toHex();
+}
+
+QString RenderCache::entryPath(const QByteArray &key) const
+{
+    return QDir(m_directory).filePath(QString::fromLatin1(key) + QLatin1String(ENTRY_SUFFIX));
+}
+
+bool RenderCache::lookup(const QByteArray &key,
+                         std::vector<std::int16_t> &samples,
+                         int &sampleRate,
+                         int &channels,
+                         int &duration)
+{
+    QMutexLocker locker(&m_mutex);
+    QFile file(entryPath(key));
+    if (!file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    QDataStream in(&file);
+    quint32 magic, version;
+    qint32 rate, chans, millis;
+    quint64 frames;
+    QByteArray compressed;
+    in >> magic >> version >> rate >> chans >> millis >> frames >> compressed;
+    if (in.status() != QDataStream::Ok || magic != ENTRY_MAGIC || version != ENTRY_VERSION
+        || chans <= 0) {
+        qWarning() << Q_FUNC_INFO << "ignoring invalid entry" << file.fileName();
+        return false;
+    }
+    const QByteArray data = qUncompress(compressed);
+    if (quint64(data.size()) != frames * chans * sizeof(std::int16_t)) {
+        qWarning() << Q_FUNC_INFO << "corrupted entry" << file.fileName();
+        return false;
+    }
+    /* undo the per channel delta encoding */
+    samples.resize(frames * chans);
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData());
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        const std::uint16_t delta = std::uint16_t(p[2 * i] | (p[2 * i + 1] << 8));
+        const std::uint16_t previous = i >= std::size_t(chans) ? std::uint16_t(samples[i - chans]) : 0;
+        samples[i] = std::int16_t(std::uint16_t(previous + delta));
+    }
+    sampleRate = rate;
+    channels = chans;
+    duration = millis;
+    /* the modification time orders the entries for the LRU trimming */
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+bool RenderCache::store(const QByteArray &key,
+                        const std::int16_t *samples,
+                        std::size_t frames,
+                        int sampleRate,
+                        int channels,
+                        int duration)
+{
+    if (samples == nullptr || frames == 0 || channels <= 0) {
+        return false;
+    }
+    /* neighbour samples are alike, so their differences compress much better */
+    const std::size_t count = frames * channels;
+    QByteArray data(int(count * sizeof(std::int16_t)), Qt::Uninitialized);
+    uchar *p = reinterpret_cast<uchar *>(data.data());
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint16_t previous = i >= std::size_t(channels) ? std::uint16_t(samples[i - channels]) : 0;
+        const std::uint16_t delta = std::uint16_t(std::uint16_t(samples[i]) - previous);
+        p[2 * i] = delta & 0xff;
+        p[2 * i + 1] = delta >> 8;
+    }
+    const QByteArray compressed = qCompress(data);
+
+    QMutexLocker locker(&m_mutex);
+    QDir().mkpath(m_directory);
+    QSaveFile file(entryPath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << Q_FUNC_INFO << "cannot write" << file.fileName();
+        return false;
+    }
+    QDataStream out(&file);
+    out << ENTRY_MAGIC << ENTRY_VERSION << qint32(sampleRate) << qint32(channels) << qint32(duration)
+        << quint64(frames) << compressed;
+    if (!file.commit()) {
+        return false;
+    }
+    trim();
+    return true;
+}
+
+/* called with the mutex held */
+void RenderCache::trim()
+{
+    QDir dir(m_directory);
+    const QFileInfoList entries = dir.entryInfoList({QLatin1String("*") + QLatin1String(ENTRY_SUFFIX)},
+                                                    QDir::Files,
+                                                    QDir::Time);
+    qint64 total = 0;
+    for (const auto &entry : entries) {
+        total += entry.size();
+    }
+    /* newest first, so the oldest are at the end */
+    for (auto it = entries.crbegin(); it != entries.crend() && total > m_maxSize; ++it) {
+        if (QFile::remove(it->absoluteFilePath())) {
+            total -= it->size();
+        }
+    }
+}
+
+void RenderCache::setDirectory(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    m_directory = path;
+}
+
+QString RenderCache::directory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_directory;
+}
+
+void RenderCache::setMaxSize(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_maxSize = bytes;
+    trim();
+}
+
+qint64 RenderCache::maxSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxSize;
+}
+
+qint64 RenderCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 total = 0;
+    const QFileInfoList entries = QDir(m_directory).entryInfoList(
+        {QLatin1String("*") + QLatin1String(ENTRY_SUFFIX)}, QDir::Files);
+    for (const auto &entry : entries) {
+        total += entry.size();
+    }
+    return total;
+}
+
+void RenderCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    QDir dir(m_directory);
+    const QStringList entries = dir.entryList({QLatin1String("*") + QLatin1String(ENTRY_SUFFIX)},
+                                              QDir::Files);
+    for (const auto &entry : entries) {
+        dir.remove(entry);
+    }
+}
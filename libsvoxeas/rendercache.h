@@ -0,0 +1,80 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPair>
+#include <QString>
+#include <cstdint>
+#include <vector>
+
+#include "mp_svoxeas_visibility.h"
+#include "songbouncer.h"
+
+/**
+ * Disk cache of rendered songs, addressed by a hash of the MIDI data and
+ * of every setting that changes the output. Entries are stored delta
+ * encoded and compressed, and the least recently used ones are removed
+ * when the cache grows over its size limit. Thread safe.
+ */
+class MP_SVOXEAS_PUBLIC RenderCache
+{
+public:
+    static const qint64 DEFAULT_MAX_SIZE = 512LL * 1024 * 1024;
+
+    static RenderCache *instance();
+
+    QByteArray key(const QByteArray &midiData, const BounceSettings &settings);
+
+    bool lookup(const QByteArray &key,
+                std::vector<std::int16_t> &samples,
+                int &sampleRate,
+                int &channels,
+                int &duration);
+    bool store(const QByteArray &key,
+               const std::int16_t *samples,
+               std::size_t frames,
+               int sampleRate,
+               int channels,
+               int duration);
+
+    void setDirectory(const QString &path);
+    QString directory() const;
+    void setMaxSize(qint64 bytes);
+    qint64 maxSize() const;
+    qint64 size() const;
+    void clear();
+
+private:
+    RenderCache();
+    QByteArray soundfontHash(const QString &path);
+    QString entryPath(const QByteArray &key) const;
+    void trim();
+
+    mutable QMutex m_mutex;
+    QString m_directory;
+    qint64 m_maxSize;
+    /* path -> (modification time, SHA-1 of the contents) */
+    QHash<QString, QPair<qint64, QByteArray>> m_soundfontHashes;
+};
+
+#endif // RENDERCACHE_H
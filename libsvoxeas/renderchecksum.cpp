@@ -0,0 +1,108 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "renderchecksum.h"
+
+static const std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+static const std::uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+static inline std::uint64_t hashSamples(std::uint64_t hash, const std::int16_t *samples, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::uint16_t sample = std::uint16_t(samples[i]);
+        hash = (hash ^ (sample & 0xff)) * FNV_PRIME;
+        hash = (hash ^ (sample >> 8)) * FNV_PRIME;
+    }
+    return hash;
+}
+
+RenderChecksum::RenderChecksum()
+    : m_interval(0)
+{
+    reset();
+}
+
+void RenderChecksum::setInterval(int blocks)
+{
+    m_interval = blocks > 0 ? blocks : 0;
+}
+
+int RenderChecksum::interval() const
+{
+    return m_interval;
+}
+
+void RenderChecksum::add(const std::int16_t *samples, std::size_t count)
+{
+    const int interval = m_interval.load(std::memory_order_relaxed);
+    if (interval <= 0) {
+        return;
+    }
+    m_window = hashSamples(m_window, samples, count);
+    m_total.store(hashSamples(m_total.load(std::memory_order_relaxed), samples, count),
+                  std::memory_order_relaxed);
+    m_blocks.fetch_add(1, std::memory_order_relaxed);
+    if (++m_windowBlocks >= std::uint32_t(interval)) {
+        flush();
+    }
+}
+
+void RenderChecksum::flush()
+{
+    if (m_windowBlocks == 0) {
+        return;
+    }
+    RenderChecksumEntry entry;
+    entry.firstBlock = m_blocks.load(std::memory_order_relaxed) - m_windowBlocks;
+    entry.blocks = m_windowBlocks;
+    entry.value = m_window;
+    if (!m_queue.push(entry)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_window = FNV_OFFSET_BASIS;
+    m_windowBlocks = 0;
+}
+
+bool RenderChecksum::take(RenderChecksumEntry &entry)
+{
+    return m_queue.pop(entry);
+}
+
+std::uint64_t RenderChecksum::total() const
+{
+    return m_total.load(std::memory_order_relaxed);
+}
+
+std::uint64_t RenderChecksum::blocks() const
+{
+    return m_blocks.load(std::memory_order_relaxed);
+}
+
+std::uint64_t RenderChecksum::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void RenderChecksum::reset()
+{
+    m_window = FNV_OFFSET_BASIS;
+    m_windowBlocks = 0;
+    m_total = FNV_OFFSET_BASIS;
+    m_blocks = 0;
+    m_dropped = 0;
+}
@@ -0,0 +1,76 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERCHECKSUM_H
+#define RENDERCHECKSUM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "lockfreering.h"
+#include "mp_svoxeas_core_visibility.h"
+
+struct RenderChecksumEntry {
+    std::uint64_t firstBlock;
+    std::uint32_t blocks;
+    std::uint64_t value;
+};
+
+/**
+ * Rolling checksum of the rendered audio, to compare runs of the
+ * deterministic mode. Every interval blocks, a 64-bit FNV-1a hash of
+ * those blocks is queued for a non real-time thread; total() hashes
+ * everything since the last reset. Samples are hashed as little endian
+ * 16-bit values, so the results do not depend on the host.
+ */
+class MP_SVOXEAS_CORE_PUBLIC RenderChecksum
+{
+public:
+    static const std::size_t QUEUE_SIZE = 64;
+
+    RenderChecksum();
+
+    /* 0 disables the checksums */
+    void setInterval(int blocks);
+    int interval() const;
+
+    /* render thread, once per block */
+    void add(const std::int16_t *samples, std::size_t count);
+    /* queues the current partial window; render thread, or while not rendering */
+    void flush();
+    /* single consumer thread; returns false when empty */
+    bool take(RenderChecksumEntry &entry);
+
+    std::uint64_t total() const;
+    std::uint64_t blocks() const;
+    std::uint64_t dropped() const;
+    /* restarts the hashes, keeping the queued entries; same rule as flush() */
+    void reset();
+
+private:
+    std::atomic<int> m_interval;
+    std::uint64_t m_window;
+    std::uint32_t m_windowBlocks;
+    std::atomic<std::uint64_t> m_total;
+    std::atomic<std::uint64_t> m_blocks;
+    std::atomic<std::uint64_t> m_dropped;
+    SpscRing<RenderChecksumEntry, QUEUE_SIZE> m_queue;
+};
+
+#endif // RENDERCHECKSUM_H
@@ -0,0 +1,99 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <chrono>
+
+#include "rendererrors.h"
+
+RenderErrors::RenderErrors()
+{
+    reset();
+}
+
+const char *RenderErrors::codeName(int code)
+{
+    switch (code) {
+    case RenderFailed:
+        return "EAS_Render";
+    case WriteMidiFailed:
+        return "EAS_WriteMIDIStream";
+    case MidiQueueFull:
+        return "MIDI event queue full";
+    case StateFailed:
+        return "EAS_State";
+    case LocationFailed:
+        return "EAS_GetLocation";
+    case LocateFailed:
+        return "EAS_Locate";
+    case PlaybackRateFailed:
+        return "EAS_SetPlaybackRate";
+    case CloseFileFailed:
+        return "EAS_CloseFile";
+    case OpenFileFailed:
+        return "EAS_OpenFile";
+    case PrepareFailed:
+        return "EAS_Prepare";
+    case SetVolumeFailed:
+        return "EAS_SetVolume";
+    case PauseFailed:
+        return "EAS_Pause";
+    case MetaQueueFull:
+        return "metadata event queue full";
+    case SetParameterFailed:
+        return "EAS_SetParameter";
+    case InstanceBusy:
+        return "EAS instance borrowed";
+    default:
+        return "unknown";
+    }
+}
+
+void RenderErrors::report(Code code, std::int32_t result)
+{
+    RenderError error;
+    error.code = std::uint16_t(code);
+    error.result = result;
+    error.nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch())
+                      .count();
+    m_counts[code].fetch_add(1, std::memory_order_relaxed);
+    if (!m_queue.push(error)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool RenderErrors::take(RenderError &error)
+{
+    return m_queue.pop(error);
+}
+
+void RenderErrors::read(Counters &counters) const
+{
+    for (int i = 0; i < CodeCount; ++i) {
+        counters.count[i] = m_counts[i].load(std::memory_order_relaxed);
+    }
+    counters.dropped = m_dropped.load(std::memory_order_relaxed);
+}
+
+void RenderErrors::reset()
+{
+    for (auto &count : m_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_dropped.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,86 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERERRORS_H
+#define RENDERERRORS_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "engineprofile.h"
+#include "lockfreering.h"
+#include "mp_svoxeas_core_visibility.h"
+
+struct RenderError {
+    std::uint16_t code;
+    std::int32_t result;
+    std::int64_t nanos; // steady clock
+};
+
+/**
+ * Errors of the audio render path. The render and MIDI threads record
+ * fixed-size entries without locking or formatting anything; a non
+ * real-time thread takes them later for logging. The per-code counters
+ * include the entries dropped while the queue was full.
+ */
+class MP_SVOXEAS_CORE_PUBLIC RenderErrors
+{
+public:
+    enum Code {
+        RenderFailed,
+        WriteMidiFailed,
+        MidiQueueFull,
+        StateFailed,
+        LocationFailed,
+        LocateFailed,
+        PlaybackRateFailed,
+        CloseFileFailed,
+        OpenFileFailed,
+        PrepareFailed,
+        SetVolumeFailed,
+        PauseFailed,
+        MetaQueueFull,
+        SetParameterFailed,
+        InstanceBusy,
+        CodeCount
+    };
+
+    struct Counters {
+        std::uint64_t count[CodeCount];
+        std::uint64_t dropped;
+    };
+
+    RenderErrors();
+
+    static const char *codeName(int code);
+
+    /* any thread, lock-free */
+    void report(Code code, std::int32_t result);
+    /* single consumer thread; returns false when empty */
+    bool take(RenderError &error);
+
+    void read(Counters &counters) const;
+    void reset();
+
+private:
+    MpscRing<RenderError, EngineProfile::ERROR_QUEUE_SIZE> m_queue;
+    std::atomic<std::uint64_t> m_counts[CodeCount];
+    std::atomic<std::uint64_t> m_dropped;
+};
+
+#endif // RENDERERRORS_H
@@ -0,0 +1,130 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "renderstats.h"
+
+const std::uint32_t RenderStats::CALLBACK_BUCKET_MICROS[RenderStats::CALLBACK_BUCKETS - 1]
+    = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000};
+
+RenderStats::RenderStats()
+{
+    reset();
+}
+
+void RenderStats::addRendered(std::uint64_t blocks, std::uint64_t nanos)
+{
+    m_renderedBlocks.fetch_add(blocks, std::memory_order_relaxed);
+    m_renderNanos.fetch_add(nanos, std::memory_order_relaxed);
+    /* the render thread is the only writer */
+    if (blocks > 0 && nanos / blocks > m_peakRenderNanos.load(std::memory_order_relaxed)) {
+        m_peakRenderNanos.store(nanos / blocks, std::memory_order_relaxed);
+    }
+}
+
+void RenderStats::addIdle(std::uint64_t blocks, std::uint64_t nanos)
+{
+    m_idleBlocks.fetch_add(blocks, std::memory_order_relaxed);
+    m_idleNanos.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+void RenderStats::addWakeup()
+{
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RenderStats::addPrewarm(std::uint64_t blocks, std::uint64_t nanos)
+{
+    m_prewarmBlocks.fetch_add(blocks, std::memory_order_relaxed);
+    m_prewarmNanos.fetch_add(nanos, std::memory_order_relaxed);
+}
+
+void RenderStats::addMidiEvents(std::uint64_t count)
+{
+    m_midiEvents.fetch_add(count, std::memory_order_relaxed);
+}
+
+std::uint64_t RenderStats::midiEvents() const
+{
+    return m_midiEvents.load(std::memory_order_relaxed);
+}
+
+void RenderStats::addCallback(std::uint64_t nanos)
+{
+    int bucket = 0;
+    while (bucket < CALLBACK_BUCKETS - 1 && nanos > CALLBACK_BUCKET_MICROS[bucket] * 1000ull) {
+        ++bucket;
+    }
+    m_callbackBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    m_callbackNanos.fetch_add(nanos, std::memory_order_relaxed);
+    m_callbacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint32_t RenderStats::callbackPercentile(const std::uint64_t *buckets, double fraction)
+{
+    std::uint64_t total = 0;
+    for (int i = 0; i < CALLBACK_BUCKETS; ++i) {
+        total += buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    std::uint64_t count = 0;
+    for (int i = 0; i < CALLBACK_BUCKETS - 1; ++i) {
+        count += buckets[i];
+        if (count >= fraction * total) {
+            return CALLBACK_BUCKET_MICROS[i];
+        }
+    }
+    return CALLBACK_BUCKET_MICROS[CALLBACK_BUCKETS - 2];
+}
+
+void RenderStats::read(Values &values) const
+{
+    values.renderedBlocks = m_renderedBlocks.load(std::memory_order_relaxed);
+    values.renderNanos = m_renderNanos.load(std::memory_order_relaxed);
+    values.idleBlocks = m_idleBlocks.load(std::memory_order_relaxed);
+    values.idleNanos = m_idleNanos.load(std::memory_order_relaxed);
+    values.wakeups = m_wakeups.load(std::memory_order_relaxed);
+    values.peakRenderNanos = m_peakRenderNanos.load(std::memory_order_relaxed);
+    values.prewarmBlocks = m_prewarmBlocks.load(std::memory_order_relaxed);
+    values.prewarmNanos = m_prewarmNanos.load(std::memory_order_relaxed);
+    values.midiEvents = m_midiEvents.load(std::memory_order_relaxed);
+    values.callbacks = m_callbacks.load(std::memory_order_relaxed);
+    values.callbackNanos = m_callbackNanos.load(std::memory_order_relaxed);
+    for (int i = 0; i < CALLBACK_BUCKETS; ++i) {
+        values.callbackBuckets[i] = m_callbackBuckets[i].load(std::memory_order_relaxed);
+    }
+}
+
+void RenderStats::reset()
+{
+    m_renderedBlocks.store(0, std::memory_order_relaxed);
+    m_renderNanos.store(0, std::memory_order_relaxed);
+    m_idleBlocks.store(0, std::memory_order_relaxed);
+    m_idleNanos.store(0, std::memory_order_relaxed);
+    m_wakeups.store(0, std::memory_order_relaxed);
+    m_peakRenderNanos.store(0, std::memory_order_relaxed);
+    m_prewarmBlocks.store(0, std::memory_order_relaxed);
+    m_prewarmNanos.store(0, std::memory_order_relaxed);
+    m_midiEvents.store(0, std::memory_order_relaxed);
+    m_callbacks.store(0, std::memory_order_relaxed);
+    m_callbackNanos.store(0, std::memory_order_relaxed);
+    for (auto &bucket : m_callbackBuckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,88 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RENDERSTATS_H
+#define RENDERSTATS_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "mp_svoxeas_core_visibility.h"
+
+/**
+ * Counters of the audio render path. They are updated with relaxed
+ * atomics by the render thread and may be read from any thread.
+ */
+class MP_SVOXEAS_CORE_PUBLIC RenderStats
+{
+public:
+    /* upper bounds of the callback time buckets, in microseconds; the last one is unbounded */
+    static const int CALLBACK_BUCKETS = 10;
+    static const std::uint32_t CALLBACK_BUCKET_MICROS[CALLBACK_BUCKETS - 1];
+
+    struct Values {
+        std::uint64_t renderedBlocks;
+        std::uint64_t renderNanos;
+        std::uint64_t idleBlocks;
+        std::uint64_t idleNanos;
+        std::uint64_t wakeups;
+        std::uint64_t peakRenderNanos;
+        std::uint64_t prewarmBlocks;
+        std::uint64_t prewarmNanos;
+        std::uint64_t midiEvents;
+        std::uint64_t callbacks;
+        std::uint64_t callbackNanos;
+        /* not cumulative: each bucket counts the callbacks above the previous bound */
+        std::uint64_t callbackBuckets[CALLBACK_BUCKETS];
+    };
+
+    RenderStats();
+
+    void addRendered(std::uint64_t blocks, std::uint64_t nanos);
+    void addIdle(std::uint64_t blocks, std::uint64_t nanos);
+    void addWakeup();
+    /* blocks rendered while instruments are being pre-warmed, kept apart */
+    void addPrewarm(std::uint64_t blocks, std::uint64_t nanos);
+    /* live MIDI messages fed to EAS */
+    void addMidiEvents(std::uint64_t count);
+    std::uint64_t midiEvents() const;
+    /* whole audio callbacks, as seen by the audio device */
+    void addCallback(std::uint64_t nanos);
+    /* upper bound in microseconds of the bucket holding that fraction of the
+       callbacks counted in buckets; the unbounded bucket reports its lower bound */
+    static std::uint32_t callbackPercentile(const std::uint64_t *buckets, double fraction);
+
+    void read(Values &values) const;
+    void reset();
+
+private:
+    std::atomic<std::uint64_t> m_renderedBlocks;
+    std::atomic<std::uint64_t> m_renderNanos;
+    std::atomic<std::uint64_t> m_idleBlocks;
+    std::atomic<std::uint64_t> m_idleNanos;
+    std::atomic<std::uint64_t> m_wakeups;
+    std::atomic<std::uint64_t> m_peakRenderNanos;
+    std::atomic<std::uint64_t> m_prewarmBlocks;
+    std::atomic<std::uint64_t> m_prewarmNanos;
+    std::atomic<std::uint64_t> m_midiEvents;
+    std::atomic<std::uint64_t> m_callbacks;
+    std::atomic<std::uint64_t> m_callbackNanos;
+    std::atomic<std::uint64_t> m_callbackBuckets[CALLBACK_BUCKETS];
+};
+
+#endif // RENDERSTATS_H
@@ -0,0 +1,179 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "rtmemory.h"
+
+/* the largest stack area prefaultStack() touches at once */
+static const std::size_t STACK_CHUNK = 16 * 1024;
+
+std::size_t RtMemory::lockLimit()
+{
+#if defined(_WIN32)
+    SIZE_T minimum = 0, maximum = 0;
+    if (GetProcessWorkingSetSize(GetCurrentProcess(), &minimum, &maximum)) {
+        return minimum;
+    }
+    return 0;
+#else
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_MEMLOCK, &limit) != 0) {
+        return 0;
+    }
+    if (limit.rlim_cur == RLIM_INFINITY) {
+        return UNLIMITED;
+    }
+    return std::size_t(limit.rlim_cur);
+#endif
+}
+
+std::size_t RtMemory::pageSize()
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    long size = sysconf(_SC_PAGESIZE);
+    return size > 0 ? std::size_t(size) : 4096;
+#endif
+}
+
+std::size_t RtMemory::lock(const void *address, std::size_t size)
+{
+    if (address == nullptr || size == 0) {
+        return 0;
+    }
+    const std::size_t page = pageSize();
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(address) & ~(page - 1);
+    const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(address) + size + page - 1) & ~(page - 1);
+#if defined(_WIN32)
+    if (!VirtualLock(reinterpret_cast<void *>(begin), end - begin)) {
+        return 0;
+    }
+#else
+    if (mlock(reinterpret_cast<const void *>(begin), end - begin) != 0) {
+        return 0;
+    }
+#endif
+    return end - begin;
+}
+
+void RtMemory::unlock(const void *address, std::size_t size)
+{
+    if (address == nullptr || size == 0) {
+        return;
+    }
+    const std::size_t page = pageSize();
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(address) & ~(page - 1);
+    const std::uintptr_t end = (reinterpret_cast<std::uintptr_t>(address) + size + page - 1) & ~(page - 1);
+#if defined(_WIN32)
+    VirtualUnlock(reinterpret_cast<void *>(begin), end - begin);
+#else
+    munlock(reinterpret_cast<const void *>(begin), end - begin);
+#endif
+}
+
+bool RtMemory::lockAll()
+{
+#if defined(_WIN32)
+    errno = ENOSYS;
+    return false;
+#else
+    return mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+#endif
+}
+
+void RtMemory::unlockAll()
+{
+#if !defined(_WIN32)
+    munlockall();
+#endif
+}
+
+std::size_t RtMemory::lockedSize()
+{
+    std::size_t bytes = 0;
+#if defined(__linux__)
+    FILE *status = std::fopen("/proc/self/status", "r");
+    if (status != nullptr) {
+        char line[128];
+        unsigned long kb;
+        while (std::fgets(line, sizeof(line), status) != nullptr) {
+            if (std::sscanf(line, "VmLck: %lu kB", &kb) == 1) {
+                bytes = std::size_t(kb) * 1024;
+                break;
+            }
+        }
+        std::fclose(status);
+    }
+#endif
+    return bytes;
+}
+
+void RtMemory::prefault(const void *address, std::size_t size)
+{
+    if (address == nullptr || size == 0) {
+        return;
+    }
+    const std::size_t page = pageSize();
+    const volatile unsigned char *p = static_cast<const volatile unsigned char *>(address);
+    unsigned char sum = 0;
+    for (std::size_t offset = 0; offset < size; offset += page) {
+        sum += p[offset];
+    }
+    sum += p[size - 1];
+    (void) sum;
+}
+
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static void touchStack(std::size_t remaining)
+{
+    volatile unsigned char chunk[STACK_CHUNK];
+    const std::size_t page = RtMemory::pageSize();
+    for (std::size_t offset = 0; offset < STACK_CHUNK; offset += page) {
+        chunk[offset] = 0;
+    }
+    if (remaining > STACK_CHUNK) {
+        touchStack(remaining - STACK_CHUNK);
+    }
+    chunk[0] = chunk[STACK_CHUNK - 1];
+}
+
+void RtMemory::prefaultStack(std::size_t size)
+{
+    if (size > 0) {
+        touchStack(size);
+    }
+}
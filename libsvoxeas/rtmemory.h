@@ -0,0 +1,56 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RTMEMORY_H
+#define RTMEMORY_H
+
+#include <cstddef>
+
+#include "mp_svoxeas_core_visibility.h"
+
+/**
+ * Helpers to keep the memory used by the audio thread resident: locking
+ * it with mlock (VirtualLock on Windows) and faulting its pages in before
+ * the audio starts. Failures are reported, never fatal.
+ */
+class MP_SVOXEAS_CORE_PUBLIC RtMemory
+{
+public:
+    static const std::size_t UNLIMITED = ~std::size_t(0);
+
+    /* RLIMIT_MEMLOCK, or UNLIMITED */
+    static std::size_t lockLimit();
+    static std::size_t pageSize();
+
+    /* locks the pages covering the range; returns the locked bytes, or 0 */
+    static std::size_t lock(const void *address, std::size_t size);
+    static void unlock(const void *address, std::size_t size);
+
+    /* locks every current and future mapping of the process; errno tells why not */
+    static bool lockAll();
+    static void unlockAll();
+    /* bytes locked by the process, as seen by the system, if known */
+    static std::size_t lockedSize();
+
+    /* reads one byte of every page in the range */
+    static void prefault(const void *address, std::size_t size);
+    /* touches the given amount of stack below the caller */
+    static void prefaultStack(std::size_t size);
+};
+
+#endif // RTMEMORY_H
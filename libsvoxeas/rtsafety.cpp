@@ -0,0 +1,324 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "rtsafety.h"
+
+#if !defined(SVOXEAS_RT_CHECKS)
+#error "the checker needs the RT_SAFETY_CHECKS build, for the core to mark its scopes"
+#endif
+
+#include <atomic>
+#include <cerrno>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* glibc entry points that bypass the interposed symbols */
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+void *__libc_memalign(std::size_t alignment, std::size_t size);
+void __libc_free(void *ptr);
+}
+
+namespace {
+
+enum Violation { Allocation, Deallocation, Lock, FileOpen, FileIo, ViolationCount };
+
+const char *const VIOLATION_NAMES[] = {"allocation", "deallocation", "mutex lock", "file open", "file read or write"};
+const int MAX_FRAMES = 32;
+
+/* initial-exec TLS never allocates, so it is safe inside malloc */
+__attribute__((tls_model("initial-exec"))) thread_local bool t_reporting = false;
+
+std::atomic<std::uint64_t> s_counters[ViolationCount];
+std::atomic<bool> s_report{true};
+std::atomic<bool> s_abort{false};
+
+typedef int (*MutexLockFunc)(pthread_mutex_t *);
+typedef int (*OpenFunc)(const char *, int, ...);
+typedef int (*OpenAtFunc)(int, const char *, int, ...);
+typedef FILE *(*FopenFunc)(const char *, const char *);
+typedef ssize_t (*ReadFunc)(int, void *, std::size_t);
+typedef ssize_t (*WriteFunc)(int, const void *, std::size_t);
+typedef std::size_t (*FreadFunc)(void *, std::size_t, std::size_t, FILE *);
+typedef std::size_t (*FwriteFunc)(const void *, std::size_t, std::size_t, FILE *);
+
+std::atomic<MutexLockFunc> s_mutexLock{nullptr};
+std::atomic<OpenFunc> s_open{nullptr};
+std::atomic<OpenFunc> s_open64{nullptr};
+std::atomic<OpenAtFunc> s_openat{nullptr};
+std::atomic<FopenFunc> s_fopen{nullptr};
+std::atomic<FopenFunc> s_fopen64{nullptr};
+std::atomic<ReadFunc> s_read{nullptr};
+std::atomic<WriteFunc> s_write{nullptr};
+std::atomic<FreadFunc> s_fread{nullptr};
+std::atomic<FwriteFunc> s_fwrite{nullptr};
+
+/* the library's own function; on first use, because the constructors of
+   other libraries may call it before resolveSymbols() runs. dlsym only
+   allocates through the __libc_ entry points */
+template <typename Func>
+Func next(std::atomic<Func> &slot, const char *name)
+{
+    Func func = slot.load(std::memory_order_acquire);
+    if (func == nullptr) {
+        func = reinterpret_cast<Func>(dlsym(RTLD_NEXT, name));
+        slot.store(func, std::memory_order_release);
+    }
+    return func;
+}
+
+/* resolved up front, so the first call on a checked thread does not
+   allocate; the first backtrace() loads libgcc, which must not be reported
+   either */
+__attribute__((constructor)) void resolveSymbols()
+{
+    void *frames[1];
+    backtrace(frames, 1);
+    next(s_mutexLock, "pthread_mutex_lock");
+    next(s_open, "open");
+    next(s_open64, "open64");
+    next(s_openat, "openat");
+    next(s_fopen, "fopen");
+    next(s_fopen64, "fopen64");
+    next(s_read, "read");
+    next(s_write, "write");
+    next(s_fread, "fread");
+    next(s_fwrite, "fwrite");
+}
+
+void writeString(const char *s)
+{
+    ssize_t r = ::write(STDERR_FILENO, s, std::strlen(s));
+    (void) r;
+}
+
+/* counts the call if it comes from a real-time thread; never allocates */
+void check(Violation kind, const char *detail = nullptr)
+{
+    if (t_reporting || !RtThread::isRealtime()) {
+        return;
+    }
+    t_reporting = true;
+    s_counters[kind].fetch_add(1, std::memory_order_relaxed);
+    if (s_report.load(std::memory_order_relaxed)) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "RT safety violation: %s%s%s on the render thread\n",
+                      VIOLATION_NAMES[kind], detail ? " of " : "", detail ? detail : "");
+        writeString(line);
+        void *frames[MAX_FRAMES];
+        int count = backtrace(frames, MAX_FRAMES);
+        /* skip check() and the interposed function */
+        if (count > 2) {
+            backtrace_symbols_fd(frames + 2, count - 2, STDERR_FILENO);
+        }
+    }
+    if (s_abort.load(std::memory_order_relaxed)) {
+        std::abort();
+    }
+    t_reporting = false;
+}
+
+int openMode(int flags, va_list args)
+{
+#if defined(O_TMPFILE)
+    if ((flags & O_CREAT) || (flags & O_TMPFILE) == O_TMPFILE) {
+#else
+    if (flags & O_CREAT) {
+#endif
+        return va_arg(args, int);
+    }
+    return 0;
+}
+
+} // namespace
+
+extern "C" {
+
+void *malloc(std::size_t size)
+{
+    check(Allocation);
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size)
+{
+    check(Allocation);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, std::size_t size)
+{
+    check(Allocation);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    if (ptr != nullptr) {
+        check(Deallocation);
+    }
+    __libc_free(ptr);
+}
+
+int posix_memalign(void **ptr, std::size_t alignment, std::size_t size)
+{
+    check(Allocation);
+    void *p = __libc_memalign(alignment, size);
+    if (p == nullptr) {
+        return ENOMEM;
+    }
+    *ptr = p;
+    return 0;
+}
+
+void *aligned_alloc(std::size_t alignment, std::size_t size)
+{
+    check(Allocation);
+    return __libc_memalign(alignment, size);
+}
+
+void *memalign(std::size_t alignment, std::size_t size)
+{
+    check(Allocation);
+    return __libc_memalign(alignment, size);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex)
+{
+    check(Lock);
+    return next(s_mutexLock, "pthread_mutex_lock")(mutex);
+}
+
+int open(const char *path, int flags, ...)
+{
+    va_list args;
+    va_start(args, flags);
+    const int mode = openMode(flags, args);
+    va_end(args);
+    check(FileOpen, path);
+    return next(s_open, "open")(path, flags, mode);
+}
+
+int open64(const char *path, int flags, ...)
+{
+    va_list args;
+    va_start(args, flags);
+    const int mode = openMode(flags, args);
+    va_end(args);
+    check(FileOpen, path);
+    return next(s_open64, "open64")(path, flags, mode);
+}
+
+int openat(int dirfd, const char *path, int flags, ...)
+{
+    va_list args;
+    va_start(args, flags);
+    const int mode = openMode(flags, args);
+    va_end(args);
+    check(FileOpen, path);
+    return next(s_openat, "openat")(dirfd, path, flags, mode);
+}
+
+FILE *fopen(const char *path, const char *mode)
+{
+    check(FileOpen, path);
+    return next(s_fopen, "fopen")(path, mode);
+}
+
+FILE *fopen64(const char *path, const char *mode)
+{
+    check(FileOpen, path);
+    return next(s_fopen64, "fopen64")(path, mode);
+}
+
+/* stdio goes to the kernel through internal calls, so its reads and writes
+   are caught at fread() and fwrite(), even when the buffer serves them */
+ssize_t read(int fd, void *buffer, std::size_t count)
+{
+    check(FileIo);
+    return next(s_read, "read")(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void *buffer, std::size_t count)
+{
+    check(FileIo);
+    return next(s_write, "write")(fd, buffer, count);
+}
+
+std::size_t fread(void *buffer, std::size_t size, std::size_t count, FILE *stream)
+{
+    check(FileIo);
+    return next(s_fread, "fread")(buffer, size, count, stream);
+}
+
+std::size_t fwrite(const void *buffer, std::size_t size, std::size_t count, FILE *stream)
+{
+    check(FileIo);
+    return next(s_fwrite, "fwrite")(buffer, size, count, stream);
+}
+
+} // extern "C"
+
+bool RtSafety::isRealtimeThread()
+{
+    return RtThread::isRealtime();
+}
+
+void RtSafety::setReportViolations(bool report)
+{
+    s_report.store(report);
+}
+
+void RtSafety::setAbortOnViolation(bool abortOnViolation)
+{
+    s_abort.store(abortOnViolation);
+}
+
+void RtSafety::read(Counters &counters)
+{
+    counters.allocations = s_counters[Allocation].load(std::memory_order_relaxed);
+    counters.deallocations = s_counters[Deallocation].load(std::memory_order_relaxed);
+    counters.locks = s_counters[Lock].load(std::memory_order_relaxed);
+    counters.fileOpens = s_counters[FileOpen].load(std::memory_order_relaxed);
+    counters.fileIo = s_counters[FileIo].load(std::memory_order_relaxed);
+}
+
+void RtSafety::reset()
+{
+    for (auto &counter : s_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t RtSafety::violations()
+{
+    Counters counters;
+    read(counters);
+    return counters.allocations + counters.deallocations + counters.locks + counters.fileOpens
+           + counters.fileIo;
+}
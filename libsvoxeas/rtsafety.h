@@ -0,0 +1,63 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RTSAFETY_H
+#define RTSAFETY_H
+
+#include <cstdint>
+
+#include "rtscope.h"
+
+/**
+ * Real-time safety checker for the audio render path, in the
+ * mp_svoxeas_rtsafety object library of the RT_SAFETY_CHECKS build. An
+ * executable linking it gets the heap allocations, mutex locks, file
+ * opens and file reads and writes (read, write, fread, fwrite) made inside
+ * an RtScope counted and reported to stderr with a backtrace. The core
+ * library only marks the scopes, so nothing else is interposed.
+ *
+ * The calls are intercepted by interposing the C library symbols, so it
+ * works on Linux (glibc) only, and only for the calls made through them:
+ * QMutex, raw system calls and pread() are not seen, although a contended
+ * QMutex or a logging call allocates or writes anyway. EAS parses a MIDI
+ * file while it plays it, so the reads it makes then are counted too.
+ */
+class RtSafety
+{
+public:
+    struct Counters {
+        std::uint64_t allocations;
+        std::uint64_t deallocations;
+        std::uint64_t locks;
+        std::uint64_t fileOpens;
+        std::uint64_t fileIo;
+    };
+
+    static bool isRealtimeThread();
+
+    /* print each violation with a backtrace (default) */
+    static void setReportViolations(bool report);
+    /* abort() at the first violation, to catch it in a debugger or a test */
+    static void setAbortOnViolation(bool abortOnViolation);
+
+    static void read(Counters &counters);
+    static std::uint64_t violations();
+    static void reset();
+};
+
+#endif // RTSAFETY_H
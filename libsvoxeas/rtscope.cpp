@@ -0,0 +1,58 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "rtscope.h"
+
+#if defined(SVOXEAS_RT_CHECKS)
+
+namespace {
+
+/* initial-exec TLS never allocates, so the checker can read it inside malloc */
+__attribute__((tls_model("initial-exec"))) thread_local int t_depth = 0;
+
+} // namespace
+
+void RtThread::enter()
+{
+    ++t_depth;
+}
+
+void RtThread::leave()
+{
+    if (t_depth > 0) {
+        --t_depth;
+    }
+}
+
+bool RtThread::isRealtime()
+{
+    return t_depth > 0;
+}
+
+#else
+
+void RtThread::enter() {}
+
+void RtThread::leave() {}
+
+bool RtThread::isRealtime()
+{
+    return false;
+}
+
+#endif // SVOXEAS_RT_CHECKS
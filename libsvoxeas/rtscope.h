@@ -0,0 +1,59 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RTSCOPE_H
+#define RTSCOPE_H
+
+#include "mp_svoxeas_core_visibility.h"
+
+/**
+ * Marks the render path as real-time. When the library is built with the
+ * RT_SAFETY_CHECKS option, the checker of mp_svoxeas_rtsafety (RtSafety),
+ * linked only into the executables that want it, reports the heap, lock
+ * and file calls made inside an RtScope. Without the option the scope is
+ * empty and costs nothing.
+ */
+class MP_SVOXEAS_CORE_PUBLIC RtThread
+{
+public:
+    /* nested scopes are allowed; the thread is real-time until the outermost one ends */
+    static void enter();
+    static void leave();
+    static bool isRealtime();
+};
+
+#if defined(SVOXEAS_RT_CHECKS)
+class RtScope
+{
+public:
+    RtScope() { RtThread::enter(); }
+    ~RtScope() { RtThread::leave(); }
+    RtScope(const RtScope &) = delete;
+    RtScope &operator=(const RtScope &) = delete;
+};
+#else
+class RtScope
+{
+public:
+    RtScope() {}
+    RtScope(const RtScope &) = delete;
+    RtScope &operator=(const RtScope &) = delete;
+};
+#endif
+
+#endif // RTSCOPE_H
@@ -0,0 +1,253 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "smfscanner.h"
+
+static std::uint32_t readBE(const std::uint8_t *p, int bytes)
+{
+    std::uint32_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+static std::uint32_t readLE32(const std::uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (std::uint32_t(p[3]) << 24);
+}
+
+/* reads a variable length quantity, returns false on truncated data */
+static bool readVarLen(const std::uint8_t *&p, const std::uint8_t *end, std::uint32_t &value)
+{
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (p >= end) {
+            return false;
+        }
+        std::uint8_t c = *p++;
+        value = (value << 7) | (c & 0x7f);
+        if ((c & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+SmfScanner::SmfScanner()
+    : m_data(nullptr)
+    , m_size(0)
+    , m_format(-1)
+    , m_tracks(0)
+    , m_division(0)
+{}
+
+bool SmfScanner::open(const std::uint8_t *data, std::size_t size)
+{
+    m_data = nullptr;
+    m_size = 0;
+    m_format = -1;
+    m_tracks = 0;
+    m_division = 0;
+    if (data == nullptr || size < 14) {
+        return false;
+    }
+    /* RIFF MIDI (.rmi): look for the 'data' chunk holding the SMF */
+    if (memcmp(data, "RIFF", 4) == 0 && memcmp(data + 8, "RMID", 4) == 0) {
+        std::size_t pos = 12;
+        while (pos + 8 <= size) {
+            std::uint32_t len = readLE32(data + pos + 4);
+            if (memcmp(data + pos, "data", 4) == 0) {
+                data += pos + 8;
+                size = std::min<std::size_t>(len, size - pos - 8);
+                break;
+            }
+            pos += 8 + len + (len & 1);
+        }
+        if (size < 14) {
+            return false;
+        }
+    }
+    if (memcmp(data, "MThd", 4) != 0 || readBE(data + 4, 4) < 6) {
+        return false;
+    }
+    m_data = data;
+    m_size = size;
+    m_format = readBE(data + 8, 2);
+    m_tracks = readBE(data + 10, 2);
+    m_division = readBE(data + 12, 2);
+    return true;
+}
+
+bool SmfScanner::isValid() const
+{
+    return m_data != nullptr;
+}
+
+int SmfScanner::format() const
+{
+    return m_format;
+}
+
+int SmfScanner::tracks() const
+{
+    return m_tracks;
+}
+
+int SmfScanner::division() const
+{
+    return m_division;
+}
+
+bool SmfScanner::forEachEvent(const std::function<bool(const SmfEvent &)> &callback) const
+{
+    if (!isValid()) {
+        return false;
+    }
+    const std::uint8_t *end = m_data + m_size;
+    const std::uint8_t *chunk = m_data + 8 + readBE(m_data + 4, 4);
+    int track = 0;
+    while (track < m_tracks && chunk + 8 <= end) {
+        std::uint32_t len = readBE(chunk + 4, 4);
+        const std::uint8_t *p = chunk + 8;
+        const std::uint8_t *trackEnd = (len > std::uint32_t(end - p)) ? end : p + len;
+        chunk = trackEnd;
+        if (memcmp(p - 8, "MTrk", 4) != 0) {
+            continue;
+        }
+        SmfEvent ev{};
+        ev.track = track++;
+        std::uint8_t runningStatus = 0;
+        while (p < trackEnd) {
+            std::uint32_t delta;
+            if (!readVarLen(p, trackEnd, delta) || p >= trackEnd) {
+                break;
+            }
+            ev.tick += delta;
+            ev.metaType = 0;
+            ev.payload = nullptr;
+            ev.length = 0;
+            ev.data1 = ev.data2 = 0;
+            std::uint8_t status = *p;
+            if (status & 0x80) {
+                ++p;
+            } else if (runningStatus != 0) {
+                status = runningStatus;
+            } else {
+                break;
+            }
+            ev.status = status;
+            if (status == 0xff) {
+                if (p >= trackEnd) {
+                    break;
+                }
+                ev.metaType = *p++;
+                if (!readVarLen(p, trackEnd, ev.length) || ev.length > std::uint32_t(trackEnd - p)) {
+                    break;
+                }
+                ev.payload = p;
+                p += ev.length;
+            } else if (status == 0xf0 || status == 0xf7) {
+                runningStatus = 0;
+                if (!readVarLen(p, trackEnd, ev.length) || ev.length > std::uint32_t(trackEnd - p)) {
+                    break;
+                }
+                ev.payload = p;
+                p += ev.length;
+            } else if (status >= 0x80 && status < 0xf0) {
+                runningStatus = status;
+                int bytes = ((status & 0xf0) == 0xc0 || (status & 0xf0) == 0xd0) ? 1 : 2;
+                if (trackEnd - p < bytes) {
+                    break;
+                }
+                ev.data1 = p[0] & 0x7f;
+                ev.data2 = (bytes > 1) ? (p[1] & 0x7f) : 0;
+                p += bytes;
+            } else {
+                /* system common messages are not valid in files */
+                break;
+            }
+            if (!callback(ev)) {
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+bool SmfScanner::hasLyrics() const
+{
+    bool found = false;
+    forEachEvent([&found](const SmfEvent &ev) {
+        if (ev.status == 0xff) {
+            /* karaoke (.kar) files use text events, with '@' prefixed headers */
+            if (ev.metaType == META_LYRIC
+                || (ev.metaType == META_TEXT && ev.length > 0 && ev.payload[0] == '@')) {
+                found = true;
+            }
+        }
+        return !found;
+    });
+    return found;
+}
+
+std::vector<SmfTempo> SmfScanner::tempoMap() const
+{
+    std::vector<SmfTempo> map;
+    forEachEvent([&map](const SmfEvent &ev) {
+        if (ev.status == 0xff && ev.metaType == META_TEMPO && ev.length == 3) {
+            map.push_back({ev.tick, readBE(ev.payload, 3)});
+        }
+        return true;
+    });
+    std::stable_sort(map.begin(), map.end(), [](const SmfTempo &a, const SmfTempo &b) {
+        return a.tick < b.tick;
+    });
+    return map;
+}
+
+double SmfScanner::millis(std::uint32_t tick, const std::vector<SmfTempo> &tempoMap) const
+{
+    if (m_division & 0x8000) {
+        /* SMPTE time division: negative frames per second and ticks per frame */
+        int fps = -static_cast<std::int8_t>(m_division >> 8);
+        int ticksPerFrame = m_division & 0xff;
+        if (fps <= 0 || ticksPerFrame == 0) {
+            return 0.0;
+        }
+        return tick * 1000.0 / (fps == 29 ? 29.97 : fps) / ticksPerFrame;
+    }
+    if (m_division == 0) {
+        return 0.0;
+    }
+    double ms = 0.0;
+    std::uint32_t lastTick = 0;
+    std::uint32_t usPerQuarter = 500000;
+    for (const auto &t : tempoMap) {
+        if (t.tick >= tick) {
+            break;
+        }
+        ms += (t.tick - lastTick) * (usPerQuarter / 1000.0) / m_division;
+        lastTick = t.tick;
+        usPerQuarter = t.usPerQuarter;
+    }
+    return ms + (tick - lastTick) * (usPerQuarter / 1000.0) / m_division;
+}
@@ -0,0 +1,88 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SMFSCANNER_H
+#define SMFSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "mp_svoxeas_core_visibility.h"
+
+/**
+ * One event of a Standard MIDI File track, as seen by SmfScanner.
+ * For meta events status is 0xff and metaType holds the type; for
+ * SysEx status is 0xf0 or 0xf7. payload points into the scanned data.
+ */
+struct SmfEvent {
+    std::uint32_t tick;
+    int track;
+    std::uint8_t status;
+    std::uint8_t data1;
+    std::uint8_t data2;
+    std::uint8_t metaType;
+    const std::uint8_t *payload;
+    std::uint32_t length;
+};
+
+struct SmfTempo {
+    std::uint32_t tick;
+    std::uint32_t usPerQuarter;
+};
+
+/**
+ * Minimal reader of Standard MIDI Files (plain or wrapped in a RIFF RMID
+ * container) that does not need an EAS instance. Walking the events does
+ * not allocate.
+ */
+class MP_SVOXEAS_CORE_PUBLIC SmfScanner
+{
+public:
+    static const std::uint8_t META_TEXT = 0x01;
+    static const std::uint8_t META_LYRIC = 0x05;
+    static const std::uint8_t META_MARKER = 0x06;
+    static const std::uint8_t META_TEMPO = 0x51;
+
+    SmfScanner();
+
+    bool open(const std::uint8_t *data, std::size_t size);
+    bool isValid() const;
+    int format() const;
+    int tracks() const;
+    int division() const;
+
+    /* visits the events track by track; stops early if the callback returns false */
+    bool forEachEvent(const std::function<bool(const SmfEvent &)> &callback) const;
+
+    bool hasLyrics() const;
+
+    /* tempo changes of all tracks sorted by tick, to be used with millis() */
+    std::vector<SmfTempo> tempoMap() const;
+    double millis(std::uint32_t tick, const std::vector<SmfTempo> &tempoMap) const;
+
+private:
+    const std::uint8_t *m_data;
+    std::size_t m_size;
+    int m_format;
+    int m_tracks;
+    int m_division;
+};
+
+#endif // SMFSCANNER_H
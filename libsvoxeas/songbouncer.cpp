@@ -0,0 +1,240 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "filewrapper.h"
+#include "songbouncer.h"
+#include "synthengine.h"
+
+/* rendered frames per step of the background thread */
+static const std::size_t BOUNCE_STEP = 4096;
+/* longest reverb and release tail kept after the file stops */
+static const int TAIL_MILLIS = 3000;
+
+bool BounceSettings::operator==(const BounceSettings &other) const
+{
+    return soundLib == other.soundLib && soundfont == other.soundfont && reverbType == other.reverbType
+           && reverbWet == other.reverbWet && chorusType == other.chorusType
+           && chorusLevel == other.chorusLevel;
+}
+
+SongBouncer::SongBouncer()
+    : m_state(Idle)
+    , m_cancel(false)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_duration(-1)
+    , m_available(0)
+{}
+
+SongBouncer::~SongBouncer()
+{
+    cancel();
+}
+
+bool SongBouncer::start(const std::string &path,
+                        const BounceSettings &settings,
+                        FinishedCallback finished)
+{
+    if (m_state == Finished && path == m_path && settings == m_settings) {
+        return true;
+    }
+    cancel();
+    m_path = path;
+    m_settings = settings;
+    m_finished = std::move(finished);
+    m_cancel = false;
+    m_duration = -1;
+    m_available = 0;
+    m_state = Running;
+    m_thread = std::thread(&SongBouncer::run, this);
+    return true;
+}
+
+void SongBouncer::load(const std::string &path,
+                       const BounceSettings &settings,
+                       std::vector<std::int16_t> &&samples,
+                       int sampleRate,
+                       int channels,
+                       int duration)
+{
+    cancel();
+    m_path = path;
+    m_settings = settings;
+    m_samples = std::move(samples);
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_duration = duration;
+    m_available.store(channels > 0 ? m_samples.size() / channels : 0, std::memory_order_release);
+    m_state = Finished;
+}
+
+void SongBouncer::cancel()
+{
+    m_cancel = true;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    if (m_state == Running) {
+        m_state = Idle;
+    }
+    if (m_state == Idle) {
+        m_available = 0;
+        std::vector<std::int16_t>().swap(m_samples);
+    }
+}
+
+SongBouncer::State SongBouncer::state() const
+{
+    return State(m_state.load());
+}
+
+const std::string &SongBouncer::path() const
+{
+    return m_path;
+}
+
+const BounceSettings &SongBouncer::settings() const
+{
+    return m_settings;
+}
+
+int SongBouncer::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+int SongBouncer::channels() const
+{
+    return m_channels;
+}
+
+int SongBouncer::duration() const
+{
+    return m_duration;
+}
+
+std::size_t SongBouncer::availableFrames() const
+{
+    return m_available.load(std::memory_order_acquire);
+}
+
+const std::int16_t *SongBouncer::samples() const
+{
+    return m_samples.data();
+}
+
+std::size_t SongBouncer::mix(std::int16_t *output, std::size_t position, std::size_t frames) const
+{
+    const std::size_t available = availableFrames();
+    if (position >= available) {
+        return 0;
+    }
+    const std::size_t count = std::min(frames, available - position);
+    const int channels = m_channels;
+    const std::int16_t *src = m_samples.data() + position * channels;
+    for (std::size_t i = 0; i < count * channels; ++i) {
+        const int sum = output[i] + src[i];
+        output[i] = std::int16_t(std::max(-32768, std::min(32767, sum)));
+    }
+    return count;
+}
+
+void SongBouncer::run()
+{
+    SynthEngine engine;
+    EAS_HANDLE handle = nullptr;
+    EAS_I32 playTime = 0;
+    if (!engine.init(m_settings.soundLib,
+                     m_settings.soundfont.empty() ? nullptr : m_settings.soundfont.c_str())) {
+        m_state = Failed;
+        return;
+    }
+    /* the file drives the engine, so it must never be idled */
+    engine.setIdleDetection(false);
+    if (m_settings.reverbType >= 0) {
+        engine.setReverb(m_settings.reverbType);
+    }
+    if (m_settings.reverbWet >= 0) {
+        engine.setReverbWet(m_settings.reverbWet);
+    }
+    if (m_settings.chorusType >= 0) {
+        engine.setChorus(m_settings.chorusType);
+    }
+    if (m_settings.chorusLevel >= 0) {
+        engine.setChorusLevel(m_settings.chorusLevel);
+    }
+
+    FileWrapper file(m_path.c_str());
+    if (!file.ok() || EAS_OpenFile(engine.easData(), file.getLocator(), &handle) != EAS_SUCCESS) {
+        m_state = Failed;
+        return;
+    }
+    if (EAS_Prepare(engine.easData(), handle) != EAS_SUCCESS
+        || EAS_ParseMetaData(engine.easData(), handle, &playTime) != EAS_SUCCESS) {
+        EAS_CloseFile(engine.easData(), handle);
+        m_state = Failed;
+        return;
+    }
+
+    const int channels = engine.channels();
+    const std::size_t rate = engine.sampleRate();
+    const std::size_t capacity = (std::size_t(playTime) + TAIL_MILLIS) * rate / 1000 + BOUNCE_STEP;
+    m_samples.assign(capacity * channels, 0);
+    m_sampleRate = int(rate);
+    m_channels = channels;
+    m_duration = playTime;
+
+    std::size_t position = 0;
+    std::size_t tailEnd = 0;
+    while (!m_cancel && position < capacity) {
+        const std::size_t frames = std::min(BOUNCE_STEP, capacity - position);
+        std::int16_t *dest = m_samples.data() + position * channels;
+        engine.render(dest, frames);
+        position += frames;
+        m_available.store(position, std::memory_order_release);
+
+        if (tailEnd == 0) {
+            EAS_STATE easState = EAS_STATE_EMPTY;
+            EAS_State(engine.easData(), handle, &easState);
+            if (easState == EAS_STATE_STOPPED || easState == EAS_STATE_ERROR
+                || easState == EAS_STATE_EMPTY) {
+                tailEnd = std::min(capacity, position + TAIL_MILLIS * rate / 1000);
+            }
+        } else {
+            /* the tail ends early as soon as a whole step is silent */
+            const bool silent = std::all_of(dest, dest + frames * channels, [](std::int16_t s) {
+                return std::abs(s) <= 1;
+            });
+            if (silent || position >= tailEnd) {
+                break;
+            }
+        }
+    }
+    EAS_CloseFile(engine.easData(), handle);
+    if (m_cancel) {
+        m_state = Idle;
+        return;
+    }
+    m_state = Finished;
+    if (m_finished) {
+        m_finished(*this);
+    }
+}
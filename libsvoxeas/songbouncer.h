@@ -0,0 +1,106 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SONGBOUNCER_H
+#define SONGBOUNCER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mp_svoxeas_tools_visibility.h"
+
+/* everything besides the MIDI file that changes the rendered audio */
+struct MP_SVOXEAS_TOOLS_PUBLIC BounceSettings {
+    int soundLib{1};
+    std::string soundfont;
+    int reverbType{-1}; // -1 keeps the EAS default
+    int reverbWet{-1};
+    int chorusType{-1};
+    int chorusLevel{-1};
+
+    bool operator==(const BounceSettings &other) const;
+    bool operator!=(const BounceSettings &other) const { return !(*this == other); }
+};
+
+/**
+ * Renders a whole MIDI file, faster than real time, into an in-memory
+ * PCM buffer using a private engine on a background thread. The frames
+ * may be read while the rendering goes on; the result of the last file
+ * is kept, so replaying it costs nothing.
+ */
+class MP_SVOXEAS_TOOLS_PUBLIC SongBouncer
+{
+public:
+    enum State { Idle, Running, Finished, Failed };
+    /* called on the background thread when a file has been completely rendered */
+    typedef std::function<void(const SongBouncer &bouncer)> FinishedCallback;
+
+    SongBouncer();
+    ~SongBouncer();
+
+    /* returns at once; reuses the previous result for the same file and settings */
+    bool start(const std::string &path,
+               const BounceSettings &settings,
+               FinishedCallback finished = nullptr);
+    /* takes a result rendered earlier, for instance from a cache */
+    void load(const std::string &path,
+              const BounceSettings &settings,
+              std::vector<std::int16_t> &&samples,
+              int sampleRate,
+              int channels,
+              int duration);
+    void cancel();
+
+    State state() const;
+    const std::string &path() const;
+    const BounceSettings &settings() const;
+    int sampleRate() const;
+    int channels() const;
+    /* file length in milliseconds, or -1 until it is known */
+    int duration() const;
+    /* frames rendered so far; all of them once the state is Finished */
+    std::size_t availableFrames() const;
+    /* the rendered frames; only stable once the state is Finished */
+    const std::int16_t *samples() const;
+
+    /* adds the frames from position to output, saturating; returns the frames mixed */
+    std::size_t mix(std::int16_t *output, std::size_t position, std::size_t frames) const;
+
+private:
+    void run();
+
+    std::thread m_thread;
+    std::string m_path;
+    BounceSettings m_settings;
+    FinishedCallback m_finished;
+    std::atomic<int> m_state;
+    std::atomic<bool> m_cancel;
+    std::atomic<int> m_sampleRate;
+    std::atomic<int> m_channels;
+    std::atomic<int> m_duration;
+    /* sized once before the first frame is published, then only appended */
+    std::vector<std::int16_t> m_samples;
+    std::atomic<std::size_t> m_available;
+};
+
+#endif // SONGBOUNCER_H
@@ -0,0 +1,236 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "eas.h"
+#include "smfscanner.h"
+#include "stemrenderer.h"
+#include "synthengine.h"
+
+/* rendered frames per step of a worker */
+static const std::size_t STEM_STEP = 4096;
+/* longest reverb and release tail kept after the last event, as SongBouncer */
+static const int TAIL_MILLIS = 3000;
+
+StemRenderer::StemRenderer()
+    : m_noteChannels(0)
+    , m_lengthMicros(0)
+    , m_cancel(false)
+{}
+
+bool StemRenderer::open(const char *path)
+{
+    m_messages.clear();
+    m_noteChannels = 0;
+    m_lengthMicros = 0;
+    std::FILE *file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::vector<std::uint8_t> data;
+    std::uint8_t buffer[65536];
+    std::size_t count;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    std::fclose(file);
+
+    SmfScanner smf;
+    if (!smf.open(data.data(), data.size())) {
+        return false;
+    }
+    const auto tempoMap = smf.tempoMap();
+    smf.forEachEvent([&](const SmfEvent &ev) {
+        const std::int64_t micros = std::llround(smf.millis(ev.tick, tempoMap) * 1000.0);
+        m_lengthMicros = std::max(m_lengthMicros, micros);
+        TimedMessage timed{micros, MidiMessage{}};
+        if (ev.status >= 0x80 && ev.status < 0xf0) {
+            const int type = ev.status & 0xf0;
+            timed.message.length = (type == 0xc0 || type == 0xd0) ? 2 : 3;
+            timed.message.data[0] = ev.status;
+            timed.message.data[1] = ev.data1;
+            timed.message.data[2] = ev.data2;
+            if (type == 0x90 && ev.data2 > 0) {
+                m_noteChannels |= 1 << (ev.status & 0x0f);
+            }
+        } else if (ev.status == 0xf0 && ev.length < std::uint32_t(MidiMessage::MAX_LENGTH)) {
+            /* the file stores the length instead of the status byte */
+            timed.message.length = std::uint8_t(ev.length + 1);
+            timed.message.data[0] = ev.status;
+            memcpy(timed.message.data + 1, ev.payload, ev.length);
+        } else {
+            return true;
+        }
+        m_messages.push_back(timed);
+        return true;
+    });
+    /* the tracks are visited one after another */
+    std::stable_sort(m_messages.begin(), m_messages.end(), [](const auto &a, const auto &b) {
+        return a.micros < b.micros;
+    });
+    return true;
+}
+
+std::vector<int> StemRenderer::noteChannels() const
+{
+    std::vector<int> result;
+    for (int chan = 0; chan < 16; ++chan) {
+        if (m_noteChannels & (1 << chan)) {
+            result.push_back(chan);
+        }
+    }
+    return result;
+}
+
+int StemRenderer::duration() const
+{
+    return int(m_lengthMicros / 1000);
+}
+
+bool StemRenderer::render(const std::vector<int> &channels,
+                          const BounceSettings &settings,
+                          int threads,
+                          const Sink &sink)
+{
+    m_cancel = false;
+    m_stems.clear();
+    for (int chan : channels) {
+        m_stems.push_back(Stem{chan, 0, 0, 0.0, false});
+    }
+    /* each worker takes the next stem not yet started */
+    std::atomic<std::size_t> next{0};
+    const auto worker = [&] {
+        for (std::size_t i = next++; i < m_stems.size(); i = next++) {
+            renderStem(m_stems[i], settings, sink);
+        }
+    };
+    const std::size_t workers = std::min<std::size_t>(std::max(threads, 1), m_stems.size());
+    std::vector<std::thread> pool;
+    for (std::size_t i = 1; i < workers; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    return !m_cancel && std::all_of(m_stems.cbegin(), m_stems.cend(), [](const Stem &stem) {
+        return stem.ok;
+    });
+}
+
+void StemRenderer::cancel()
+{
+    m_cancel = true;
+}
+
+int StemRenderer::sampleRate() const
+{
+    return int(EAS_Config()->sampleRate);
+}
+
+int StemRenderer::audioChannels() const
+{
+    return int(EAS_Config()->numChannels);
+}
+
+const std::vector<StemRenderer::Stem> &StemRenderer::stems() const
+{
+    return m_stems;
+}
+
+void StemRenderer::renderStem(Stem &stem, const BounceSettings &settings, const Sink &sink)
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    SynthEngine engine;
+    if (!engine.init(settings.soundLib,
+                     settings.soundfont.empty() ? nullptr : settings.soundfont.c_str())) {
+        return;
+    }
+    /* timed messages, from the start of their block, and no idle blocks */
+    engine.setDeterministic(true);
+    if (settings.reverbType >= 0) {
+        engine.setReverb(settings.reverbType);
+    }
+    if (settings.reverbWet >= 0) {
+        engine.setReverbWet(settings.reverbWet);
+    }
+    if (settings.chorusType >= 0) {
+        engine.setChorus(settings.chorusType);
+    }
+    if (settings.chorusLevel >= 0) {
+        engine.setChorusLevel(settings.chorusLevel);
+    }
+
+    const int channels = engine.channels();
+    const std::int64_t rate = engine.sampleRate();
+    const std::int64_t songEnd = m_lengthMicros * rate / 1000000;
+    std::vector<std::int16_t> buffer(STEM_STEP * channels);
+    std::size_t nextMessage = 0;
+    std::int64_t position = 0;
+    std::int64_t tailEnd = 0;
+    stem.ok = true;
+    while (!m_cancel) {
+        std::size_t frames = STEM_STEP;
+        while (nextMessage < m_messages.size()) {
+            const TimedMessage &timed = m_messages[nextMessage];
+            const std::int64_t frame = timed.micros * rate / 1000000;
+            if (frame >= position + std::int64_t(STEM_STEP)) {
+                break;
+            }
+            const std::uint8_t status = timed.message.data[0];
+            if (stem.channel == MIX || status == 0xf0 || (status & 0x0f) == stem.channel) {
+                if (!engine.writeMIDI(timed.message.data, timed.message.length, frame)) {
+                    /* the queue is full: render up to this message, which drains it */
+                    frames = std::size_t(std::max<std::int64_t>(engine.blockFrames(), frame - position));
+                    break;
+                }
+                ++stem.events;
+            }
+            ++nextMessage;
+        }
+        engine.render(buffer.data(), frames);
+        if (sink && !sink(stem.channel, buffer.data(), frames)) {
+            stem.ok = false;
+            break;
+        }
+        position += frames;
+        if (nextMessage < m_messages.size() || position < songEnd) {
+            continue;
+        }
+        if (tailEnd == 0) {
+            tailEnd = position + TAIL_MILLIS * rate / 1000;
+        }
+        /* the tail ends early as soon as a whole step is silent */
+        const bool silent = std::all_of(buffer.cbegin(),
+                                        buffer.cbegin() + frames * channels,
+                                        [](std::int16_t s) { return std::abs(s) <= 1; });
+        if (silent || position >= tailEnd) {
+            break;
+        }
+    }
+    stem.frames = std::size_t(position);
+    stem.ok = stem.ok && !m_cancel;
+    stem.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
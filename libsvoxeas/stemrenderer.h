@@ -0,0 +1,96 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STEMRENDERER_H
+#define STEMRENDERER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "midiparser.h"
+#include "mp_svoxeas_tools_visibility.h"
+#include "songbouncer.h"
+
+/**
+ * Renders each MIDI channel of a Standard MIDI File into a stem of its
+ * own, on a private engine per stem and several stems at once on a pool
+ * of threads. The file is read and parsed only once: every stem gets the
+ * messages of its channel, and the SysEx messages, at the output frames
+ * given by the tempo map of the file. So the stems are time aligned, and
+ * the whole song rendered the same way is the reference mix.
+ */
+class MP_SVOXEAS_TOOLS_PUBLIC StemRenderer
+{
+public:
+    /* the stem of all the channels together */
+    static const int MIX = -1;
+
+    /* called on the worker threads with the next frames of a stem; the
+       calls for one stem never overlap; returning false fails the stem */
+    typedef std::function<bool(int channel, const std::int16_t *samples, std::size_t frames)> Sink;
+
+    struct Stem {
+        int channel;
+        std::size_t events;
+        std::size_t frames;
+        /* rendering time on its thread */
+        double seconds;
+        bool ok;
+    };
+
+    StemRenderer();
+
+    bool open(const char *path);
+    /* MIDI channels with at least one note, ascending */
+    std::vector<int> noteChannels() const;
+    /* time of the last event in milliseconds */
+    int duration() const;
+    /* format of the stems, from the EAS library configuration */
+    int sampleRate() const;
+    int audioChannels() const;
+
+    /* blocks until all the stems are rendered, with up to threads workers;
+       returns false when any of them failed or was cancelled */
+    bool render(const std::vector<int> &channels,
+                const BounceSettings &settings,
+                int threads,
+                const Sink &sink);
+    /* any thread, while render() is running */
+    void cancel();
+    /* of the last render() call, in the same order as its channels */
+    const std::vector<Stem> &stems() const;
+
+private:
+    struct TimedMessage {
+        std::int64_t micros;
+        MidiMessage message;
+    };
+
+    void renderStem(Stem &stem, const BounceSettings &settings, const Sink &sink);
+
+    std::vector<TimedMessage> m_messages;
+    std::uint16_t m_noteChannels;
+    std::int64_t m_lengthMicros;
+    std::vector<Stem> m_stems;
+    std::atomic<bool> m_cancel;
+};
+
+#endif // STEMRENDERER_H
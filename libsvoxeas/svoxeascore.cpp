@@ -0,0 +1,120 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+
+#include "svoxeascore.h"
+#include "synthengine.h"
+
+struct svoxeas_engine
+{
+    SynthEngine engine;
+};
+
+svoxeas_engine *svoxeas_create(int sound_lib, const char *dls_file)
+{
+    auto handle = new (std::nothrow) svoxeas_engine;
+    if (handle != nullptr && !handle->engine.init(sound_lib, dls_file)) {
+        delete handle;
+        handle = nullptr;
+    }
+    return handle;
+}
+
+void svoxeas_destroy(svoxeas_engine *engine)
+{
+    delete engine;
+}
+
+int svoxeas_sample_rate(const svoxeas_engine *engine)
+{
+    return engine->engine.sampleRate();
+}
+
+int svoxeas_channels(const svoxeas_engine *engine)
+{
+    return engine->engine.channels();
+}
+
+void svoxeas_set_reverb(svoxeas_engine *engine, int type, int wet)
+{
+    engine->engine.setReverbWet(wet);
+    engine->engine.setReverb(type);
+}
+
+void svoxeas_set_chorus(svoxeas_engine *engine, int type, int level)
+{
+    engine->engine.setChorusLevel(level);
+    engine->engine.setChorus(type);
+}
+
+int svoxeas_write_midi(svoxeas_engine *engine, const uint8_t *data, size_t length)
+{
+    return engine->engine.writeMIDI(data, length) ? 0 : -1;
+}
+
+size_t svoxeas_render_s16(svoxeas_engine *engine, int16_t *output, size_t frames)
+{
+    return engine->engine.render(output, frames);
+}
+
+size_t svoxeas_render_float(svoxeas_engine *engine, float *output, size_t frames)
+{
+    return engine->engine.render(output, frames);
+}
+
+int svoxeas_write_midi_at(svoxeas_engine *engine, const uint8_t *data, size_t length, int64_t frame)
+{
+    return engine->engine.writeMIDI(data, length, frame) ? 0 : -1;
+}
+
+int64_t svoxeas_rendered_frames(const svoxeas_engine *engine)
+{
+    return engine->engine.renderedFrames();
+}
+
+void svoxeas_set_deterministic(svoxeas_engine *engine, int enabled)
+{
+    engine->engine.setDeterministic(enabled != 0);
+}
+
+int svoxeas_reset(svoxeas_engine *engine)
+{
+    return engine->engine.reset() ? 0 : -1;
+}
+
+void svoxeas_set_checksum_interval(svoxeas_engine *engine, int blocks)
+{
+    engine->engine.checksum().setInterval(blocks);
+}
+
+int svoxeas_take_checksum(svoxeas_engine *engine, uint64_t *first_block, uint64_t *value)
+{
+    RenderChecksumEntry entry;
+    if (!engine->engine.checksum().take(entry)) {
+        return 0;
+    }
+    *first_block = entry.firstBlock;
+    *value = entry.value;
+    return 1;
+}
+
+uint64_t svoxeas_checksum(const svoxeas_engine *engine)
+{
+    return engine->engine.checksum().total();
+}
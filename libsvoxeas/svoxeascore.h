@@ -0,0 +1,76 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SVOXEASCORE_H
+#define SVOXEASCORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mp_svoxeas_core_visibility.h"
+
+/*
+ * Plain C interface of the SynthEngine, for hosts that are not written in
+ * C++ or Qt. svoxeas_write_midi() may be called from any thread; the
+ * render functions must always be called from the same audio thread.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct svoxeas_engine svoxeas_engine;
+
+MP_SVOXEAS_CORE_PUBLIC svoxeas_engine *svoxeas_create(int sound_lib, const char *dls_file);
+MP_SVOXEAS_CORE_PUBLIC void svoxeas_destroy(svoxeas_engine *engine);
+
+MP_SVOXEAS_CORE_PUBLIC int svoxeas_sample_rate(const svoxeas_engine *engine);
+MP_SVOXEAS_CORE_PUBLIC int svoxeas_channels(const svoxeas_engine *engine);
+
+MP_SVOXEAS_CORE_PUBLIC void svoxeas_set_reverb(svoxeas_engine *engine, int type, int wet);
+MP_SVOXEAS_CORE_PUBLIC void svoxeas_set_chorus(svoxeas_engine *engine, int type, int level);
+
+/* returns 0 on success, -1 if the message was not queued */
+MP_SVOXEAS_CORE_PUBLIC int svoxeas_write_midi(svoxeas_engine *engine, const uint8_t *data, size_t length);
+
+/* queued for the output frame; the frame is honoured in deterministic mode only */
+MP_SVOXEAS_CORE_PUBLIC int svoxeas_write_midi_at(svoxeas_engine *engine, const uint8_t *data, size_t length, int64_t frame);
+/* output frames rendered since the engine was created, across resets */
+MP_SVOXEAS_CORE_PUBLIC int64_t svoxeas_rendered_frames(const svoxeas_engine *engine);
+
+/* interleaved output; return the number of frames written */
+MP_SVOXEAS_CORE_PUBLIC size_t svoxeas_render_s16(svoxeas_engine *engine, int16_t *output, size_t frames);
+MP_SVOXEAS_CORE_PUBLIC size_t svoxeas_render_float(svoxeas_engine *engine, float *output, size_t frames);
+
+/* bit-exact rendering: see SynthEngine::setDeterministic() and reset();
+   the frame count is not restarted, so timed messages keep counting from
+   svoxeas_rendered_frames() */
+MP_SVOXEAS_CORE_PUBLIC void svoxeas_set_deterministic(svoxeas_engine *engine, int enabled);
+MP_SVOXEAS_CORE_PUBLIC int svoxeas_reset(svoxeas_engine *engine);
+
+/* a checksum every interval blocks (0 disables them); svoxeas_take_checksum
+   returns 1 and fills the arguments when a checksum was available */
+MP_SVOXEAS_CORE_PUBLIC void svoxeas_set_checksum_interval(svoxeas_engine *engine, int blocks);
+MP_SVOXEAS_CORE_PUBLIC int svoxeas_take_checksum(svoxeas_engine *engine, uint64_t *first_block, uint64_t *value);
+MP_SVOXEAS_CORE_PUBLIC uint64_t svoxeas_checksum(const svoxeas_engine *engine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SVOXEASCORE_H
@@ -17,8 +17,43 @@
 */
 
 //#include <QDebug>
+#include <QFile>
+#include <QLoggingCategory>
+#include <cerrno>
+#include <cstring>
 #include "synthcontroller.h"
 #include "synthrenderer.h"
+#include "nulloutput.h"
+#include "rtmemory.h"
+#include "tracescope.h"
+#if defined(HAVE_ALSA)
+#include "alsaoutput.h"
+#endif
+
+/* polling period of the metadata events, in milliseconds */
+static const int META_DATA_INTERVAL = 10;
+/* silent blocks rendered before the audio starts, in RT memory mode */
+static const int WARM_UP_BLOCKS = 16;
+/* stack the audio thread faults in before its first block */
+static const std::size_t STACK_PREFAULT_SIZE = 128 * 1024;
+/* repeats of the same render error are folded into one message per interval */
+static const qint64 ERROR_LOG_INTERVAL = 1000;
+/* a burst of underruns writes the flight record once per interval */
+static const qint64 FLIGHT_DUMP_INTERVAL = 1000;
+
+Q_LOGGING_CATEGORY(lcRender, "sonivoxeas.render")
+Q_LOGGING_CATEGORY(lcMidi, "sonivoxeas.midi")
+
+static const QLoggingCategory &errorCategory(int code)
+{
+    switch (code) {
+    case RenderErrors::WriteMidiFailed:
+    case RenderErrors::MidiQueueFull:
+        return lcMidi();
+    default:
+        return lcRender();
+    }
+}
 
 SynthController::SynthController(int bufTime, QObject *parent)
     : QObject(parent)
@@ -42,11 +77,28 @@ SynthController::SynthController(int bufTime, QObject *parent)
     connect(&m_stallDetector, &QTimer::timeout, this, [=]{
         if (m_running) {
             if (m_renderer->lastBufferSize() == 0) {
+                recordGlitch(FlightRecorder::Stall);
                 emit stallDetected();
             }
             m_renderer->resetLastBufferSize();
         }
     });
+    connect(&m_metaDataTimer, &QTimer::timeout, this, &SynthController::dispatchMetaEvents);
+    connect(&m_metaDataTimer, &QTimer::timeout, this, &SynthController::checkPlayers);
+    connect(&m_metaDataTimer, &QTimer::timeout, this, &SynthController::drainRenderErrors);
+    connect(&m_metaDataTimer, &QTimer::timeout, this, &SynthController::drainChecksums);
+    connect(&m_metaDataTimer, &QTimer::timeout, this, &SynthController::flushCapture);
+    connect(&m_metaDataTimer, &QTimer::timeout, this, [=] {
+        if (m_renderer) {
+            m_renderer->emitSnapshotSignals();
+        }
+    });
+    connect(&m_metaDataTimer, &QTimer::timeout, this, [=] {
+        if (m_renderer) {
+            m_renderer->flightRecorder().record(FlightRecorder::BufferFill, queuedFrames());
+        }
+    });
+    m_errorClock.start();
     connectRendererSignals();
 }
 
@@ -56,6 +108,7 @@ SynthController::~SynthController()
         if (!m_renderer->stopped()) {
             m_renderer->stop();
         }
+        unlockRealtimeMemory();
         delete m_renderer;
         m_renderer = nullptr;
     }
@@ -66,41 +119,138 @@ void
 SynthController::start()
 {
     //qDebug() << Q_FUNC_INFO;
-    auto bufferBytes = m_format.bytesForDuration(m_requestedBufferTime * 1000);
-    // qDebug() << Q_FUNC_INFO
-    //          << "Requested buffer size:" << bufferBytes << "bytes,"
-    //          << m_requestedBufferTime << "milliseconds";
+    TraceScope traceScope("SynthController::start");
     if (!m_renderer) {
         m_renderer = new SynthRenderer();
+        m_renderer->setIdleDetection(m_idleDetection);
+        m_renderer->setPrewarm(m_prewarm);
+        m_renderer->setBounce(m_bounce);
+        m_renderer->setRenderCache(m_renderCache);
+        m_renderer->setDeterministic(m_deterministic);
+        m_renderer->checksum().setInterval(m_checksumInterval);
+        if (!m_captureFile.isEmpty()) {
+            m_renderer->startCapture(m_captureFile);
+        }
         connectRendererSignals();
     }
+    startOutput();
+    emit synthStarted();
+}
+
+void
+SynthController::stop()
+{
+    //qDebug() << Q_FUNC_INFO;
+    TraceScope traceScope("SynthController::stop");
+    stopOutput();
+    if (m_renderer) {
+        m_renderer->disconnect();
+        /* the render thread is gone, so the last partial window can be taken */
+        m_renderer->checksum().flush();
+        drainChecksums();
+        m_renderer->stopCapture();
+        drainRenderErrors();
+        RenderErrors::Counters counters;
+        m_renderer->errors().read(counters);
+        for (int i = 0; i < RenderErrors::CodeCount; ++i) {
+            m_errorTotals.count[i] += counters.count[i];
+        }
+        m_errorTotals.dropped += counters.dropped;
+    }
+    delete m_renderer;
+    m_renderer = nullptr;
+}
+
+/* the renderer is kept, with its settings, playlist and MIDI input */
+void
+SynthController::startOutput()
+{
+    auto bufferBytes = m_format.bytesForDuration(m_requestedBufferTime * 1000);
+    // qDebug() << Q_FUNC_INFO
+    //          << "Requested buffer size:" << bufferBytes << "bytes,"
+    //          << m_requestedBufferTime << "milliseconds";
     if (m_renderer) {
-        m_renderer->reserveBuffer(bufferBytes * 2);
         if(m_renderer->stopped()) {
             m_renderer->start();
         }
+        if (m_realtimeMemory) {
+            lockRealtimeMemory();
+        }
     }
-    if (!m_audioOutput) {
-        initAudio();
+    qint64 bufferTime;
+    if (m_nullDevice) {
+        if (!m_nullOutput) {
+            m_nullOutput = new NullOutput(m_format, this);
+            connect(m_nullOutput, &NullOutput::underrunDetected, this, [=] {
+                if (m_running) {
+                    recordGlitch(FlightRecorder::Underrun);
+                    emit underrunDetected();
+                }
+            });
+        }
+        m_nullOutput->setBufferTime(m_requestedBufferTime);
+        m_nullOutput->setPeriodSize(m_periodSize);
+        m_nullOutput->start(m_renderer);
+        bufferTime = qMax<qint64>(1, qint64(m_nullOutput->bufferSize()) * 1000 / m_format.sampleRate());
+    } else
+#if defined(HAVE_ALSA)
+    if (!m_alsaDevice.isEmpty()) {
+        if (!m_alsaOutput) {
+            m_alsaOutput = new AlsaOutput(m_format, this);
+            connect(m_alsaOutput, &AlsaOutput::underrunDetected, this, [=] {
+                if (m_running) {
+                    recordGlitch(FlightRecorder::Underrun);
+                    emit underrunDetected();
+                }
+            });
+        }
+        m_alsaOutput->setDeviceName(m_alsaDevice);
+        m_alsaOutput->setBufferTime(m_requestedBufferTime);
+        m_alsaOutput->setPeriodSize(m_periodSize);
+        if (m_periodCount > 0) {
+            m_alsaOutput->setPeriodCount(m_periodCount);
+        }
+        if (!m_alsaOutput->start(m_renderer)) {
+            qCritical() << Q_FUNC_INFO << "cannot start the ALSA output" << m_alsaDevice;
+        }
+        bufferTime = qMax<qint64>(1, qint64(m_alsaOutput->bufferSize()) * 1000 / m_format.sampleRate());
+    } else
+#endif
+    {
+        if (!m_audioOutput) {
+            initAudio();
+        }
+        m_audioOutput->setBufferSize(bufferBytes);
+        m_audioOutput->start(m_renderer);
+        bufferTime = m_format.durationForBytes(m_audioOutput->bufferSize()) / 1000;
     }
-    m_audioOutput->setBufferSize(bufferBytes);
-    m_audioOutput->start(m_renderer);
-    auto bufferTime = m_format.durationForBytes(m_audioOutput->bufferSize()) / 1000;
     // qDebug() << Q_FUNC_INFO << "Applied Audio Output buffer size:" << m_audioOutput->bufferSize()
     //          << "bytes," << bufferTime << "milliseconds";
     QTimer::singleShot(bufferTime * 2, this, [=]{
         m_running = true;
         m_stallDetector.start(bufferTime * 4);
      });
-    emit synthStarted();
+    m_metaDataTimer.start(META_DATA_INTERVAL);
 }
 
 void
-SynthController::stop()
+SynthController::stopOutput()
 {
-    //qDebug() << Q_FUNC_INFO;
     m_running = false;
     m_stallDetector.stop();
+    m_metaDataTimer.stop();
+    if (m_nullOutput) {
+        m_nullOutput->stop();
+        delete m_nullOutput;
+        m_nullOutput = nullptr;
+    }
+#if defined(HAVE_ALSA)
+    if (m_alsaOutput) {
+        m_alsaOutput->stop();
+        delete m_alsaOutput;
+        m_alsaOutput = nullptr;
+    }
+#endif
     if (m_audioOutput) {
         m_audioOutput->stop();
         delete m_audioOutput;
@@ -108,10 +258,8 @@ SynthController::stop()
     }
     if (m_renderer && !m_renderer->stopped()) {
         m_renderer->stop();
-        m_renderer->disconnect();
     }
-    delete m_renderer;
-    m_renderer = nullptr;
+    unlockRealtimeMemory();
 }
 
 void
@@ -134,6 +282,7 @@ SynthController::initAudio()
 #endif
             // qDebug() << "Audio Output state:" << state << "error:" << m_audioOutput->error();
             if (m_running && (m_audioOutput->error() == QAudio::UnderrunError)) {
+                recordGlitch(FlightRecorder::Underrun);
                 emit underrunDetected();
             }
         });
@@ -178,6 +327,153 @@ void SynthController::connectRendererSignals()
     }
 }
 
+/* delivers the metadata events already heard, after the audio output latency */
+void SynthController::dispatchMetaEvents()
+{
+    if (!m_renderer) {
+        return;
+    }
+    /* both in frames handed to the audio output */
+    qint64 played = m_renderer->deliveredFrames() - queuedFrames();
+    MetaEvent ev;
+    while (m_renderer->takeMetaEvent(played, ev)) {
+        emit metaDataEvent(ev.type,
+                           QString::fromLatin1(ev.text),
+                           ev.value,
+                           ev.frame * 1000 / m_format.sampleRate());
+    }
+}
+
+/* the render path only flags the players that reached their end */
+void SynthController::checkPlayers()
+{
+    if (!m_renderer) {
+        return;
+    }
+    for (int i = 0; i < SynthRenderer::MAX_PLAYERS; ++i) {
+        const int state = m_renderer->playerState(i);
+        const bool stopped = state == SynthRenderer::PlayerStopped && m_playerStates[i] != state;
+        m_playerStates[i] = state;
+        if (stopped) {
+            emit playerStopped(i);
+        }
+    }
+}
+
+void SynthController::drainRenderErrors()
+{
+    if (!m_renderer) {
+        return;
+    }
+    const qint64 now = m_errorClock.elapsed();
+    RenderError error;
+    while (m_renderer->errors().take(error)) {
+        if (error.code >= RenderErrors::CodeCount) {
+            continue;
+        }
+        ErrorLogState &state = m_errorLog[error.code];
+        if (state.lastLogged >= 0 && now - state.lastLogged < ERROR_LOG_INTERVAL) {
+            ++state.suppressed;
+            state.lastResult = error.result;
+            continue;
+        }
+        qCWarning(errorCategory(error.code)) << RenderErrors::codeName(error.code) << "error:" << error.result;
+        state.lastLogged = now;
+        state.suppressed = 0;
+    }
+    /* summaries of the repeats, once the interval has elapsed */
+    for (int code = 0; code < RenderErrors::CodeCount; ++code) {
+        ErrorLogState &state = m_errorLog[code];
+        if (state.suppressed > 0 && now - state.lastLogged >= ERROR_LOG_INTERVAL) {
+            qCWarning(errorCategory(code)) << RenderErrors::codeName(code) << "error repeated"
+                                           << state.suppressed << "times, last:" << state.lastResult;
+            state.lastLogged = now;
+            state.suppressed = 0;
+        }
+    }
+}
+
+void SynthController::drainChecksums()
+{
+    if (!m_renderer) {
+        return;
+    }
+    RenderChecksumEntry entry;
+    while (m_renderer->checksum().take(entry)) {
+        emit renderChecksum(entry.firstBlock, entry.blocks, entry.value);
+    }
+}
+
+void SynthController::setFlightRecordFile(const QString &fileName)
+{
+    m_flightRecordFile = fileName;
+}
+
+QString SynthController::flightRecordFile() const
+{
+    return m_flightRecordFile;
+}
+
+bool SynthController::dumpFlightRecord(const QString &reason)
+{
+    if (!m_renderer) {
+        return false;
+    }
+    if (!m_renderer->flightRecorder().dump(QFile::encodeName(m_flightRecordFile).constData(),
+                                           reason.toUtf8().constData())) {
+        qWarning() << Q_FUNC_INFO << "cannot write" << m_flightRecordFile;
+        return false;
+    }
+    return true;
+}
+
+void SynthController::recordGlitch(FlightRecorder::Type type)
+{
+    if (type == FlightRecorder::Underrun) {
+        ++m_underruns;
+    } else if (type == FlightRecorder::Stall) {
+        ++m_stalls;
+    }
+    m_renderer->flightRecorder().record(type);
+    const qint64 now = m_errorClock.elapsed();
+    if (m_lastFlightDump < 0 || now - m_lastFlightDump >= FLIGHT_DUMP_INTERVAL) {
+        m_lastFlightDump = now;
+        if (dumpFlightRecord(QString::fromLatin1(FlightRecorder::typeName(type)))) {
+            qCWarning(lcRender) << "flight record written to" << m_flightRecordFile;
+        }
+    }
+}
+
+/* file writes stay out of the MIDI and audio threads */
+void SynthController::flushCapture()
+{
+    if (m_renderer && m_renderer->capture().isActive()) {
+        m_renderer->capture().flush();
+    }
+}
+
+/* frames delivered by the renderer that have not been played yet */
+qint64 SynthController::queuedFrames() const
+{
+    if (m_nullOutput && m_nullOutput->isRunning()) {
+        return m_nullOutput->delay();
+    }
+#if defined(HAVE_ALSA)
+    if (m_alsaOutput && m_alsaOutput->isRunning()) {
+        return m_alsaOutput->delay();
+    }
+#endif
+    if (m_audioOutput) {
+        return m_format.framesForBytes(m_audioOutput->bufferSize() - m_audioOutput->bytesFree());
+    }
+    return 0;
+}
+
+int SynthController::outputLatency() const
+{
+    return queuedFrames() * 1000 / m_format.sampleRate();
+}
+
 #if QT_VERSION < QT_VERSION_CHECK(6,0,0)
 const QAudioDeviceInfo&
 SynthController::audioDevice() const
@@ -211,12 +507,22 @@ SynthController::setAudioDevice(const QAudioDevice &newAudioDevice)
 QStringList SynthController::availableAudioDevices()
 {
     // qDebug() << Q_FUNC_INFO << m_availableDevices.keys();
-    return m_availableDevices.keys();
+#if defined(HAVE_ALSA)
+    return m_availableDevices.keys() + AlsaOutput::availableDevices() + QStringList{NullOutput::DEVICE_NAME};
+#else
+    return m_availableDevices.keys() + QStringList{NullOutput::DEVICE_NAME};
+#endif
 }
 
 QString
 SynthController::audioDeviceName() const
 {
+    if (m_nullDevice) {
+        return NullOutput::DEVICE_NAME;
+    }
+    if (!m_alsaDevice.isEmpty()) {
+        return m_alsaDevice;
+    }
     QString n =
 #if QT_VERSION < QT_VERSION_CHECK(6,0,0)
         m_audioDevice.deviceName();
@@ -231,6 +537,23 @@ void
 SynthController::setAudioDeviceName(const QString newName)
 {
     // qDebug() << Q_FUNC_INFO << newName;
+    if (newName == NullOutput::DEVICE_NAME) {
+        stop();
+        m_alsaDevice.clear();
+        m_nullDevice = true;
+        start();
+        return;
+    }
+    m_nullDevice = false;
+#if defined(HAVE_ALSA)
+    if (AlsaOutput::isAlsaDevice(newName)) {
+        stop();
+        m_alsaDevice = newName;
+        start();
+        return;
+    }
+#endif
+    m_alsaDevice.clear();
     if (m_availableDevices.contains(newName) &&
         (m_audioDevice.isNull() || (audioDeviceName() != newName) )) {
         stop();
@@ -251,12 +574,36 @@ void SynthController::setBufferSize(int milliseconds)
     }
 }
 
+void SynthController::setPeriodSize(int frames)
+{
+    if (frames != m_periodSize) {
+        m_periodSize = frames;
+        if (!m_alsaDevice.isEmpty() || m_nullDevice) {
+            restart();
+        }
+    }
+}
+
+void SynthController::setPeriodCount(int count)
+{
+    if (count != m_periodCount) {
+        m_periodCount = count;
+        if (!m_alsaDevice.isEmpty()) {
+            restart();
+        }
+    }
+}
+
+/* the ALSA output has no volume control of its own: use the device mixer */
 void SynthController::setVolume(int volume)
 {
     //qDebug() << Q_FUNC_INFO << volume;
     qreal linearVolume = QAudio::convertVolume(volume / 100.0,
                                                QAudio::LogarithmicVolumeScale,
                                                QAudio::LinearVolumeScale);
+    if (m_renderer) {
+        m_renderer->flightRecorder().record(FlightRecorder::Parameter, FlightRecorder::Volume, volume);
+    }
     if (m_audioOutput) {
         m_audioOutput->setVolume(linearVolume);
     }
@@ -324,10 +671,18 @@ void SynthController::initChorus(int chorus_type)
     }
 }
 
+/* the engine is replaced, so the output stops meanwhile */
 void SynthController::initSoundLib(int value)
 {
-    if (m_renderer) {
+    if (m_renderer && m_renderer->soundLib() != value) {
+        const bool running = !m_renderer->stopped();
+        if (running) {
+            stopOutput();
+        }
         m_renderer->initSoundLib(value);
+        if (running) {
+            startOutput();
+        }
     }
 }
 
@@ -347,8 +702,15 @@ void SynthController::setChorusLevel(int amount)
 
 void SynthController::initSoundfont(const QString soundfont)
 {
-    if (m_renderer) {
+    if (m_renderer && m_renderer->soundfont() != soundfont) {
+        const bool running = !m_renderer->stopped();
+        if (running) {
+            stopOutput();
+        }
         m_renderer->initSoundfont(soundfont);
+        if (running) {
+            startOutput();
+        }
     }
 }
 
@@ -373,6 +735,283 @@ void SynthController::stopPlayback()
     }
 }
 
+void SynthController::seek(int milliseconds)
+{
+    if (m_renderer) {
+        m_renderer->seek(milliseconds);
+    }
+}
+
+void SynthController::setLoopPoints(int startTime, int endTime)
+{
+    if (m_renderer) {
+        m_renderer->setLoopPoints(startTime, endTime);
+    }
+}
+
+void SynthController::clearLoop()
+{
+    if (m_renderer) {
+        m_renderer->clearLoop();
+    }
+}
+
+void SynthController::setPlaybackRate(qreal factor)
+{
+    if (m_renderer) {
+        m_renderer->setPlaybackRate(factor);
+    }
+}
+
+int SynthController::playbackDuration() const
+{
+    if (m_renderer) {
+        return m_renderer->playbackDuration();
+    }
+    return 0;
+}
+
+bool SynthController::openPlayer(int player, const QString &fileName)
+{
+    if (m_renderer) {
+        return m_renderer->openPlayer(player, fileName);
+    }
+    return false;
+}
+
+void SynthController::closePlayer(int player)
+{
+    if (m_renderer) {
+        m_renderer->closePlayer(player);
+    }
+}
+
+void SynthController::setPlayerVolume(int player, int volume)
+{
+    if (m_renderer) {
+        m_renderer->setPlayerVolume(player, volume);
+    }
+}
+
+void SynthController::setPlayerPaused(int player, bool paused)
+{
+    if (m_renderer) {
+        m_renderer->setPlayerPaused(player, paused);
+    }
+}
+
+void SynthController::seekPlayer(int player, int milliseconds)
+{
+    if (m_renderer) {
+        m_renderer->seekPlayer(player, milliseconds);
+    }
+}
+
+int SynthController::playerState(int player) const
+{
+    if (m_renderer) {
+        return m_renderer->playerState(player);
+    }
+    return SynthRenderer::PlayerClosed;
+}
+
+int SynthController::playerLocation(int player) const
+{
+    if (m_renderer) {
+        return m_renderer->playerLocation(player);
+    }
+    return 0;
+}
+
+int SynthController::playerDuration(int player) const
+{
+    if (m_renderer) {
+        return m_renderer->playerDuration(player);
+    }
+    return 0;
+}
+
+bool SynthController::readSnapshot(SynthSnapshot::State &state) const
+{
+    if (m_renderer) {
+        m_renderer->snapshot().read(state);
+        return true;
+    }
+    return false;
+}
+
+std::uint32_t SynthController::snapshotSerial() const
+{
+    if (m_renderer) {
+        return m_renderer->snapshot().serial();
+    }
+    return 0;
+}
+
+void SynthController::setIdleDetection(bool enabled)
+{
+    m_idleDetection = enabled;
+    if (m_renderer) {
+        m_renderer->setIdleDetection(enabled);
+    }
+}
+
+void SynthController::setPrewarm(bool enabled)
+{
+    m_prewarm = enabled;
+    if (m_renderer) {
+        m_renderer->setPrewarm(enabled);
+    }
+}
+
+void SynthController::setBounce(bool enabled)
+{
+    m_bounce = enabled;
+    if (m_renderer) {
+        m_renderer->setBounce(enabled);
+    }
+}
+
+void SynthController::setRenderCache(bool enabled)
+{
+    m_renderCache = enabled;
+    if (m_renderer) {
+        m_renderer->setRenderCache(enabled);
+    }
+}
+
+void SynthController::setDeterministic(bool enabled)
+{
+    m_deterministic = enabled;
+    if (m_renderer) {
+        m_renderer->setDeterministic(enabled);
+    }
+}
+
+void SynthController::setChecksumInterval(int blocks)
+{
+    m_checksumInterval = blocks;
+    if (m_renderer) {
+        m_renderer->checksum().setInterval(blocks);
+    }
+}
+
+void SynthController::setCaptureFile(const QString &fileName)
+{
+    m_captureFile = fileName;
+    if (m_renderer) {
+        m_renderer->stopCapture();
+        if (!fileName.isEmpty()) {
+            m_renderer->startCapture(fileName);
+        }
+    }
+}
+
+bool SynthController::isIdle() const
+{
+    if (m_renderer) {
+        return m_renderer->isIdle();
+    }
+    return false;
+}
+
+void SynthController::setRealtimeMemory(bool enabled)
+{
+    m_realtimeMemory = enabled;
+}
+
+bool SynthController::realtimeMemory() const
+{
+    return m_realtimeMemory;
+}
+
+qint64 SynthController::lockedMemory() const
+{
+    return m_lockedBytes;
+}
+
+/* before the audio output starts: nothing is rendering yet */
+void SynthController::lockRealtimeMemory()
+{
+    unlockRealtimeMemory();
+    /* the EAS instance and the DLS data are allocated by sonivox, so only
+       locking everything covers them. mlockall is tried first, whatever
+       RLIMIT_MEMLOCK says: a process with CAP_IPC_LOCK is not bound by it.
+       On failure (EPERM, ENOMEM) the renderer object, which embeds the
+       engine block and the queues, is locked alone */
+    std::size_t locked = 0;
+    if (RtMemory::lockAll()) {
+        m_lockedAll = true;
+    } else {
+        const int error = errno;
+        const std::size_t limit = RtMemory::lockLimit();
+        qWarning() << Q_FUNC_INFO << "cannot lock the process memory:" << std::strerror(error)
+                   << "RLIMIT_MEMLOCK:"
+                   << (limit == RtMemory::UNLIMITED ? QStringLiteral("unlimited")
+                                                    : QString::number(limit));
+        locked = RtMemory::lock(m_renderer, sizeof(SynthRenderer));
+        if (locked == 0) {
+            qWarning() << Q_FUNC_INFO << "cannot lock the render memory";
+        }
+    }
+    RtMemory::prefault(m_renderer, sizeof(SynthRenderer));
+    m_renderer->warmUp(WARM_UP_BLOCKS);
+    m_renderer->requestStackPrefault(STACK_PREFAULT_SIZE);
+    /* what the system really holds locked, when it says so */
+    m_lockedBytes = RtMemory::lockedSize();
+    if (m_lockedBytes == 0) {
+        m_lockedBytes = locked;
+    }
+    if (m_lockedAll) {
+        qInfo() << "RT memory:" << m_lockedBytes << "bytes locked by the whole process";
+    } else {
+        qInfo() << "RT memory:" << m_lockedBytes << "bytes locked";
+    }
+}
+
+void SynthController::unlockRealtimeMemory()
+{
+    if (m_lockedAll) {
+        RtMemory::unlockAll();
+    } else if (m_lockedBytes > 0 && m_renderer) {
+        RtMemory::unlock(m_renderer, sizeof(SynthRenderer));
+    }
+    m_lockedAll = false;
+    m_lockedBytes = 0;
+}
+
+void SynthController::readRenderErrors(RenderErrors::Counters &counters) const
+{
+    counters = m_errorTotals;
+    if (m_renderer) {
+        RenderErrors::Counters current;
+        m_renderer->errors().read(current);
+        for (int i = 0; i < RenderErrors::CodeCount; ++i) {
+            counters.count[i] += current.count[i];
+        }
+        counters.dropped += current.dropped;
+    }
+}
+
+quint64 SynthController::underruns() const
+{
+    return m_underruns;
+}
+
+quint64 SynthController::stalls() const
+{
+    return m_stalls;
+}
+
+bool SynthController::readRenderStats(RenderStats::Values &values) const
+{
+    if (m_renderer) {
+        m_renderer->stats().read(values);
+        return true;
+    }
+    return false;
+}
+
 void SynthController::noteOn(int chan, int note, int vel)
 {
     if (m_renderer) {
@@ -393,3 +1032,24 @@ void SynthController::program(int chan, int pgm)
         m_renderer->program(chan, pgm);
     }
 }
+
+void SynthController::controller(int chan, int control, int value)
+{
+    if (m_renderer) {
+        m_renderer->controller(chan, control, value);
+    }
+}
+
+void SynthController::pitchBend(int chan, int value)
+{
+    if (m_renderer) {
+        m_renderer->pitchBend(chan, value);
+    }
+}
+
+void SynthController::midiMessage(const MidiMessage &msg)
+{
+    if (m_renderer) {
+        m_renderer->midiMessage(msg);
+    }
+}
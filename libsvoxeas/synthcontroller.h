@@ -19,6 +19,8 @@
 #ifndef SYNTHCONTROLLER_H
 #define SYNTHCONTROLLER_H
 
+#include <QDir>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QTimer>
 #if QT_VERSION < QT_VERSION_CHECK(6,0,0)
@@ -32,6 +34,9 @@
 #include "mp_svoxeas_visibility.h"
 #include "synthrenderer.h"
 
+class AlsaOutput;
+class NullOutput;
+
 class MP_SVOXEAS_PUBLIC SynthController : public QObject
 {
     Q_OBJECT
@@ -50,6 +55,10 @@ public:
     QString audioDeviceName() const;
     void setAudioDeviceName(const QString newName);
     void setBufferSize(int milliseconds);
+    /* ALSA output only: 0 means default */
+    void setPeriodSize(int frames);
+    void setPeriodCount(int count);
+    int outputLatency() const;
     void setVolume(int volume);
     void restart();
 
@@ -61,18 +70,66 @@ public:
 
     void initReverb(int reverb_type);
     void initChorus(int chorus_type);
-    void initSoundLib(int);
     void setReverbWet(int amount);
     void setChorusLevel(int amount);
+    /* the output is stopped while the engine is replaced */
+    void initSoundLib(int);
     void initSoundfont(const QString soundfont);
     void playFile(const QString fileName);
     void startPlayback(const QString fileName);
     void stopPlayback();
+    void seek(int milliseconds);
+    void setLoopPoints(int startTime, int endTime);
+    void clearLoop();
+    void setPlaybackRate(qreal factor);
+    int playbackDuration() const;
+    /* layered files, see SynthRenderer::openPlayer(); stop() closes them */
+    bool openPlayer(int player, const QString &fileName);
+    void closePlayer(int player);
+    void setPlayerVolume(int player, int volume);
+    void setPlayerPaused(int player, bool paused);
+    void seekPlayer(int player, int milliseconds);
+    int playerState(int player) const;
+    int playerLocation(int player) const;
+    int playerDuration(int player) const;
+
+    bool readSnapshot(SynthSnapshot::State &state) const;
+    /* changes whenever the keys of the snapshot change */
+    std::uint32_t snapshotSerial() const;
+
+    void setIdleDetection(bool enabled);
+    void setPrewarm(bool enabled);
+    void setBounce(bool enabled);
+    void setRenderCache(bool enabled);
+    /* bit-exact file playback; renderChecksum() is emitted every interval blocks */
+    void setDeterministic(bool enabled);
+    void setChecksumInterval(int blocks);
+    /* logs the live input and parameter calls for mp_replaysynth; empty stops it */
+    void setCaptureFile(const QString &fileName);
+    /* the recent render history is written there on underruns and stalls */
+    void setFlightRecordFile(const QString &fileName);
+    QString flightRecordFile() const;
+    bool dumpFlightRecord(const QString &reason);
+    bool isIdle() const;
+    /* glitches detected over the whole life of the controller */
+    quint64 underruns() const;
+    quint64 stalls() const;
+    bool readRenderStats(RenderStats::Values &values) const;
+
+    /* lock and prefault the render memory on start(), and warm the engine up */
+    void setRealtimeMemory(bool enabled);
+    bool realtimeMemory() const;
+    qint64 lockedMemory() const;
+    /* accumulated over the whole life of the controller */
+    void readRenderErrors(RenderErrors::Counters &counters) const;
 
 public slots:
     void noteOn(int chan, int note, int vel);
     void noteOff(int chan, int note, int vel);
     void program(int chan, int pgm);
+    void controller(int chan, int control, int value);
+    void pitchBend(int chan, int value);
+    void midiMessage(const MidiMessage &msg);
     void start();
     void stop();
 
@@ -80,22 +137,62 @@ signals:
     void finished();
     void underrunDetected();
     void stallDetected();
+    /* from the snapshot on the main thread, every 10 ms while started;
+       polling readSnapshot() at the screen refresh rate is cheaper */
     void midiNoteOn(const int note, const int vel);
     void midiNoteOff(const int note, const int vel);
     void playbackStopped();
     void playbackTime(int time);
+    void playerStopped(int player);
     void synthStarted();
+    void metaDataEvent(int type, const QString &text, int value, qint64 time);
+    void renderChecksum(quint64 firstBlock, int blocks, quint64 value);
 
 private:
     void initAudio();
+    void startOutput();
+    void stopOutput();
     void updateAudioDevices();
     void connectRendererSignals();
+    void dispatchMetaEvents();
+    void checkPlayers();
+    void drainRenderErrors();
+    void drainChecksums();
+    void flushCapture();
+    void recordGlitch(FlightRecorder::Type type);
+    void lockRealtimeMemory();
+    void unlockRealtimeMemory();
+    qint64 queuedFrames() const;
 
 private:
     SynthRenderer *m_renderer{nullptr};
     QTimer m_stallDetector;
+    QTimer m_metaDataTimer;
     int m_requestedBufferTime;
     bool m_running;
+    bool m_idleDetection{true};
+    bool m_prewarm{false};
+    bool m_bounce{false};
+    bool m_renderCache{false};
+    bool m_deterministic{false};
+    int m_checksumInterval{0};
+    QString m_captureFile;
+    QString m_flightRecordFile{QDir::temp().filePath(QStringLiteral("mp_svoxeas-flightrecord.txt"))};
+    qint64 m_lastFlightDump{-1};
+    int m_playerStates[SynthRenderer::MAX_PLAYERS]{};
+    quint64 m_underruns{0};
+    quint64 m_stalls{0};
+    struct ErrorLogState {
+        qint64 lastLogged{-1};
+        quint64 suppressed{0};
+        qint32 lastResult{0};
+    };
+    ErrorLogState m_errorLog[RenderErrors::CodeCount];
+    RenderErrors::Counters m_errorTotals{};
+    QElapsedTimer m_errorClock;
+    bool m_realtimeMemory{false};
+    bool m_lockedAll{false};
+    qint64 m_lockedBytes{0};
     QAudioFormat m_format;
 #if QT_VERSION < QT_VERSION_CHECK(6,0,0)
     QAudioOutput *m_audioOutput{nullptr};
@@ -109,6 +206,12 @@ private:
 #endif
     QString m_midiDriver;
     QString m_portName;
+    AlsaOutput *m_alsaOutput{nullptr};
+    QString m_alsaDevice;
+    NullOutput *m_nullOutput{nullptr};
+    bool m_nullDevice{false};
+    int m_periodSize{0};
+    int m_periodCount{0};
 };
 
 #endif // SYNTHCONTROLLER_H
@@ -0,0 +1,817 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <eas_chorus.h>
+#include <eas_report.h>
+#include <eas_reverb.h>
+
+#include "filewrapper.h"
+#include "rtmemory.h"
+#include "rtscope.h"
+#include "synthengine.h"
+#include "tracescope.h"
+
+static_assert(sizeof(EAS_PCM) == sizeof(std::int16_t), "EAS_PCM must be 16 bit samples");
+
+/* peak sample magnitude considered silence (about -78 dBFS), and how long
+   the output must stay below it, including reverb and chorus tails */
+static const int IDLE_THRESHOLD = 4;
+static const int IDLE_HOLD_TIME = 1000;
+
+/* an effect setting never applied, left alone by reset() */
+static const int EFFECT_UNSET = INT_MIN;
+/* how often a borrower looks for the end of a callback, in microseconds,
+   and how long it keeps trying once its timeout is over, in milliseconds */
+static const int BORROW_POLL_INTERVAL = 250;
+static const int BORROW_LIMIT = 1000;
+
+static void defaultLogHandler(int level, const char *message)
+{
+    if (level >= SynthEngine::LogWarning) {
+        fprintf(stderr, "%s\n", message);
+    }
+}
+
+static std::atomic<SynthEngine::LogHandler> logHandler{&defaultLogHandler};
+
+static void logMessage(int level, const char *format, ...)
+{
+    char message[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    logHandler.load()(level, message);
+}
+
+SynthEngine::SynthEngine()
+    : m_easData(nullptr)
+    , m_streamHandle(nullptr)
+    , m_instanceSerial(0)
+    , m_instanceOwner(InstanceFree)
+    , m_callbacks(0)
+    , m_lastCallback(0)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_blockFrames(0)
+    , m_block{}
+    , m_blockFrame(0)
+    , m_blockLength(0)
+    , m_blockCallback(nullptr)
+    , m_blockCallbackUser(nullptr)
+    , m_renderedFrames(0)
+    , m_idleDetection(true)
+    , m_keepAwake(false)
+    , m_idle(false)
+    , m_quietFrames(0)
+    , m_stackPrefault(0)
+    , m_warmStream(nullptr)
+    , m_warmBlocks(0)
+    , m_deterministic(false)
+    , m_soundLib(DEFAULT_SOUND_LIB)
+    , m_reverbType(EFFECT_UNSET)
+    , m_reverbWet(EFFECT_UNSET)
+    , m_chorusType(EFFECT_UNSET)
+    , m_chorusLevel(EFFECT_UNSET)
+    , m_appliedReverbType(EFFECT_UNSET)
+    , m_appliedReverbWet(EFFECT_UNSET)
+    , m_appliedChorusType(EFFECT_UNSET)
+    , m_appliedChorusLevel(EFFECT_UNSET)
+{}
+
+SynthEngine::~SynthEngine()
+{
+    shutdown();
+}
+
+void SynthEngine::setLogHandler(LogHandler handler)
+{
+    logHandler = (handler != nullptr) ? handler : &defaultLogHandler;
+}
+
+bool SynthEngine::init(int soundLib, const char *soundfont)
+{
+    TraceScope traceScope("SynthEngine::init");
+    Instance instance;
+
+    shutdown();
+    m_soundLib = soundLib;
+    m_soundfont = (soundfont != nullptr) ? soundfont : "";
+    if (!createInstance(soundLib, soundfont, instance)) {
+        return false;
+    }
+    const S_EAS_LIB_CONFIG *easConfig = EAS_Config();
+    m_easData = instance.easData;
+    m_streamHandle = instance.stream;
+    ++m_instanceSerial;
+    m_sampleRate = easConfig->sampleRate;
+    m_blockFrames = easConfig->mixBufferSize;
+    m_channels = easConfig->numChannels;
+    std::fill(std::begin(m_block), std::end(m_block), 0);
+    m_blockFrame = 0;
+    m_blockLength = 0;
+    m_quietFrames = 0;
+    m_idle = false;
+    forgetEffects();
+    return true;
+}
+
+bool SynthEngine::createInstance(int soundLib, const char *soundfont, Instance &instance,
+                                 bool warmStream)
+{
+    TraceScope traceScope("SynthEngine::createInstance");
+    EAS_RESULT eas_res;
+    EAS_DATA_HANDLE dataHandle;
+    EAS_HANDLE handle;
+
+    const S_EAS_LIB_CONFIG *easConfig = EAS_Config();
+    if (easConfig == nullptr) {
+        logMessage(LogCritical, "EAS_Config returned null");
+        return false;
+    }
+
+    EAS_SetDebugFile(stderr, 1);
+    EAS_SetDebugLevel(_EAS_SEVERITY_ERROR);
+
+    if (!EngineProfile::fits(easConfig->mixBufferSize, easConfig->numChannels)) {
+        logMessage(LogCritical,
+                   "EAS_Config (%ld frames, %ld channels) exceeds the engine profile (%zu frames, %zu channels)",
+                   (long) easConfig->mixBufferSize, (long) easConfig->numChannels,
+                   EngineProfile::MAX_BLOCK_FRAMES, EngineProfile::MAX_CHANNELS);
+        return false;
+    }
+
+    eas_res = EAS_Init(&dataHandle);
+    if (eas_res != EAS_SUCCESS) {
+        logMessage(LogCritical, "EAS_Init error: %ld", (long) eas_res);
+        return false;
+    }
+
+    const char *sndlib_name = EAS_GetDefaultSoundLibrary((E_EAS_SNDLIB_TYPE) soundLib);
+    if (sndlib_name == nullptr) {
+        logMessage(LogCritical, "Failed to get default sound library name");
+        EAS_Shutdown(dataHandle);
+        return false;
+    }
+    eas_res = EAS_SetSoundLibrary(dataHandle, nullptr, EAS_GetSoundLibrary(dataHandle, sndlib_name));
+    if (eas_res != EAS_SUCCESS) {
+        logMessage(LogCritical, "EAS_SetSoundLibrary error: %ld", (long) eas_res);
+        EAS_Shutdown(dataHandle);
+        return false;
+    }
+
+    if (soundfont != nullptr && *soundfont != 0) {
+        FileWrapper dls(soundfont);
+        if (dls.ok()) {
+            eas_res = EAS_LoadDLSCollection(dataHandle, nullptr, dls.getLocator());
+            if (eas_res != EAS_SUCCESS) {
+                logMessage(LogWarning, "EAS_LoadDLSCollection(%s) error: %ld", soundfont, (long) eas_res);
+            }
+        } else {
+            logMessage(LogWarning, "Failed to open %s", soundfont);
+        }
+    }
+
+    eas_res = EAS_OpenMIDIStream(dataHandle, &handle, nullptr);
+    if (eas_res != EAS_SUCCESS) {
+        logMessage(LogCritical, "EAS_OpenMIDIStream error: %ld", (long) eas_res);
+        EAS_Shutdown(dataHandle);
+        return false;
+    }
+
+    instance.easData = dataHandle;
+    instance.stream = handle;
+    if (warmStream) {
+        eas_res = EAS_OpenMIDIStream(dataHandle, &instance.warmStream, nullptr);
+        if (eas_res != EAS_SUCCESS) {
+            logMessage(LogWarning, "EAS_OpenMIDIStream error: %ld", (long) eas_res);
+            instance.warmStream = nullptr;
+        }
+    }
+    return true;
+}
+
+void SynthEngine::releaseInstance(Instance &instance)
+{
+    EAS_RESULT eas_res;
+    if (instance.easData != nullptr && instance.warmStream != nullptr) {
+        eas_res = EAS_CloseMIDIStream(instance.easData, instance.warmStream);
+        if (eas_res != EAS_SUCCESS) {
+            logMessage(LogWarning, "EAS_CloseMIDIStream error: %ld", (long) eas_res);
+        }
+    }
+    if (instance.easData != nullptr && instance.stream != nullptr) {
+        eas_res = EAS_CloseMIDIStream(instance.easData, instance.stream);
+        if (eas_res != EAS_SUCCESS) {
+            logMessage(LogWarning, "EAS_CloseMIDIStream error: %ld", (long) eas_res);
+        }
+    }
+    if (instance.easData != nullptr) {
+        eas_res = EAS_Shutdown(instance.easData);
+        if (eas_res != EAS_SUCCESS) {
+            logMessage(LogWarning, "EAS_Shutdown error: %ld", (long) eas_res);
+        }
+    }
+    instance = Instance();
+}
+
+void SynthEngine::shutdown()
+{
+    TraceScope traceScope("SynthEngine::shutdown");
+    Instance instance;
+    instance.easData = m_easData;
+    instance.stream = m_streamHandle;
+    instance.warmStream = m_warmStream;
+    releaseInstance(instance);
+    m_easData = nullptr;
+    m_streamHandle = nullptr;
+    m_warmStream = nullptr;
+    m_midiQueue.clear();
+    m_warmQueue.clear();
+    m_warmBlocks = 0;
+}
+
+bool SynthEngine::isValid() const
+{
+    return m_easData != nullptr && m_streamHandle != nullptr;
+}
+
+EAS_DATA_HANDLE SynthEngine::easData() const
+{
+    return m_easData;
+}
+
+std::uint32_t SynthEngine::instanceSerial() const
+{
+    return m_instanceSerial;
+}
+
+/* render thread; false while the instance is borrowed */
+bool SynthEngine::beginCallback()
+{
+    int owner = InstanceFree;
+    if (!m_instanceOwner.compare_exchange_strong(owner, InstanceRendering, std::memory_order_acquire)) {
+        m_errors.report(RenderErrors::InstanceBusy, owner);
+        return false;
+    }
+    return true;
+}
+
+void SynthEngine::endCallback()
+{
+    m_lastCallback.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                         std::memory_order_relaxed);
+    m_instanceOwner.store(InstanceFree, std::memory_order_release);
+    m_callbacks.fetch_add(1, std::memory_order_release);
+}
+
+bool SynthEngine::borrowInstance(int timeoutMs)
+{
+    TraceScope traceScope("SynthEngine::borrowInstance");
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const Clock::duration timeout = std::chrono::milliseconds(timeoutMs);
+    const Clock::duration limit = timeout + std::chrono::milliseconds(BORROW_LIMIT);
+    std::uint32_t callbacks = m_callbacks.load(std::memory_order_acquire);
+    for (;;) {
+        /* right after a callback, the whole period is left before the next
+           one; without callbacks lately, nothing is rendering */
+        const Clock::time_point now = Clock::now();
+        const Clock::time_point lastCallback(Clock::duration(m_lastCallback.load(std::memory_order_relaxed)));
+        if (m_callbacks.load(std::memory_order_acquire) != callbacks || now - lastCallback >= timeout
+            || now - start >= timeout) {
+            int owner = InstanceFree;
+            if (m_instanceOwner.compare_exchange_strong(owner, InstanceBorrowed, std::memory_order_acquire)) {
+                return true;
+            }
+            if (now - start >= limit) {
+                return false;
+            }
+            callbacks = m_callbacks.load(std::memory_order_acquire);
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(BORROW_POLL_INTERVAL));
+    }
+}
+
+void SynthEngine::returnInstance()
+{
+    m_instanceOwner.store(InstanceFree, std::memory_order_release);
+}
+
+int SynthEngine::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+int SynthEngine::channels() const
+{
+    return m_channels;
+}
+
+int SynthEngine::blockFrames() const
+{
+    return m_blockFrames;
+}
+
+void SynthEngine::setReverb(int type)
+{
+    m_reverbType = type;
+}
+
+void SynthEngine::setReverbWet(int amount)
+{
+    m_reverbWet = amount;
+}
+
+void SynthEngine::setChorus(int type)
+{
+    m_chorusType = type;
+}
+
+void SynthEngine::setChorusLevel(int amount)
+{
+    m_chorusLevel = amount;
+}
+
+/* any thread; returns false if the message is too long or the queue is full */
+bool SynthEngine::writeMIDI(const std::uint8_t *data, std::size_t length, std::int64_t frame)
+{
+    TraceScope traceScope("writeMIDI");
+    MidiEvent ev;
+    if (length == 0 || length > MidiMessage::MAX_LENGTH) {
+        return false;
+    }
+    ev.frame = frame;
+    ev.message.length = length;
+    memcpy(ev.message.data, data, length);
+    return m_midiQueue.push(ev);
+}
+
+void SynthEngine::clearMIDI()
+{
+    m_midiQueue.clear();
+}
+
+/* render thread; feeds the messages due before untilFrame, and returns
+   true if any message was taken from the queues */
+bool SynthEngine::processMIDIQueue(std::int64_t untilFrame)
+{
+    EAS_RESULT eas_res;
+    MidiEvent ev;
+    MidiMessage msg;
+    bool received = false;
+    for (const MidiEvent *next = m_midiQueue.front();
+         next != nullptr && next->frame < untilFrame;
+         next = m_midiQueue.front()) {
+        m_midiQueue.pop(ev);
+        received = true;
+        m_stats.addMidiEvents(1);
+        if (isValid()) {
+            eas_res = EAS_WriteMIDIStream(m_easData, m_streamHandle, ev.message.data, ev.message.length);
+            if (eas_res != EAS_SUCCESS) {
+                m_errors.report(RenderErrors::WriteMidiFailed, eas_res);
+            }
+        }
+    }
+    while (m_warmQueue.pop(msg)) {
+        received = true;
+        if (isValid() && m_warmStream != nullptr) {
+            eas_res = EAS_WriteMIDIStream(m_easData, m_warmStream, msg.data, msg.length);
+            if (eas_res != EAS_SUCCESS) {
+                m_errors.report(RenderErrors::WriteMidiFailed, eas_res);
+            }
+        }
+    }
+    return received;
+}
+
+void SynthEngine::setBlockCallback(BlockCallback callback, void *user)
+{
+    m_blockCallback = callback;
+    m_blockCallbackUser = user;
+}
+
+std::int64_t SynthEngine::renderedFrames() const
+{
+    return m_renderedFrames;
+}
+
+void SynthEngine::renderBlock()
+{
+    const auto startTime = std::chrono::steady_clock::now();
+    applyEffects();
+    if (m_deterministic) {
+        processMIDIQueue(m_renderedFrames + m_blockFrames);
+    }
+    EAS_I32 numGen = m_blockFrames;
+    const bool idle = m_idle;
+    if (idle) {
+        /* nothing is sounding: serve silence without waking up the engine */
+        std::fill(std::begin(m_block), std::end(m_block), 0);
+    } else {
+        EAS_RESULT eas_res;
+        {
+            TraceScope traceScope("EAS_Render");
+            eas_res = EAS_Render(m_easData, m_block, m_blockFrames, &numGen);
+        }
+        if (eas_res != EAS_SUCCESS || numGen <= 0) {
+            m_errors.report(RenderErrors::RenderFailed, eas_res);
+            std::fill(std::begin(m_block), std::end(m_block), 0);
+            numGen = m_blockFrames;
+        } else {
+            if (m_blockCallback != nullptr) {
+                m_blockCallback(m_blockCallbackUser, m_block, numGen);
+            }
+            if (!m_keepAwake) {
+                updateIdleState(m_block, numGen);
+            }
+        }
+    }
+    m_checksum.add(m_block, numGen * m_channels);
+    m_blockFrame = 0;
+    m_blockLength = numGen;
+    m_renderedFrames += numGen;
+    const std::uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                      std::chrono::steady_clock::now() - startTime).count();
+    if (idle) {
+        m_stats.addIdle(1, elapsed);
+    } else if (m_warmBlocks > 0) {
+        m_stats.addPrewarm(1, elapsed);
+        if (--m_warmBlocks == 0) {
+            endPrewarm();
+        }
+    } else {
+        m_stats.addRendered(1, elapsed);
+    }
+}
+
+/* goes idle once the output has been silent for IDLE_HOLD_TIME */
+void SynthEngine::updateIdleState(const EAS_PCM *samples, EAS_I32 frames)
+{
+    if (!m_idleDetection || m_deterministic) {
+        return;
+    }
+    const EAS_I32 count = frames * m_channels;
+    for (EAS_I32 i = 0; i < count; ++i) {
+        if (std::abs(samples[i]) > IDLE_THRESHOLD) {
+            m_quietFrames = 0;
+            return;
+        }
+    }
+    m_quietFrames += frames;
+    if (m_quietFrames >= std::int64_t(m_sampleRate) * IDLE_HOLD_TIME / 1000) {
+        m_idle = true;
+    }
+}
+
+/* feeds the queued MIDI messages; any of them restarts the silence hold time */
+void SynthEngine::beginRender()
+{
+    if (m_stackPrefault.load(std::memory_order_relaxed) > 0) {
+        RtMemory::prefaultStack(m_stackPrefault.exchange(0));
+    }
+    /* in deterministic mode the queue is read by renderBlock() instead */
+    const bool received = !m_deterministic && processMIDIQueue(INT64_MAX);
+    if (received || m_keepAwake || !m_idleDetection || m_deterministic) {
+        m_quietFrames = 0;
+        if (m_idle) {
+            /* drop what is left of the silent block, so the new events sound right away */
+            m_renderedFrames -= m_blockLength - m_blockFrame;
+            m_blockFrame = m_blockLength;
+            m_idle = false;
+            m_stats.addWakeup();
+        }
+    }
+}
+
+std::size_t SynthEngine::render(std::int16_t *output, std::size_t frames)
+{
+    RtScope rtScope;
+    if (!isValid()) {
+        memset(output, 0, frames * std::max(m_channels, 1) * sizeof(std::int16_t));
+        return frames;
+    }
+    beginRender();
+    std::size_t done = 0;
+    while (done < frames) {
+        if (m_blockFrame >= m_blockLength) {
+            renderBlock();
+        }
+        const std::size_t count = std::min(frames - done, m_blockLength - m_blockFrame);
+        memcpy(output + done * m_channels,
+               &m_block[m_blockFrame * m_channels],
+               count * m_channels * sizeof(std::int16_t));
+        m_blockFrame += count;
+        done += count;
+    }
+    return frames;
+}
+
+std::size_t SynthEngine::render(float *output, std::size_t frames)
+{
+    RtScope rtScope;
+    if (!isValid()) {
+        std::fill(output, output + frames * std::max(m_channels, 1), 0.0f);
+        return frames;
+    }
+    beginRender();
+    std::size_t done = 0;
+    while (done < frames) {
+        if (m_blockFrame >= m_blockLength) {
+            renderBlock();
+        }
+        const std::size_t count = std::min(frames - done, m_blockLength - m_blockFrame);
+        const EAS_PCM *src = &m_block[m_blockFrame * m_channels];
+        float *dst = output + done * m_channels;
+        for (std::size_t i = 0; i < count * m_channels; ++i) {
+            dst[i] = src[i] * (1.0f / 32768.0f);
+        }
+        m_blockFrame += count;
+        done += count;
+    }
+    return frames;
+}
+
+void SynthEngine::setIdleDetection(bool enabled)
+{
+    m_idleDetection = enabled;
+}
+
+bool SynthEngine::idleDetection() const
+{
+    return m_idleDetection;
+}
+
+void SynthEngine::setKeepAwake(bool awake)
+{
+    m_keepAwake = awake;
+}
+
+bool SynthEngine::isIdle() const
+{
+    return m_idle;
+}
+
+RenderStats &SynthEngine::stats()
+{
+    return m_stats;
+}
+
+const RenderStats &SynthEngine::stats() const
+{
+    return m_stats;
+}
+
+RenderErrors &SynthEngine::errors()
+{
+    return m_errors;
+}
+
+void SynthEngine::warmUp(int blocks)
+{
+    if (!isValid()) {
+        return;
+    }
+    applyEffects();
+    for (int i = 0; i < blocks; ++i) {
+        EAS_I32 numGen = 0;
+        EAS_RESULT eas_res = EAS_Render(m_easData, m_block, m_blockFrames, &numGen);
+        if (eas_res != EAS_SUCCESS) {
+            logMessage(LogWarning, "EAS_Render error: %ld", (long) eas_res);
+            break;
+        }
+    }
+    std::fill(std::begin(m_block), std::end(m_block), 0);
+}
+
+void SynthEngine::requestStackPrefault(std::size_t bytes)
+{
+    m_stackPrefault = bytes;
+}
+
+bool SynthEngine::openWarmStream()
+{
+    if (!isValid()) {
+        return false;
+    }
+    if (m_warmStream == nullptr) {
+        EAS_RESULT eas_res = EAS_OpenMIDIStream(m_easData, &m_warmStream, nullptr);
+        if (eas_res != EAS_SUCCESS) {
+            logMessage(LogWarning, "EAS_OpenMIDIStream error: %ld", (long) eas_res);
+            m_warmStream = nullptr;
+            return false;
+        }
+    }
+    return true;
+}
+
+/* a prewarm still running is cut short */
+void SynthEngine::closeWarmStream()
+{
+    if (m_easData != nullptr && m_warmStream != nullptr) {
+        EAS_CloseMIDIStream(m_easData, m_warmStream);
+    }
+    m_warmStream = nullptr;
+    m_warmQueue.clear();
+    m_warmBlocks = 0;
+}
+
+bool SynthEngine::hasWarmStream() const
+{
+    return m_warmStream != nullptr;
+}
+
+bool SynthEngine::prewarm(const MidiMessage *messages, std::size_t count, int blocks)
+{
+    if (!isValid() || m_warmStream == nullptr || blocks <= 0 || isPrewarming()) {
+        return false;
+    }
+    /* volume and expression down first, so nothing can be heard */
+    for (std::uint8_t chan = 0; chan < 16; ++chan) {
+        MidiMessage mute{3, {std::uint8_t(0xb0 | chan), 7, 0}};
+        MidiMessage expression{3, {std::uint8_t(0xb0 | chan), 11, 0}};
+        m_warmQueue.push(mute);
+        m_warmQueue.push(expression);
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!m_warmQueue.push(messages[i])) {
+            break;
+        }
+    }
+    m_warmBlocks = blocks;
+    return true;
+}
+
+bool SynthEngine::isPrewarming() const
+{
+    return m_warmBlocks > 0 || !m_warmQueue.isEmpty();
+}
+
+void SynthEngine::writeWarmStream(std::uint8_t status, std::uint8_t data1, std::uint8_t data2)
+{
+    EAS_U8 msg[3] = {status, data1, data2};
+    EAS_RESULT eas_res = EAS_WriteMIDIStream(m_easData, m_warmStream, msg, sizeof(msg));
+    if (eas_res != EAS_SUCCESS) {
+        m_errors.report(RenderErrors::WriteMidiFailed, eas_res);
+    }
+}
+
+/* render thread: silences the private stream at once, and leaves it open
+   for the next prewarm */
+void SynthEngine::endPrewarm()
+{
+    if (m_warmStream == nullptr) {
+        return;
+    }
+    for (std::uint8_t chan = 0; chan < 16; ++chan) {
+        writeWarmStream(0xb0 | chan, 120, 0); // all sound off
+        writeWarmStream(0xb0 | chan, 121, 0); // reset all controllers
+    }
+}
+
+void SynthEngine::setDeterministic(bool enabled)
+{
+    m_deterministic = enabled;
+}
+
+bool SynthEngine::deterministic() const
+{
+    return m_deterministic;
+}
+
+/* reverb and chorus tails, voices and controllers of the previous run are
+   only really gone with a new EAS instance */
+bool SynthEngine::reset(Instance &instance)
+{
+    if (instance.easData == nullptr || instance.stream == nullptr) {
+        return false;
+    }
+    std::swap(m_easData, instance.easData);
+    std::swap(m_streamHandle, instance.stream);
+    std::swap(m_warmStream, instance.warmStream);
+    ++m_instanceSerial;
+    m_midiQueue.clear();
+    m_warmQueue.clear();
+    m_warmBlocks = 0;
+    /* the new instance starts on a block boundary; what was left of the
+       last block was never delivered, so it is not counted */
+    m_renderedFrames -= m_blockLength - m_blockFrame;
+    std::fill(std::begin(m_block), std::end(m_block), 0);
+    m_blockFrame = 0;
+    m_blockLength = 0;
+    m_quietFrames = 0;
+    m_idle = false;
+    forgetEffects();
+    applyEffects();
+    m_checksum.reset();
+    return true;
+}
+
+bool SynthEngine::reset()
+{
+    Instance instance;
+    if (!createInstance(m_soundLib, m_soundfont.empty() ? nullptr : m_soundfont.c_str(), instance,
+                        m_warmStream != nullptr)) {
+        return false;
+    }
+    reset(instance);
+    releaseInstance(instance);
+    return true;
+}
+
+int SynthEngine::soundLib() const
+{
+    return m_soundLib;
+}
+
+const std::string &SynthEngine::soundfont() const
+{
+    return m_soundfont;
+}
+
+RenderChecksum &SynthEngine::checksum()
+{
+    return m_checksum;
+}
+
+const RenderChecksum &SynthEngine::checksum() const
+{
+    return m_checksum;
+}
+
+/* render thread, or not rendering: the effect parameters changed since
+   the last block are passed to EAS */
+void SynthEngine::applyEffects()
+{
+    const int reverbWet = m_reverbWet.load(std::memory_order_relaxed);
+    const int reverbType = m_reverbType.load(std::memory_order_relaxed);
+    const int chorusLevel = m_chorusLevel.load(std::memory_order_relaxed);
+    const int chorusType = m_chorusType.load(std::memory_order_relaxed);
+    if (reverbWet != m_appliedReverbWet) {
+        m_appliedReverbWet = reverbWet;
+        setParameter(EAS_MODULE_REVERB, EAS_PARAM_REVERB_WET, reverbWet);
+    }
+    if (reverbType != m_appliedReverbType) {
+        m_appliedReverbType = reverbType;
+        const bool preset = reverbType >= EAS_PARAM_REVERB_LARGE_HALL
+                            && reverbType <= EAS_PARAM_REVERB_ROOM;
+        if (preset) {
+            setParameter(EAS_MODULE_REVERB, EAS_PARAM_REVERB_PRESET, reverbType);
+        }
+        setParameter(EAS_MODULE_REVERB, EAS_PARAM_REVERB_BYPASS, preset ? EAS_FALSE : EAS_TRUE);
+    }
+    if (chorusLevel != m_appliedChorusLevel) {
+        m_appliedChorusLevel = chorusLevel;
+        setParameter(EAS_MODULE_CHORUS, EAS_PARAM_CHORUS_LEVEL, chorusLevel);
+    }
+    if (chorusType != m_appliedChorusType) {
+        m_appliedChorusType = chorusType;
+        const bool preset = chorusType >= EAS_PARAM_CHORUS_PRESET1
+                            && chorusType <= EAS_PARAM_CHORUS_PRESET4;
+        if (preset) {
+            setParameter(EAS_MODULE_CHORUS, EAS_PARAM_CHORUS_PRESET, chorusType);
+        }
+        setParameter(EAS_MODULE_CHORUS, EAS_PARAM_CHORUS_BYPASS, preset ? EAS_FALSE : EAS_TRUE);
+    }
+}
+
+/* a new instance starts with the EAS defaults, so every effect set is applied again */
+void SynthEngine::forgetEffects()
+{
+    m_appliedReverbType = EFFECT_UNSET;
+    m_appliedReverbWet = EFFECT_UNSET;
+    m_appliedChorusType = EFFECT_UNSET;
+    m_appliedChorusLevel = EFFECT_UNSET;
+}
+
+void SynthEngine::setParameter(int module, int param, int value)
+{
+    EAS_RESULT eas_res = EAS_SetParameter(m_easData, module, param, (EAS_I32) value);
+    if (eas_res != EAS_SUCCESS) {
+        m_errors.report(RenderErrors::SetParameterFailed, eas_res);
+    }
+}
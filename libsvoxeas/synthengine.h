@@ -0,0 +1,218 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYNTHENGINE_H
+#define SYNTHENGINE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "eas.h"
+#include "engineprofile.h"
+#include "midiparser.h"
+#include "mp_svoxeas_core_visibility.h"
+#include "renderchecksum.h"
+#include "rendererrors.h"
+#include "renderstats.h"
+
+/**
+ * The synthesizer engine without any Qt dependency: EAS setup, sound
+ * library and DLS loading, effects, a lock-free MIDI event queue and a
+ * pull-style render call producing any number of interleaved frames.
+ *
+ * writeMIDI() may be called from any thread; render() must always be
+ * called from the same (audio) thread, which is the only one feeding EAS.
+ * All the storage is sized by EngineProfile and embedded in the object,
+ * so it may be statically allocated and never touches the heap after init.
+ */
+class MP_SVOXEAS_CORE_PUBLIC SynthEngine
+{
+public:
+    enum LogLevel { LogDebug, LogWarning, LogCritical };
+    typedef void (*LogHandler)(int level, const char *message);
+    /* called on the render thread after each EAS block, before it is counted */
+    typedef void (*BlockCallback)(void *user, const EAS_PCM *samples, EAS_I32 frames);
+
+    static const int DEFAULT_SOUND_LIB = 1; // WT
+
+    /* an EAS instance with the sound library, the DLS and the MIDI stream
+       loaded, and the prewarm stream when asked for; made off the render
+       thread for reset() */
+    struct Instance {
+        EAS_DATA_HANDLE easData{nullptr};
+        EAS_HANDLE stream{nullptr};
+        EAS_HANDLE warmStream{nullptr};
+    };
+
+    SynthEngine();
+    ~SynthEngine();
+
+    /* process wide; the default handler writes warnings and errors to stderr */
+    static void setLogHandler(LogHandler handler);
+
+    bool init(int soundLib = DEFAULT_SOUND_LIB, const char *soundfont = nullptr);
+    void shutdown();
+    /* any thread; an instance is only used by one thread at a time */
+    static bool createInstance(int soundLib, const char *soundfont, Instance &instance,
+                               bool warmStream = false);
+    static void releaseInstance(Instance &instance);
+    bool isValid() const;
+    EAS_DATA_HANDLE easData() const;
+    /* changes whenever init() or reset() replaces the instance */
+    std::uint32_t instanceSerial() const;
+
+    /* EAS is used by one thread at a time. The render thread holds the
+       instance for a whole callback; a non real-time thread borrows it
+       between two callbacks to open or close streams, so their allocations
+       and file reads stay off the render thread. Borrowing waits for the end
+       of the next callback, unless none came for timeoutMs, and fails when
+       the instance is still taken a second later. The render thread never
+       waits: a callback finding the instance borrowed reports InstanceBusy
+       and outputs silence, so the borrowed work must be short and must not
+       log */
+    bool beginCallback();
+    void endCallback();
+    bool borrowInstance(int timeoutMs);
+    void returnInstance();
+
+    int sampleRate() const;
+    int channels() const;
+    int blockFrames() const;
+
+    /* any thread; passed to EAS by the render thread before the next block */
+    void setReverb(int type);
+    void setReverbWet(int amount);
+    void setChorus(int type);
+    void setChorusLevel(int amount);
+
+    /* frame is honoured only in deterministic mode, where the message is
+       played from the start of the block containing that output frame;
+       timed messages must be written in order */
+    bool writeMIDI(const std::uint8_t *data, std::size_t length, std::int64_t frame = -1);
+    void clearMIDI();
+
+    void setBlockCallback(BlockCallback callback, void *user);
+    std::size_t render(std::int16_t *output, std::size_t frames);
+    std::size_t render(float *output, std::size_t frames);
+    std::int64_t renderedFrames() const;
+
+    /* EAS_Render is skipped while the output stays silent, unless kept awake */
+    void setIdleDetection(bool enabled);
+    bool idleDetection() const;
+    void setKeepAwake(bool awake);
+    bool isIdle() const;
+    RenderStats &stats();
+    const RenderStats &stats() const;
+    /* render path failures, to be taken and logged by a non real-time thread */
+    RenderErrors &errors();
+
+    /* renders and discards silent blocks to prime caches; only before the audio starts */
+    void warmUp(int blocks);
+    /* the render thread faults its stack in on the next render() call */
+    void requestStackPrefault(std::size_t bytes);
+
+    /* the private stream of the prewarm takes an EAS stream for as long as
+       it is open; not rendering, or with the instance borrowed */
+    bool openWarmStream();
+    void closeWarmStream();
+    bool hasWarmStream() const;
+    /* plays the messages muted on the private stream during the next
+       blocks, so the instruments are loaded before they are needed; render
+       thread. Without the stream the prewarm is skipped */
+    bool prewarm(const MidiMessage *messages, std::size_t count, int blocks);
+    bool isPrewarming() const;
+
+    /* bit-exact output for the same input: no idle detection, and the MIDI
+       queue is read before each block instead of once per render() call */
+    void setDeterministic(bool enabled);
+    bool deterministic() const;
+    /* swaps in an instance made by createInstance() with the same sound
+       library and soundfont, and applies the effects again; the previous
+       instance is handed back in its place, to be released off the render
+       thread. The queued MIDI is dropped and the checksum restarts, while
+       the frame count goes on. Render thread or not rendering */
+    bool reset(Instance &instance);
+    /* the same, making and releasing the instances on the calling thread */
+    bool reset();
+    int soundLib() const;
+    const std::string &soundfont() const;
+    RenderChecksum &checksum();
+    const RenderChecksum &checksum() const;
+
+private:
+    bool processMIDIQueue(std::int64_t untilFrame);
+    void applyEffects();
+    void forgetEffects();
+    void setParameter(int module, int param, int value);
+    void beginRender();
+    void renderBlock();
+    void updateIdleState(const EAS_PCM *samples, EAS_I32 frames);
+    void writeWarmStream(std::uint8_t status, std::uint8_t data1, std::uint8_t data2);
+    void endPrewarm();
+
+    EAS_DATA_HANDLE m_easData;
+    EAS_HANDLE m_streamHandle;
+    std::atomic<std::uint32_t> m_instanceSerial;
+    enum InstanceOwner { InstanceFree, InstanceRendering, InstanceBorrowed };
+    std::atomic<int> m_instanceOwner;
+    std::atomic<std::uint32_t> m_callbacks;
+    std::atomic<std::int64_t> m_lastCallback;
+    int m_sampleRate;
+    int m_channels;
+    int m_blockFrames;
+
+    EAS_PCM m_block[EngineProfile::BLOCK_SAMPLES];
+    std::size_t m_blockFrame;
+    std::size_t m_blockLength;
+    MidiEventQueue m_midiQueue;
+    BlockCallback m_blockCallback;
+    void *m_blockCallbackUser;
+    std::atomic<std::int64_t> m_renderedFrames;
+
+    std::atomic<bool> m_idleDetection;
+    std::atomic<bool> m_keepAwake;
+    std::atomic<bool> m_idle;
+    std::int64_t m_quietFrames;
+    std::atomic<std::size_t> m_stackPrefault;
+
+    static const std::size_t PREWARM_QUEUE_SIZE = 256;
+    EAS_HANDLE m_warmStream;
+    SpscRing<MidiMessage, PREWARM_QUEUE_SIZE> m_warmQueue;
+    std::atomic<int> m_warmBlocks;
+    RenderStats m_stats;
+    RenderErrors m_errors;
+
+    std::atomic<bool> m_deterministic;
+    RenderChecksum m_checksum;
+    /* what reset() needs to rebuild the same initial state */
+    int m_soundLib;
+    std::string m_soundfont;
+    /* effects as requested by any thread, and as last passed to EAS by the render thread */
+    std::atomic<int> m_reverbType;
+    std::atomic<int> m_reverbWet;
+    std::atomic<int> m_chorusType;
+    std::atomic<int> m_chorusLevel;
+    int m_appliedReverbType;
+    int m_appliedReverbWet;
+    int m_appliedChorusType;
+    int m_appliedChorusLevel;
+};
+
+#endif // SYNTHENGINE_H
@@ -21,48 +21,185 @@
 #include <QCoreApplication>
 #include <QTextStream>
 #include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QRunnable>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
 
 #include <eas_chorus.h>
 #include <eas_report.h>
 #include <eas_reverb.h>
 
+#include "metadatacache.h"
 #include "programsettings.h"
+#include "rawmidiinput.h"
+#include "rendercache.h"
+#include "rtscope.h"
+#include "smfscanner.h"
 #include "synthrenderer.h"
+#include "tracer.h"
 #include "filewrapper.h"
 
 using namespace drumstick::rt;
 
+const QString SynthRenderer::BUILTIN_MIDI_DRIVER = QStringLiteral("RawMIDI");
+
+/* EAS playback rates are 28-bit fractional amounts */
+static const EAS_U32 NORMAL_PLAYBACK_RATE = (EAS_U32) (1L << 28);
+/* at most this many muted notes are played before a file starts */
+static const int PREWARM_MAX_NOTES = 32;
+/* blocks rendered with the file paused while they sound */
+static const int PREWARM_BLOCKS = 4;
+static const int DRUM_CHANNEL = 9;
+/* how often the main thread takes back the files the render path is done with */
+static const int FILE_SERVICE_INTERVAL = 20;
+/* how long the preparation thread waits for the end of a callback to borrow
+   the engine instance */
+static const int BORROW_TIMEOUT = 100;
+
+/* a playlist entry, opened and scanned on the preparation thread. The main
+   thread owns it until it is pushed to m_readyFiles, then the render path
+   does until it is given back through m_returnedFiles */
+struct SynthRenderer::PreparedFile {
+    QString fileName;
+    unsigned generation{0};
+    /* render-ahead, and the settings it is made with */
+    bool bounce{false};
+    bool renderCache{false};
+    BounceSettings settings;
+    std::unique_ptr<SongBouncer> bouncer;
+    std::unique_ptr<FileWrapper> file;
+    int duration{0};
+    std::vector<std::pair<int, MetaEvent>> events;
+    std::vector<MidiMessage> prewarmMessages;
+    bool prewarm{false};
+    /* deterministic mode: a fresh engine with the file already opened in it,
+       swapped in by the render path. Afterwards it holds the engine swapped out */
+    bool deterministic{false};
+    SynthEngine::Instance instance;
+    EAS_HANDLE handle{nullptr};
+    bool swapped{false};
+    /* played to the end, or failed to open, rather than stopped */
+    bool completed{false};
+
+    ~PreparedFile()
+    {
+        if (handle != nullptr) {
+            EAS_CloseFile(instance.easData, handle);
+        }
+        SynthEngine::releaseInstance(instance);
+    }
+};
+
+/* a layer file, opened in the shared instance on the preparation thread. The
+   render path owns it from m_readyPlayers until it gives it back through
+   m_returnedPlayers, and the preparation thread closes and deletes it */
+struct SynthRenderer::PlayerFile {
+    int player{-1};
+    QString fileName;
+    std::unique_ptr<FileWrapper> file;
+    EAS_HANDLE handle{nullptr};
+    /* the instance the stream was opened in */
+    std::uint32_t serial{0};
+    int duration{0};
+};
+
+static std::uint64_t packLoopPoints(int start, int end)
+{
+    return (std::uint64_t(std::uint32_t(start)) << 32) | std::uint32_t(end);
+}
+
+static void engineLogHandler(int level, const char *message)
+{
+    switch (level) {
+    case SynthEngine::LogCritical:
+        qCritical() << message;
+        break;
+    case SynthEngine::LogWarning:
+        qWarning() << message;
+        break;
+    default:
+        qDebug() << message;
+        break;
+    }
+}
+
 SynthRenderer::SynthRenderer(QObject *parent)
     : QIODevice(parent)
     , m_isPlaying(false)
+    , m_man(nullptr)
     , m_input(nullptr)
-    , m_currentFile(nullptr)
+    , m_rawInput(nullptr)
+    , m_easData(nullptr)
+    , m_fileHandle(nullptr)
+    , m_staleHandle(nullptr)
     , m_lastBufferSize(0)
     , m_soundfont("")
     , m_soundLib((E_EAS_SNDLIB_TYPE) ProgramSettings::DEFAULT_SOUND_LIB)
+    , m_reverbType(-1)
+    , m_reverbWet(-1)
+    , m_chorusType(-1)
+    , m_chorusLevel(-1)
+    , m_preparing(nullptr)
+    , m_handedFiles(0)
+    , m_reclaimedFiles(0)
+    , m_generation(0)
+    , m_current(nullptr)
+    , m_playerFiles(0)
+    , m_pendingSeek(-1)
+    , m_loopPoints(packLoopPoints(-1, -1))
+    , m_playbackRate(NORMAL_PLAYBACK_RATE)
+    , m_appliedRate(NORMAL_PLAYBACK_RATE)
+    , m_duration(0)
+    , m_deliveredFrames(0)
+    , m_nextFileEvent(0)
+    , m_prewarm(false)
+    , m_filePaused(false)
+    , m_bounce(false)
+    , m_renderCache(false)
+    , m_bouncing(false)
+    , m_bouncePosition(0)
 {
     //qDebug() << Q_FUNC_INFO;
+    SynthEngine::setLogHandler(&engineLogHandler);
+    m_engine.setBlockCallback(&SynthRenderer::blockRendered, this);
     m_soundLib = (E_EAS_SNDLIB_TYPE) ProgramSettings::instance()->soundLib();
-    initMIDI();
     initEAS();
+    /* one file at a time, in playlist order */
+    m_filePool.setMaxThreadCount(1);
+    m_fileTimer.setInterval(FILE_SERVICE_INTERVAL);
+    connect(&m_fileTimer, &QTimer::timeout, this, [this] { serviceFiles(); });
 }
 
+/* Drumstick plugins are only scanned and loaded when they are actually needed */
 void
-SynthRenderer::initMIDI()
+SynthRenderer::initMIDI() const
 {
+    if (m_man != nullptr) {
+        return;
+    }
+    m_man = new BackendManager();
     auto defaultsMap = QVariantMap{{BackendManager::QSTR_DRUMSTICKRT_PUBLICNAMEIN,
                                     QStringLiteral("MIDI IN")},
                                    {BackendManager::QSTR_DRUMSTICKRT_PUBLICNAMEOUT,
                                     QStringLiteral("MIDI OUT")}};
-    m_man.refresh(defaultsMap);
-    auto inputs = m_man.availableInputs();
+    m_man->refresh(defaultsMap);
+    auto inputs = m_man->availableInputs();
     //qDebug() << Q_FUNC_INFO << inputs;
     // qDebug() << Q_FUNC_INFO << ProgramSettings::DEFAULT_MIDI_DRIVER;
+}
+
+void
+SynthRenderer::ensureMIDIInput()
+{
     if (m_midiDriver.isEmpty()) {
         setMidiDriver(ProgramSettings::DEFAULT_MIDI_DRIVER);
     }
-    if (m_input == nullptr) {
-        qWarning() << Q_FUNC_INFO << "Input Backend is Missing. You may need to set the DRUMSTICKRT environment variable";    
+    if (m_input == nullptr && m_rawInput == nullptr) {
+        qWarning() << Q_FUNC_INFO << "Input Backend is Missing. You may need to set the DRUMSTICKRT environment variable";
     }
 }
 
@@ -71,65 +208,18 @@ SynthRenderer::initEAS()
 {
     //qDebug() << Q_FUNC_INFO;
     /* SONiVOX EAS initialization */
-    EAS_RESULT eas_res;
-    EAS_DATA_HANDLE dataHandle;
-    EAS_HANDLE handle;
-
-    const S_EAS_LIB_CONFIG *easConfig = EAS_Config();
-    if (easConfig == 0) {
-        qCritical() << Q_FUNC_INFO << "EAS_Config returned null";
-        return;
-    }
-
-    EAS_SetDebugFile(stderr, 1);
-    EAS_SetDebugLevel(_EAS_SEVERITY_ERROR);
-
-    eas_res = EAS_Init(&dataHandle);
-    if (eas_res != EAS_SUCCESS) {
-      qCritical() << Q_FUNC_INFO << "EAS_Init error: " << eas_res;
-      return;
-    }
-
-    const char *sndlib_name = EAS_GetDefaultSoundLibrary((E_EAS_SNDLIB_TYPE) m_soundLib);
-    if (sndlib_name == NULL) {
-        qCritical() << "Failed to get default sound library name";
-        return;
-    }
-    eas_res = EAS_SetSoundLibrary(dataHandle, NULL, EAS_GetSoundLibrary(dataHandle, sndlib_name));
-    if (eas_res != EAS_SUCCESS) {
-        qCritical() << Q_FUNC_INFO << "EAS_SetSoundLibrary error: " << eas_res;
+    const QByteArray soundfont = QFile::encodeName(m_soundfont);
+    if (!m_engine.init(m_soundLib, soundfont.isEmpty() ? nullptr : soundfont.constData())) {
         return;
     }
-
-    if (!m_soundfont.isEmpty()) {
-        FileWrapper Soundfont(m_soundfont);
-        if (Soundfont.ok()) {
-            eas_res = EAS_LoadDLSCollection(dataHandle, nullptr, Soundfont.getLocator());
-            if (eas_res != EAS_SUCCESS) {
-                qWarning() << QString("EAS_LoadDLSCollection(%1) error: %2")
-                                  .arg(m_soundfont)
-                                  .arg(eas_res);
-            }
-        } else {
-            qWarning() << "Failed to open" << m_soundfont;
-        }
-    }
-
-    eas_res = EAS_OpenMIDIStream(dataHandle, &handle, NULL);
-    if (eas_res != EAS_SUCCESS) {
-      qCritical() << Q_FUNC_INFO << "EAS_OpenMIDIStream error: " << eas_res;
-      EAS_Shutdown(dataHandle);
-      return;
+    m_easData = m_engine.easData();
+    if (m_prewarm && !m_engine.openWarmStream()) {
+        qWarning() << Q_FUNC_INFO << "no EAS stream left for the prewarm";
     }
-
-    m_easData = dataHandle;
-    m_streamHandle = handle;
-    assert(m_streamHandle != 0);
-    m_sampleRate = easConfig->sampleRate;
-    m_renderFrames = easConfig->mixBufferSize;
-    m_channels = easConfig->numChannels;
+    m_sampleRate = m_engine.sampleRate();
+    m_channels = m_engine.channels();
     m_sample_size = CHAR_BIT * sizeof (EAS_PCM);
-    //qDebug() << Q_FUNC_INFO << "EAS renderFrames=" << m_renderFrames << " sampleRate=" << m_sampleRate << " channels=" << m_channels;
+    //qDebug() << Q_FUNC_INFO << "EAS renderFrames=" << m_engine.blockFrames() << " sampleRate=" << m_sampleRate << " channels=" << m_channels;
 
     //QAudioFormat initialization;
     m_format.setSampleRate(m_sampleRate);
@@ -143,75 +233,128 @@ SynthRenderer::initEAS()
 #endif
 }
 
-void SynthRenderer::uninitEAS()
+/* the file being played, and the engines prepared for the next files in
+   deterministic mode, belong to the instance being replaced */
+void SynthRenderer::reinitEAS()
 {
-    EAS_RESULT eas_res;
-    if (m_easData != 0 && m_streamHandle != 0) {
-      eas_res = EAS_CloseMIDIStream(m_easData, m_streamHandle);
-      if (eas_res != EAS_SUCCESS) {
-          qWarning() << Q_FUNC_INFO << "EAS_CloseMIDIStream error: " << eas_res;
-      }
-      eas_res = EAS_Shutdown(m_easData);
-      if (eas_res != EAS_SUCCESS) {
-          qWarning() << Q_FUNC_INFO << "EAS_Shutdown error: " << eas_res;
-      }
+    Q_ASSERT_X(stopped(), Q_FUNC_INFO, "the engine is replaced while rendering");
+    /* the layer streams being opened or closed in the instance */
+    m_filePool.waitForDone();
+    const bool playing = m_current != nullptr || !m_readyFiles.isEmpty() || m_preparing != nullptr
+                         || !m_files.isEmpty();
+    stopPlayback();
+    if (m_current != nullptr) {
+        closePlayback();
+    }
+    uninitEAS();
+    initEAS();
+    serviceFiles();
+    if (playing) {
+        emit playbackStopped();
     }
 }
 
+void SynthRenderer::uninitEAS()
+{
+    closePlayers();
+    m_engine.shutdown();
+    m_easData = nullptr;
+    m_staleHandle = nullptr;
+}
+
 SynthRenderer::~SynthRenderer()
 {
     if (m_input != nullptr) {
         m_input->disconnect();
         m_input->close();
     }
+    delete m_rawInput;
+    delete m_man;
+    m_filePool.waitForDone();
+    delete m_preparing;
+    if (m_current != nullptr) {
+        closePlayback();
+    }
+    PreparedFile *file;
+    while (m_readyFiles.pop(file)) {
+        delete file;
+    }
+    while (m_returnedFiles.pop(file)) {
+        delete file;
+    }
     uninitEAS();
+    /* their streams went with the instance */
+    for (auto &player : m_players) {
+        delete player.file;
+        delete player.preparing;
+    }
     //qDebug() << Q_FUNC_INFO;
 }
 
 qint64 SynthRenderer::readData(char *data, qint64 maxlen)
 {
-    EAS_RESULT eas_res;
-    EAS_I32 numGen = 0;
-    const qint64 bufferSamples = m_renderFrames * m_channels;
-    const qint64 bufferBytes = bufferSamples * sizeof(EAS_PCM);
-    // qDebug() << Q_FUNC_INFO << "starting with maxlen:" << maxlen << bufferBytes;
+    RtScope rtScope;
+    TraceScope traceScope("readData");
+    if (Tracer::isEnabled()) {
+        Tracer::setThreadName("audio");
+    }
+    const auto startTime = std::chrono::steady_clock::now();
+    const std::uint64_t midiEvents = m_engine.stats().midiEvents();
+    const qint64 frames = m_format.framesForBytes(maxlen);
+    const qint64 bytes = m_format.bytesForFrames(frames);
+    m_capture.record(CaptureRecord::Render, m_deliveredFrames, std::int32_t(frames));
+    // qDebug() << Q_FUNC_INFO << "starting with maxlen:" << maxlen << frames;
 
+    /* the preparation thread is opening or closing a layer stream */
+    if (!m_engine.beginCallback()) {
+        std::memset(data, 0, size_t(bytes));
+        m_deliveredFrames += frames;
+        m_lastBufferSize = bytes;
+        return bytes;
+    }
+
+    /* a stopped file gives way at once to the next one handed over */
+    if (m_current != nullptr && m_current->generation != m_generation.load(std::memory_order_acquire)) {
+        closePlayback();
+    }
+    if (m_current == nullptr && !m_readyFiles.isEmpty()) {
+        startNextFile();
+    }
+
+    /* file playback keeps the engine awake; live MIDI wakes it up on its own */
+    const bool players = updatePlayers();
+    m_engine.setKeepAwake((m_isPlaying && !m_bouncing) || players);
     if (m_isPlaying) {
-        int t = getPlaybackLocation();
-        emit playbackTime(t);
-    }
-
-    while (m_audioBuffer.size() < maxlen) {
-        QByteArray buf{bufferBytes, '\0'};
-        eas_res = EAS_Render(m_easData,
-                             reinterpret_cast<EAS_PCM *>(buf.data()),
-                             m_renderFrames,
-                             &numGen);
-        if (eas_res == EAS_SUCCESS) {
-            m_audioBuffer.append(buf);
-        } else {
-            qWarning() << Q_FUNC_INFO << "EAS_Render() error:" << eas_res;
-        }
+        applyPendingSeek();
+        applyPlaybackRate();
+        m_snapshot.setPlaybackTime(getPlaybackLocation());
     }
 
-    if (maxlen > 0) {
-        memcpy(data, m_audioBuffer.constData(), maxlen);
-        m_audioBuffer.remove(0, maxlen);
+    if (frames > 0) {
+        m_engine.render(reinterpret_cast<std::int16_t *>(data), frames);
+        if (m_isPlaying && m_bouncing) {
+            playBounce(reinterpret_cast<std::int16_t *>(data), frames);
+        }
+        m_deliveredFrames += frames;
     }
 
+    /* the main thread tells the end of the playlist when it takes the file back */
     if (m_isPlaying && isPlaybackCompleted()) {
+        m_current->completed = true;
         closePlayback();
-        if (m_files.isEmpty()) {
-            m_isPlaying = false;
-            emit playbackStopped();
-        } else {
-            preparePlayback();
-        }
     }
+    m_engine.endCallback();
 
-    m_lastBufferSize = maxlen;
-    //qDebug() << Q_FUNC_INFO << "before returning" << buflen;
-    return maxlen;
+    m_lastBufferSize = bytes;
+    const std::int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    m_engine.stats().addCallback(elapsed);
+    m_flightRecorder.record(FlightRecorder::Callback,
+                            frames,
+                            elapsed,
+                            m_engine.stats().midiEvents() - midiEvents);
+    //qDebug() << Q_FUNC_INFO << "before returning" << bytes;
+    return bytes;
 }
 
 qint64 SynthRenderer::writeData(const char *data, qint64 len)
@@ -245,12 +388,12 @@ void
 SynthRenderer::start()
 {
     Q_ASSERT_X(!isOpen(), Q_FUNC_INFO, "renderer already open");
-    m_isPlaying = false;
+    m_engine.clearMIDI();
+    m_snapshot.allNotesOff();
     /*bool ok =*/ open(QIODevice::ReadOnly | QIODevice::Unbuffered);
     // qDebug() << Q_FUNC_INFO << "opened:" << ok;
-    if (m_files.length() > 0) {
-        preparePlayback();
-    }
+    /* the files handed over meanwhile start on the first callback */
+    serviceFiles();
 }
 
 void
@@ -260,14 +403,31 @@ SynthRenderer::stop()
     if (isOpen()) {
         close();
     }
+    /* the file being played goes on when the output starts again */
+    serviceFiles();
+    m_snapshot.allNotesOff();
 }
 
 QStringList 
 SynthRenderer::connections() const
 {
-    Q_ASSERT_X(m_input != nullptr, Q_FUNC_INFO, "MIDI input is null");
+    /* Without a selected driver, list the ports of the default one */
+    const QString driver = m_midiDriver.isEmpty() ? ProgramSettings::DEFAULT_MIDI_DRIVER
+                                                  : m_midiDriver;
+    if (driver == BUILTIN_MIDI_DRIVER) {
+        return RawMidiInput::availablePorts();
+    }
+    MIDIInput *input = m_input;
+    if (input == nullptr && m_midiDriver.isEmpty()) {
+        initMIDI();
+        input = m_man->inputBackendByName(driver);
+    }
     QStringList result;
-    auto avail = m_input->connections(true);
+    if (input == nullptr) {
+        qWarning() << Q_FUNC_INFO << "Input Backend is Missing. You may need to set the DRUMSTICKRT environment variable";
+        return result;
+    }
+    auto avail = input->connections(true);
     foreach(const auto &c, avail) {
         result << c.first;
     }
@@ -286,7 +446,17 @@ void
 SynthRenderer::subscribe(const QString& portName)
 {
     // qDebug() << Q_FUNC_INFO << portName;
+    ensureMIDIInput();
+    if (m_rawInput != nullptr) {
+        if (m_portName != portName && m_rawInput->open(portName)) {
+            m_portName = portName;
+        }
+        return;
+    }
     Q_ASSERT(m_input != nullptr);
+    if (m_input == nullptr) {
+        return;
+    }
     if (m_portName != portName || portName.isEmpty()) {
         auto avail = m_input->connections(true);
         auto it = std::find_if(avail.constBegin(),
@@ -317,11 +487,21 @@ SynthRenderer::setMidiDriver(const QString newMidiDriver)
     if (m_midiDriver != newMidiDriver) {
         //qDebug() << Q_FUNC_INFO << newMidiDriver;
         m_midiDriver = newMidiDriver;
+        m_portName.clear();
         if (m_input != nullptr) {
             m_input->disconnect();
             m_input->close();
+            m_input = nullptr;
+        }
+        delete m_rawInput;
+        m_rawInput = nullptr;
+        if (m_midiDriver == BUILTIN_MIDI_DRIVER) {
+            m_rawInput = new RawMidiInput(this);
+            m_rawInput->setCallback([this](const MidiMessage &msg) { midiMessage(msg); });
+            return;
         }
-        m_input = m_man.inputBackendByName(m_midiDriver);
+        initMIDI();
+        m_input = m_man->inputBackendByName(m_midiDriver);
         if (m_input != nullptr) {
             QObject::connect(m_input, &MIDIInput::midiNoteOn, this, &SynthRenderer::noteOn);
             QObject::connect(m_input, &MIDIInput::midiNoteOff, this, &SynthRenderer::noteOff);
@@ -338,75 +518,78 @@ void
 SynthRenderer::noteOn(int chan, int note, int vel) 
 {
     // qDebug() << Q_FUNC_INFO << chan << note << vel;
-    QByteArray ev(3, 0);
-    ev[0] = MIDI_STATUS_NOTEON | chan;
-    ev[1] = 0xff & note;
-    ev[2] = 0xff & vel;
-    writeMIDIData(ev);
-    emit midiNoteOn(note,vel);
+    const EAS_U8 ev[] = {EAS_U8(MIDI_STATUS_NOTEON | chan), EAS_U8(0xff & note), EAS_U8(0xff & vel)};
+    queueMIDIData(ev, sizeof(ev));
+    m_snapshot.noteOn(chan, note, vel);
 }
 
 void 
 SynthRenderer::noteOff(int chan, int note, int vel) 
 {
     //qDebug() << Q_FUNC_INFO << chan << note << vel;
-    QByteArray ev(3, 0);
-    ev[0] = MIDI_STATUS_NOTEOFF | chan;
-    ev[1] = 0xff & note;
-    ev[2] = 0xff & vel;
-    writeMIDIData(ev);
-    emit midiNoteOff(note,vel);
+    const EAS_U8 ev[] = {EAS_U8(MIDI_STATUS_NOTEOFF | chan), EAS_U8(0xff & note), EAS_U8(0xff & vel)};
+    queueMIDIData(ev, sizeof(ev));
+    m_snapshot.noteOff(chan, note);
 }
 
 void 
 SynthRenderer::keyPressure(const int chan, const int note, const int value) 
 {
     //qDebug() << Q_FUNC_INFO << chan << note << value;
-    QByteArray ev(3, 0);
-    ev[0] = MIDI_STATUS_KEYPRESURE | chan;
-    ev[1] = 0xff & note;
-    ev[2] = 0xff & value;
-    writeMIDIData(ev);
+    const EAS_U8 ev[] = {EAS_U8(MIDI_STATUS_KEYPRESURE | chan), EAS_U8(0xff & note), EAS_U8(0xff & value)};
+    queueMIDIData(ev, sizeof(ev));
 }
 
 void 
 SynthRenderer::controller(const int chan, const int control, const int value) 
 {
     //qDebug() << Q_FUNC_INFO << chan << control << value;
-    QByteArray ev(3, 0);
-    ev[0] = MIDI_STATUS_CONTROLCHANGE | chan;
-    ev[1] = 0xff & control;
-    ev[2] = 0xff & value;
-    writeMIDIData(ev);
+    const EAS_U8 ev[] = {EAS_U8(MIDI_STATUS_CONTROLCHANGE | chan), EAS_U8(0xff & control), EAS_U8(0xff & value)};
+    queueMIDIData(ev, sizeof(ev));
+    if (control == 120 || control == 123) { // all sound off, all notes off
+        m_snapshot.allNotesOff(chan);
+    }
 }
 
 void SynthRenderer::program(const int chan, const int program) 
 {
     //qDebug() << Q_FUNC_INFO << chan << program;
-    QByteArray ev(2, 0);
-    ev[0] = MIDI_STATUS_PROGRAMCHANGE | chan;
-    ev[1] = 0xff & program;
-    writeMIDIData(ev);
+    const EAS_U8 ev[] = {EAS_U8(MIDI_STATUS_PROGRAMCHANGE | chan), EAS_U8(0xff & program)};
+    queueMIDIData(ev, sizeof(ev));
 }
 
 void SynthRenderer::channelPressure(const int chan, const int value) 
 {
     //qDebug() << Q_FUNC_INFO << chan << value;
-    QByteArray ev(2, 0);
-    ev[0] = MIDI_STATUS_CHANNELPRESSURE | chan;
-    ev[1] = 0xff & value;
-    writeMIDIData(ev);
+    const EAS_U8 ev[] = {EAS_U8(MIDI_STATUS_CHANNELPRESSURE | chan), EAS_U8(0xff & value)};
+    queueMIDIData(ev, sizeof(ev));
 }
 
 void SynthRenderer::pitchBend(const int chan, const int v) 
 {
     //qDebug() << Q_FUNC_INFO << chan << v;;
-    QByteArray ev(3, 0);
     int value = 8192 + v;
-    ev[0] = MIDI_STATUS_PITCHBEND | chan;
-    ev[1] = MIDI_LSB(value);
-    ev[2] = MIDI_MSB(value);
-    writeMIDIData(ev);
+    const EAS_U8 ev[] = {EAS_U8(MIDI_STATUS_PITCHBEND | chan), EAS_U8(MIDI_LSB(value)), EAS_U8(MIDI_MSB(value))};
+    queueMIDIData(ev, sizeof(ev));
+}
+
+void SynthRenderer::midiMessage(const MidiMessage &msg)
+{
+    //qDebug() << Q_FUNC_INFO << QByteArray((const char *) msg.data, msg.length).toHex();
+    if (msg.length == 0) {
+        return;
+    }
+    queueMIDIData(msg.data, msg.length);
+    const int status = msg.data[0] & 0xf0;
+    const int chan = msg.data[0] & 0x0f;
+    if (status == MIDI_STATUS_NOTEON && msg.length == 3) {
+        m_snapshot.noteOn(chan, msg.data[1], msg.data[2]);
+    } else if (status == MIDI_STATUS_NOTEOFF && msg.length == 3) {
+        m_snapshot.noteOff(chan, msg.data[1]);
+    } else if (status == MIDI_STATUS_CONTROLCHANGE && msg.length == 3
+               && (msg.data[1] == 120 || msg.data[1] == 123)) {
+        m_snapshot.allNotesOff(chan);
+    }
 }
 
 qint64 SynthRenderer::lastBufferSize() const
@@ -419,10 +602,180 @@ void SynthRenderer::resetLastBufferSize()
     m_lastBufferSize = 0;
 }
 
-void SynthRenderer::reserveBuffer(qsizetype size)
+const SynthSnapshot &SynthRenderer::snapshot() const
+{
+    return m_snapshot;
+}
+
+void SynthRenderer::emitSnapshotSignals()
+{
+    const std::uint32_t serial = m_snapshot.serial();
+    const bool keysChanged = serial != m_signalSerial;
+    m_signalSerial = serial;
+    SynthSnapshot::State state;
+    m_snapshot.read(state);
+    if (keysChanged) {
+        for (int note = 0; note < SynthSnapshot::NUM_KEYS; ++note) {
+            const int vel = state.noteVelocity(note);
+            if (vel > 0 && !m_signalState.isNoteOn(note)) {
+                emit midiNoteOn(note, vel);
+            } else if (vel == 0 && m_signalState.isNoteOn(note)) {
+                emit midiNoteOff(note, 0);
+            }
+        }
+    }
+    if (state.playing && state.playbackTime != m_signalTime) {
+        emit playbackTime(state.playbackTime);
+    }
+    m_signalTime = state.playing ? state.playbackTime : -1;
+    m_signalState = state;
+}
+
+void SynthRenderer::setIdleDetection(bool enabled)
+{
+    m_engine.setIdleDetection(enabled);
+}
+
+bool SynthRenderer::idleDetection() const
+{
+    return m_engine.idleDetection();
+}
+
+void SynthRenderer::setBounce(bool enabled)
+{
+    m_bounce = enabled;
+}
+
+bool SynthRenderer::bounce() const
+{
+    return m_bounce;
+}
+
+void SynthRenderer::setRenderCache(bool enabled)
+{
+    m_renderCache = enabled;
+}
+
+bool SynthRenderer::renderCache() const
+{
+    return m_renderCache;
+}
+
+/* the warm stream stays open while the prewarm is enabled, so the render
+   path never opens or closes it */
+void SynthRenderer::setPrewarm(bool enabled)
+{
+    if (enabled == m_prewarm) {
+        return;
+    }
+    if (!m_engine.borrowInstance(BORROW_TIMEOUT)) {
+        qWarning() << Q_FUNC_INFO << "the engine is busy";
+        return;
+    }
+    bool opened = true;
+    if (enabled) {
+        opened = m_engine.openWarmStream();
+    } else {
+        m_engine.closeWarmStream();
+    }
+    m_engine.returnInstance();
+    if (!opened) {
+        qWarning() << Q_FUNC_INFO << "no EAS stream left for the prewarm";
+        return;
+    }
+    m_prewarm = enabled;
+}
+
+bool SynthRenderer::prewarm() const
 {
-    //qDebug() << Q_FUNC_INFO << size;
-    m_audioBuffer.reserve(size);
+    return m_prewarm;
+}
+
+bool SynthRenderer::isIdle() const
+{
+    return m_engine.isIdle();
+}
+
+/* a file being played would be advanced, so it only runs on an idle stream */
+void SynthRenderer::warmUp(int blocks)
+{
+    if (m_fileHandle == nullptr && m_engine.borrowInstance(0)) {
+        m_engine.warmUp(blocks);
+        m_engine.returnInstance();
+    }
+}
+
+void SynthRenderer::requestStackPrefault(std::size_t bytes)
+{
+    m_engine.requestStackPrefault(bytes);
+}
+
+const RenderStats &SynthRenderer::stats() const
+{
+    return m_engine.stats();
+}
+
+RenderErrors &SynthRenderer::errors()
+{
+    return m_engine.errors();
+}
+
+bool SynthRenderer::startCapture(const QString &fileName)
+{
+    MidiCapture::Header header;
+    header.sampleRate = m_sampleRate;
+    header.channels = m_channels;
+    header.blockFrames = m_engine.blockFrames();
+    if (!m_capture.open(QFile::encodeName(fileName).constData(), header)) {
+        qWarning() << Q_FUNC_INFO << "cannot create" << fileName;
+        return false;
+    }
+    /* the settings made before the capture started */
+    m_capture.record(CaptureRecord::Reverb, m_deliveredFrames, m_reverbType);
+    if (m_reverbWet >= 0) {
+        m_capture.record(CaptureRecord::ReverbWet, m_deliveredFrames, m_reverbWet);
+    }
+    m_capture.record(CaptureRecord::Chorus, m_deliveredFrames, m_chorusType);
+    if (m_chorusLevel >= 0) {
+        m_capture.record(CaptureRecord::ChorusLevel, m_deliveredFrames, m_chorusLevel);
+    }
+    m_capture.record(CaptureRecord::PlaybackRate,
+                     m_deliveredFrames,
+                     qRound(qreal(m_playbackRate) * 1000 / NORMAL_PLAYBACK_RATE));
+    return true;
+}
+
+void SynthRenderer::stopCapture()
+{
+    m_capture.close();
+    if (m_capture.dropped() > 0) {
+        qWarning() << Q_FUNC_INFO << m_capture.dropped() << "records lost, the capture queue was full";
+    }
+}
+
+MidiCapture &SynthRenderer::capture()
+{
+    return m_capture;
+}
+
+FlightRecorder &SynthRenderer::flightRecorder()
+{
+    return m_flightRecorder;
+}
+
+void SynthRenderer::setDeterministic(bool enabled)
+{
+    m_engine.setDeterministic(enabled);
+}
+
+bool SynthRenderer::deterministic() const
+{
+    return m_engine.deterministic();
+}
+
+RenderChecksum &SynthRenderer::checksum()
+{
+    return m_engine.checksum();
 }
 
 const QAudioFormat&
@@ -432,20 +785,11 @@ SynthRenderer::format() const
 }
 
 void
-SynthRenderer::writeMIDIData(QByteArray &ev)
+SynthRenderer::queueMIDIData(const EAS_U8 *data, int length)
 {
-    EAS_RESULT eas_res = EAS_ERROR_ALREADY_STOPPED;
-    const EAS_I32 count = ev.size();
-
-    if (m_easData != 0 && m_streamHandle != 0 && !ev.isEmpty())
-    {
-        if (count > 0) {
-            //qDebug() << Q_FUNC_INFO << QByteArray((char *)&buffer, count).toHex();
-            eas_res = EAS_WriteMIDIStream(m_easData, m_streamHandle, reinterpret_cast<EAS_U8*>(ev.data()), count);
-            if (eas_res != EAS_SUCCESS) {
-                qWarning() << "EAS_WriteMIDIStream error: " << eas_res;
-            }
-        }
+    m_capture.recordMidi(m_deliveredFrames, data, length);
+    if (!m_engine.writeMIDI(data, length)) {
+        m_engine.errors().report(RenderErrors::MidiQueueFull, 0);
     }
 }
 
@@ -453,38 +797,20 @@ void
 SynthRenderer::initReverb(int reverb_type)
 {
     //qDebug() << Q_FUNC_INFO;
-    EAS_RESULT eas_res;
-    EAS_BOOL sw = EAS_TRUE;
-    if ( reverb_type >= EAS_PARAM_REVERB_LARGE_HALL && reverb_type <= EAS_PARAM_REVERB_ROOM ) {
-        sw = EAS_FALSE;
-        eas_res = EAS_SetParameter(m_easData, EAS_MODULE_REVERB, EAS_PARAM_REVERB_PRESET, (EAS_I32) reverb_type);
-        if (eas_res != EAS_SUCCESS) {
-            qWarning() << "EAS_SetParameter error:" << eas_res;
-        }
-    }
-    eas_res = EAS_SetParameter(m_easData, EAS_MODULE_REVERB, EAS_PARAM_REVERB_BYPASS, sw);
-    if (eas_res != EAS_SUCCESS) {
-        qWarning() << "EAS_SetParameter error: " << eas_res;
-    }
+    m_capture.record(CaptureRecord::Reverb, m_deliveredFrames, reverb_type);
+    m_flightRecorder.record(FlightRecorder::Parameter, FlightRecorder::Reverb, reverb_type);
+    m_reverbType = reverb_type;
+    m_engine.setReverb(reverb_type);
 }
 
 void
 SynthRenderer::initChorus(int chorus_type)
 {
     //qDebug() << Q_FUNC_INFO;
-    EAS_RESULT eas_res;
-    EAS_BOOL sw = EAS_TRUE;
-    if (chorus_type >= EAS_PARAM_CHORUS_PRESET1 && chorus_type <= EAS_PARAM_CHORUS_PRESET4 ) {
-        sw = EAS_FALSE;
-        eas_res = EAS_SetParameter(m_easData, EAS_MODULE_CHORUS, EAS_PARAM_CHORUS_PRESET, (EAS_I32) chorus_type);
-        if (eas_res != EAS_SUCCESS) {
-            qWarning() << "EAS_SetParameter error:" << eas_res;
-        }
-    }
-    eas_res = EAS_SetParameter(m_easData, EAS_MODULE_CHORUS, EAS_PARAM_CHORUS_BYPASS, sw);
-    if (eas_res != EAS_SUCCESS) {
-        qWarning() << "EAS_SetParameter error:" << eas_res;
-    }
+    m_capture.record(CaptureRecord::Chorus, m_deliveredFrames, chorus_type);
+    m_flightRecorder.record(FlightRecorder::Parameter, FlightRecorder::Chorus, chorus_type);
+    m_chorusType = chorus_type;
+    m_engine.setChorus(chorus_type);
 }
 
 void SynthRenderer::initSoundLib(int sound_lib)
@@ -492,29 +818,33 @@ void SynthRenderer::initSoundLib(int sound_lib)
     if (m_soundLib != sound_lib) {
         //qDebug() << Q_FUNC_INFO << sound_lib;
         m_soundLib = (E_EAS_SNDLIB_TYPE) sound_lib;
-        uninitEAS();
-        initEAS();
+        reinitEAS();
     }
 }
 
+int SynthRenderer::soundLib() const
+{
+    return m_soundLib;
+}
+
 void
 SynthRenderer::setReverbWet(int amount)
 {
     //qDebug() << Q_FUNC_INFO;
-    EAS_RESULT eas_res = EAS_SetParameter(m_easData, EAS_MODULE_REVERB, EAS_PARAM_REVERB_WET, (EAS_I32) amount);
-    if (eas_res != EAS_SUCCESS) {
-        qWarning() << "EAS_SetParameter error:" << eas_res;
-    }
+    m_capture.record(CaptureRecord::ReverbWet, m_deliveredFrames, amount);
+    m_flightRecorder.record(FlightRecorder::Parameter, FlightRecorder::ReverbWet, amount);
+    m_reverbWet = amount;
+    m_engine.setReverbWet(amount);
 }
 
 void
 SynthRenderer::setChorusLevel(int amount)
 {
     //qDebug() << Q_FUNC_INFO;
-    EAS_RESULT eas_res = EAS_SetParameter(m_easData, EAS_MODULE_CHORUS, EAS_PARAM_CHORUS_LEVEL, (EAS_I32) amount);
-    if (eas_res != EAS_SUCCESS) {
-        qWarning() << "EAS_SetParameter error:" << eas_res;
-    }
+    m_capture.record(CaptureRecord::ChorusLevel, m_deliveredFrames, amount);
+    m_flightRecorder.record(FlightRecorder::Parameter, FlightRecorder::ChorusLevel, amount);
+    m_chorusLevel = amount;
+    m_engine.setChorusLevel(amount);
 }
 
 void SynthRenderer::initSoundfont(const QString soundfont)
@@ -522,63 +852,330 @@ void SynthRenderer::initSoundfont(const QString soundfont)
     if (m_soundfont != soundfont) {
         //qDebug() << Q_FUNC_INFO << soundfont;
         m_soundfont = soundfont;
-        uninitEAS();
-        initEAS();
+        reinitEAS();
     }
 }
 
+QString SynthRenderer::soundfont() const
+{
+    return m_soundfont;
+}
+
 void
 SynthRenderer::playFile(const QString fileName)
 {
     //qDebug() << Q_FUNC_INFO << fileName;
     m_files.append(fileName);
+    serviceFiles();
+}
+
+/* main thread: takes back the files the render path is done with, and keeps
+   the next one prepared ahead. Two files at most are out, the one playing
+   and the next, so neither ring can overflow */
+void
+SynthRenderer::serviceFiles(bool finished)
+{
+    PreparedFile *file;
+    while (m_returnedFiles.pop(file)) {
+        ++m_reclaimedFiles;
+        finished = finished || file->completed;
+        /* a running bounce is cancelled here, a finished one is kept for replays */
+        if (file->bouncer && file->bouncer->state() == SongBouncer::Finished) {
+            m_lastBounce = std::move(file->bouncer);
+        }
+        delete file;
+    }
+    if (m_preparing == nullptr && !m_files.isEmpty()
+        && m_handedFiles - m_reclaimedFiles < int(READY_FILES)) {
+        prepareNextFile();
+    }
+    servicePlayers();
+    if (m_handedFiles == m_reclaimedFiles && finished && m_preparing == nullptr
+        && m_files.isEmpty()) {
+        emit playbackStopped();
+    }
+    /* the layer files held by the render path are given back the same way */
+    if (m_handedFiles == m_reclaimedFiles && m_playerFiles == 0) {
+        m_fileTimer.stop();
+    } else if (!m_fileTimer.isActive()) {
+        m_fileTimer.start();
+    }
+}
+
+void
+SynthRenderer::prepareNextFile()
+{
+    PreparedFile *file = new PreparedFile;
+    file->fileName = m_files.takeFirst();
+    file->generation = m_generation.load(std::memory_order_relaxed);
+    file->bounce = m_bounce;
+    file->renderCache = m_renderCache;
+    file->deterministic = m_engine.deterministic();
+    file->prewarm = m_prewarm;
+    file->settings.soundLib = m_soundLib;
+    file->settings.soundfont = QFile::encodeName(m_soundfont).toStdString();
+    file->settings.reverbType = m_reverbType;
+    file->settings.reverbWet = m_reverbWet;
+    file->settings.chorusType = m_chorusType;
+    file->settings.chorusLevel = m_chorusLevel;
+    if (file->bounce || file->renderCache) {
+        /* replaying the last file costs nothing */
+        if (m_lastBounce && m_lastBounce->settings() == file->settings
+            && m_lastBounce->path() == QFile::encodeName(file->fileName).toStdString()) {
+            file->bouncer = std::move(m_lastBounce);
+        }
+    }
+    m_preparing = file;
+    m_filePool.start(QRunnable::create([this, file] {
+        prepareFile(file);
+        QMetaObject::invokeMethod(this, [this] { filePrepared(); }, Qt::QueuedConnection);
+    }));
 }
 
+/* preparation thread: all the disk access before the render path opens the file */
 void
-SynthRenderer::preparePlayback()
+SynthRenderer::prepareFile(PreparedFile *file)
+{
+    TraceScope traceScope("prepareFile");
+    /* the length is known, and the file checked, before it is handed over */
+    const MidiFileInfo info = MetadataCache::instance()->scanFile(file->fileName);
+    if (!info.isValid()) {
+        return;
+    }
+    file->duration = info.duration;
+    if ((file->bounce || file->renderCache) && !file->bouncer) {
+        prepareBounce(file);
+    }
+    loadFileEvents(file);
+    if (!file->bouncer) {
+        file->file.reset(new FileWrapper(file->fileName));
+        if (file->deterministic && file->file->ok()) {
+            prepareInstance(file);
+        }
+    }
+}
+
+/* preparation thread: the engine initialization and DLS load kept off the render path */
+void
+SynthRenderer::prepareInstance(PreparedFile *file)
+{
+    TraceScope traceScope("prepareInstance");
+    EAS_RESULT result;
+    const BounceSettings &settings = file->settings;
+    if (!SynthEngine::createInstance(settings.soundLib,
+                                     settings.soundfont.empty() ? nullptr
+                                                                : settings.soundfont.c_str(),
+                                     file->instance,
+                                     file->prewarm)) {
+        qWarning() << Q_FUNC_INFO << "cannot create an engine for" << file->fileName;
+        return;
+    }
+    if ((result = EAS_OpenFile(file->instance.easData, file->file->getLocator(), &file->handle))
+        != EAS_SUCCESS) {
+        qWarning() << Q_FUNC_INFO << "EAS_OpenFile error:" << result;
+        file->handle = nullptr;
+        return;
+    }
+    if ((result = EAS_Prepare(file->instance.easData, file->handle)) != EAS_SUCCESS) {
+        qWarning() << Q_FUNC_INFO << "EAS_Prepare error:" << result;
+        EAS_CloseFile(file->instance.easData, file->handle);
+        file->handle = nullptr;
+    }
+}
+
+/* preparation thread: a cached render is loaded, or the render-ahead started */
+void
+SynthRenderer::prepareBounce(PreparedFile *file)
+{
+    TraceScope traceScope("prepareBounce");
+    const BounceSettings &settings = file->settings;
+    const std::string path = QFile::encodeName(file->fileName).toStdString();
+    std::unique_ptr<SongBouncer> bouncer(new SongBouncer);
+    if (file->renderCache) {
+        QFile midi(file->fileName);
+        if (!midi.open(QIODevice::ReadOnly)) {
+            return;
+        }
+        const QByteArray key = RenderCache::instance()->key(midi.readAll(), settings);
+        std::vector<std::int16_t> samples;
+        int sampleRate, channels, duration;
+        if (RenderCache::instance()->lookup(key, samples, sampleRate, channels, duration)) {
+            bouncer->load(path, settings, std::move(samples), sampleRate, channels, duration);
+        } else if (!file->bounce
+                   || !bouncer->start(path, settings, [key](const SongBouncer &done) {
+                          RenderCache::instance()->store(key,
+                                                         done.samples(),
+                                                         done.availableFrames(),
+                                                         done.sampleRate(),
+                                                         done.channels(),
+                                                         done.duration());
+                      })) {
+            /* without render-ahead, a cache miss plays the file live */
+            return;
+        }
+    } else if (!bouncer->start(path, settings)) {
+        return;
+    }
+    file->bouncer = std::move(bouncer);
+}
+
+void
+SynthRenderer::filePrepared()
+{
+    PreparedFile *file = m_preparing;
+    m_preparing = nullptr;
+    bool failed = false;
+    if (file->generation != m_generation.load(std::memory_order_relaxed)) {
+        delete file;
+    } else if (!file->bouncer && (!file->file || !file->file->ok())) {
+        qWarning() << Q_FUNC_INFO << "cannot play" << file->fileName;
+        delete file;
+        failed = true;
+    } else if (m_readyFiles.push(file)) {
+        ++m_handedFiles;
+    } else {
+        delete file;
+    }
+    serviceFiles(failed);
+}
+
+/* render path: the next file handed over, skipping the stopped ones */
+void
+SynthRenderer::startNextFile()
+{
+    TraceScope traceScope("startNextFile");
+    PreparedFile *file;
+    while (m_current == nullptr && m_readyFiles.pop(file)) {
+        m_current = file;
+        if (file->generation != m_generation.load(std::memory_order_acquire)) {
+            closePlayback();
+        } else if (!openCurrentFile()) {
+            m_current->completed = true;
+            closePlayback();
+        }
+    }
+}
+
+bool
+SynthRenderer::openCurrentFile()
 {
     EAS_HANDLE handle;
     EAS_RESULT result;
-    EAS_I32 playTime;
-    if (!m_files.isEmpty()) 
-    {
-        m_currentFile = new FileWrapper(m_files.first());
-        m_files.removeFirst();
+    PreparedFile *file = m_current;
+    m_nextFileEvent = 0;
+    if (file->bouncer) {
+        startBounce();
+        return true;
+    }
+    if (file->handle != nullptr) {
+        /* the same file always starts from the same engine state and block: the
+           engine prepared with it is swapped in, and the current one handed back
+           with its streams, to be shut down on the main thread. Nothing is
+           opened or closed here */
+        detachPlayers();
+        if (!m_engine.reset(file->instance)) {
+            return false;
+        }
+        /* the stale stream went with the instance swapped out */
+        m_staleHandle = nullptr;
+        m_easData = m_engine.easData();
+        handle = file->handle;
+        file->handle = nullptr;
+        file->swapped = true;
+    } else {
+        /* deterministic mode was turned off */
+        if (m_staleHandle != nullptr) {
+            if ((result = EAS_CloseFile(m_easData, m_staleHandle)) != EAS_SUCCESS) {
+                m_engine.errors().report(RenderErrors::CloseFileFailed, result);
+            }
+            m_staleHandle = nullptr;
+        }
         /* call EAS library to open file */
-        if ((result = EAS_OpenFile(m_easData, m_currentFile->getLocator(), &handle)) != EAS_SUCCESS)
-        {
-            qWarning() << Q_FUNC_INFO << "EAS_OpenFile" << result;
-            return;
+        if ((result = EAS_OpenFile(m_easData, file->file->getLocator(), &handle)) != EAS_SUCCESS) {
+            m_engine.errors().report(RenderErrors::OpenFileFailed, result);
+            return false;
         }
         /* prepare to play the file */
-        if ((result = EAS_Prepare(m_easData, handle)) != EAS_SUCCESS)
-        {
-            qWarning() << Q_FUNC_INFO << "EAS_Prepare" << result;
-            return;
+        if ((result = EAS_Prepare(m_easData, handle)) != EAS_SUCCESS) {
+            m_engine.errors().report(RenderErrors::PrepareFailed, result);
+            EAS_CloseFile(m_easData, handle);
+            return false;
         }
-        /* get play length */
-        if ((result = EAS_ParseMetaData(m_easData, handle, &playTime)) != EAS_SUCCESS)
-        {
-            qWarning() << Q_FUNC_INFO << "EAS_ParseMetaData. result=" << result;
-            return;
+    }
+    /* the length was scanned on the preparation thread, so EAS only parses it to play */
+    result = EAS_RegisterMetaDataCallback(m_easData,
+                                          handle,
+                                          &SynthRenderer::metaDataCallback,
+                                          m_metaDataBuffer,
+                                          sizeof(m_metaDataBuffer),
+                                          this);
+    if (result != EAS_SUCCESS) {
+        m_engine.errors().report(RenderErrors::PrepareFailed, result);
+    }
+    m_duration = file->duration;
+    m_fileHandle = handle;
+    m_appliedRate = NORMAL_PLAYBACK_RATE;
+    applyPlaybackRate();
+    /* the file waits paused while its instruments are pre-warmed */
+    m_filePaused = false;
+    if (m_prewarm && !file->prewarmMessages.empty() && m_engine.hasWarmStream()
+        && EAS_Pause(m_easData, handle) == EAS_SUCCESS) {
+        m_filePaused = m_engine.prewarm(file->prewarmMessages.data(),
+                                        file->prewarmMessages.size(),
+                                        PREWARM_BLOCKS);
+        if (!m_filePaused) {
+            EAS_Resume(m_easData, handle);
         }
-        // else
-        // {
-        //     qDebug() << Q_FUNC_INFO << "EAS_ParseMetaData. playTime=" << playTime;
-        // }
-        m_fileHandle = handle;
-        m_isPlaying = true;
     }
+    m_isPlaying = true;
+    m_snapshot.setPlaybackTime(0);
+    m_snapshot.setPlaying(true);
+    m_flightRecorder.record(FlightRecorder::FileOpened, m_duration);
+    return true;
+}
+
+/* render path: the bounce is ready to be mixed, or being rendered ahead */
+void
+SynthRenderer::startBounce()
+{
+    m_duration = m_current->duration > 0 ? m_current->duration : m_current->bouncer->duration();
+    m_bouncePosition = 0;
+    m_bouncing = true;
+    m_isPlaying = true;
+    m_snapshot.setPlaybackTime(0);
+    m_snapshot.setPlaying(true);
+    m_flightRecorder.record(FlightRecorder::FileOpened, m_duration);
+}
+
+void
+SynthRenderer::playBounce(std::int16_t *output, qint64 frames)
+{
+    const SongBouncer &bouncer = *m_current->bouncer;
+    if (m_duration <= 0 && bouncer.duration() >= 0) {
+        m_duration = bouncer.duration();
+    }
+    /* a bounce running behind the playback holds the song instead of skipping */
+    m_bouncePosition += bouncer.mix(output, m_bouncePosition, frames);
+    const int location = getPlaybackLocation();
+    dispatchFileEvents(location);
+    checkLoop(location);
 }
 
 bool
 SynthRenderer::isPlaybackCompleted()
 {
+    if (m_bouncing) {
+        const SongBouncer &bouncer = *m_current->bouncer;
+        const SongBouncer::State state = bouncer.state();
+        return state == SongBouncer::Failed || state == SongBouncer::Idle
+               || (state == SongBouncer::Finished
+                   && std::size_t(m_bouncePosition) >= bouncer.availableFrames());
+    }
     EAS_RESULT result;
     EAS_STATE state = EAS_STATE_EMPTY;
     if (m_fileHandle != 0 && (result = EAS_State(m_easData, m_fileHandle, &state)) != EAS_SUCCESS)
     {
-        qWarning() << "EAS_State:" << result;
+        m_engine.errors().report(RenderErrors::StateFailed, result);
     }
     /* is playback complete */
     bool b = ((state == EAS_STATE_STOPPED) || (state == EAS_STATE_ERROR) || (state == EAS_STATE_EMPTY));
@@ -590,16 +1187,31 @@ void
 SynthRenderer::closePlayback()
 {
     //qDebug() << Q_FUNC_INFO;
+    TraceScope traceScope("closePlayback");
     EAS_RESULT result = EAS_SUCCESS;
-    /* close the input file */
-    if (m_fileHandle != 0 && (result = EAS_CloseFile(m_easData, m_fileHandle)) != EAS_SUCCESS)
-    {
-        qWarning() << Q_FUNC_INFO << "EAS_CloseFile" << result;
+    if (m_isPlaying) {
+        m_flightRecorder.record(FlightRecorder::FileClosed, getPlaybackLocation());
+    }
+    /* close the input file; a deterministic one is only silenced, as the
+       next one swaps its instance out to be shut down on the main thread */
+    if (m_fileHandle != 0 && m_current != nullptr && m_current->swapped) {
+        EAS_Pause(m_easData, m_fileHandle);
+        m_staleHandle = m_fileHandle;
+    } else if (m_fileHandle != 0 && (result = EAS_CloseFile(m_easData, m_fileHandle)) != EAS_SUCCESS) {
+        m_engine.errors().report(RenderErrors::CloseFileFailed, result);
     }
     m_fileHandle = nullptr;
-    delete m_currentFile;
-    m_currentFile = nullptr;
+    m_nextFileEvent = 0;
+    m_filePaused = false;
+    /* the main thread cancels a bounce still running, joining its thread */
+    m_bouncing = false;
+    if (m_current != nullptr) {
+        m_returnedFiles.push(m_current);
+        m_current = nullptr;
+    }
     m_isPlaying = false;
+    m_snapshot.setPlaying(false);
+    m_snapshot.allNotesOff();
 }
 
 int
@@ -607,10 +1219,13 @@ SynthRenderer::getPlaybackLocation()
 {
     EAS_I32 playTime = 0;
     EAS_RESULT result = EAS_SUCCESS;
+    if (m_bouncing) {
+        return int(m_bouncePosition * 1000 / m_sampleRate);
+    }
     /* get the current time */
     if ((result = EAS_GetLocation(m_easData, m_fileHandle, &playTime)) != EAS_SUCCESS)
     {
-        qWarning() << Q_FUNC_INFO << "EAS_GetLocation" << result;
+        m_engine.errors().report(RenderErrors::LocationFailed, result);
     }
     //qDebug() << Q_FUNC_INFO << playTime;
     return playTime;
@@ -622,8 +1237,8 @@ SynthRenderer::startPlayback(const QString fileName)
     //qDebug() << Q_FUNC_INFO;
     if (!stopped())
     {
+        stopPlayback();
         playFile(fileName);
-        preparePlayback();
     }
 }
 
@@ -631,7 +1246,701 @@ void
 SynthRenderer::stopPlayback()
 {
     //qDebug() << Q_FUNC_INFO;
-    if (!stopped()) {
-        closePlayback();
+    /* the render path closes the file of an older generation by itself */
+    m_files.clear();
+    m_pendingSeek = -1;
+    m_generation.fetch_add(1, std::memory_order_release);
+    if (stopped()) {
+        PreparedFile *file;
+        while (m_readyFiles.pop(file)) {
+            m_returnedFiles.push(file);
+        }
+    }
+    serviceFiles();
+}
+
+void
+SynthRenderer::seek(int milliseconds)
+{
+    //qDebug() << Q_FUNC_INFO << milliseconds;
+    m_capture.record(CaptureRecord::Seek, m_deliveredFrames, milliseconds);
+    m_flightRecorder.record(FlightRecorder::Parameter, FlightRecorder::Seek, milliseconds);
+    m_pendingSeek = qMax(0, milliseconds);
+}
+
+void
+SynthRenderer::setLoopPoints(int startTime, int endTime)
+{
+    //qDebug() << Q_FUNC_INFO << startTime << endTime;
+    if (startTime >= 0 && endTime > startTime) {
+        m_loopPoints.store(packLoopPoints(startTime, endTime), std::memory_order_release);
+    } else {
+        clearLoop();
+    }
+}
+
+void
+SynthRenderer::clearLoop()
+{
+    m_loopPoints.store(packLoopPoints(-1, -1), std::memory_order_release);
+}
+
+void
+SynthRenderer::setPlaybackRate(qreal factor)
+{
+    //qDebug() << Q_FUNC_INFO << factor;
+    m_capture.record(CaptureRecord::PlaybackRate, m_deliveredFrames, qRound(factor * 1000));
+    m_flightRecorder.record(FlightRecorder::Parameter, FlightRecorder::PlaybackRate, qRound(factor * 1000));
+    qreal rate = qBound(qreal(MIN_PLAYBACK_RATE),
+                        factor * NORMAL_PLAYBACK_RATE,
+                        qreal(MAX_PLAYBACK_RATE));
+    m_playbackRate = (EAS_U32) rate;
+}
+
+int
+SynthRenderer::playbackDuration() const
+{
+    return m_duration;
+}
+
+bool
+SynthRenderer::openPlayer(int player, const QString &fileName)
+{
+    //qDebug() << Q_FUNC_INFO << player << fileName;
+    if (player < 0 || player >= MAX_PLAYERS) {
+        return false;
+    }
+    FilePlayer &p = m_players[player];
+    if (p.state.load(std::memory_order_acquire) != PlayerClosed) {
+        qWarning() << Q_FUNC_INFO << "player" << player << "is busy";
+        return false;
+    }
+    /* the warm stream takes the last EAS stream while the prewarm is enabled */
+    if (m_prewarm && player >= MAX_PLAYERS - 1) {
+        qWarning() << Q_FUNC_INFO << "player" << player << "is taken by the prewarm";
+        return false;
+    }
+    /* the streams given back are closed first, to leave one for this file */
+    servicePlayers();
+    p.appliedVolume = -1;
+    p.paused = false;
+    p.appliedPaused = false;
+    p.pendingSeek = -1;
+    p.location = 0;
+    p.duration = 0;
+    p.cancelled = false;
+    p.state.store(PlayerPreparing, std::memory_order_release);
+    PlayerFile *file = new PlayerFile;
+    file->player = player;
+    file->fileName = fileName;
+    p.preparing = file;
+    m_filePool.start(QRunnable::create([this, file] {
+        preparePlayer(file);
+        QMetaObject::invokeMethod(this, [this, file] { playerPrepared(file); }, Qt::QueuedConnection);
+    }));
+    return true;
+}
+
+/* preparation thread: the file is checked, and its stream opened in the
+   shared instance, so the render path only plays it */
+void
+SynthRenderer::preparePlayer(PlayerFile *file)
+{
+    TraceScope traceScope("preparePlayer");
+    const MidiFileInfo info = MetadataCache::instance()->scanFile(file->fileName);
+    if (!info.isValid()) {
+        return;
+    }
+    file->duration = info.duration;
+    /* read once, so EAS finds it in the page cache while it holds the instance */
+    QFile contents(file->fileName);
+    if (!contents.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    contents.readAll();
+    contents.close();
+    file->file.reset(new FileWrapper(file->fileName));
+    if (!file->file->ok()) {
+        return;
+    }
+    if (!m_engine.borrowInstance(BORROW_TIMEOUT)) {
+        qWarning() << Q_FUNC_INFO << "the engine is busy";
+        return;
+    }
+    EAS_DATA_HANDLE easData = m_engine.easData();
+    EAS_HANDLE handle = nullptr;
+    EAS_RESULT result = EAS_SUCCESS;
+    const char *failed = nullptr;
+    if (easData == nullptr) {
+        failed = "no engine";
+    } else if ((result = EAS_OpenFile(easData, file->file->getLocator(), &handle)) != EAS_SUCCESS) {
+        failed = "EAS_OpenFile";
+        handle = nullptr;
+    } else if ((result = EAS_Prepare(easData, handle)) != EAS_SUCCESS) {
+        failed = "EAS_Prepare";
+        EAS_CloseFile(easData, handle);
+        handle = nullptr;
+    }
+    file->serial = m_engine.instanceSerial();
+    m_engine.returnInstance();
+    file->handle = handle;
+    if (failed != nullptr) {
+        qWarning() << Q_FUNC_INFO << failed << "error:" << result;
+    }
+}
+
+void
+SynthRenderer::playerPrepared(PlayerFile *file)
+{
+    FilePlayer &p = m_players[file->player];
+    p.preparing = nullptr;
+    if (p.cancelled) {
+        p.state.store(PlayerClosed, std::memory_order_release);
+        m_filePool.start(QRunnable::create([this, file] { releasePlayerFile(file); }));
+    } else if (file->handle == nullptr) {
+        qWarning() << Q_FUNC_INFO << "cannot play" << file->fileName;
+        delete file;
+        p.state.store(PlayerStopped, std::memory_order_release);
+    } else {
+        p.duration = file->duration;
+        p.state.store(PlayerOpening, std::memory_order_release);
+        /* two files per layer at most: one playing, one given back */
+        m_readyPlayers.push(file);
+        ++m_playerFiles;
+        serviceFiles();
+    }
+}
+
+/* main thread: the layer files the render path is done with */
+void
+SynthRenderer::servicePlayers()
+{
+    PlayerFile *file;
+    while (m_returnedPlayers.pop(file)) {
+        --m_playerFiles;
+        m_filePool.start(QRunnable::create([this, file] { releasePlayerFile(file); }));
+    }
+}
+
+/* preparation thread, or the main thread while not rendering */
+void
+SynthRenderer::releasePlayerFile(PlayerFile *file)
+{
+    if (file->handle != nullptr) {
+        if (m_engine.borrowInstance(BORROW_TIMEOUT)) {
+            EAS_RESULT result = EAS_SUCCESS;
+            /* a replaced instance closed its streams when it was shut down */
+            if (file->serial == m_engine.instanceSerial()) {
+                result = EAS_CloseFile(m_engine.easData(), file->handle);
+            }
+            m_engine.returnInstance();
+            if (result != EAS_SUCCESS) {
+                qWarning() << Q_FUNC_INFO << "EAS_CloseFile error:" << result;
+            }
+        } else {
+            qWarning() << Q_FUNC_INFO << "the engine is busy, the stream of" << file->fileName
+                       << "stays open";
+        }
+    }
+    delete file;
+}
+
+void
+SynthRenderer::closePlayer(int player)
+{
+    //qDebug() << Q_FUNC_INFO << player;
+    if (player < 0 || player >= MAX_PLAYERS) {
+        return;
+    }
+    FilePlayer &p = m_players[player];
+    int state = p.state.load(std::memory_order_acquire);
+    /* the preparation thread still owns the file */
+    if (state == PlayerPreparing) {
+        p.cancelled = true;
+        return;
+    }
+    while (state != PlayerClosed && state != PlayerClosing
+           && !p.state.compare_exchange_weak(state, PlayerClosing, std::memory_order_acq_rel)) {
+    }
+    /* without callbacks, the render path is run here */
+    if (stopped() && p.state.load(std::memory_order_acquire) == PlayerClosing
+        && m_engine.borrowInstance(0)) {
+        updatePlayers();
+        m_engine.returnInstance();
+        servicePlayers();
+    }
+}
+
+void
+SynthRenderer::setPlayerVolume(int player, int volume)
+{
+    if (player >= 0 && player < MAX_PLAYERS) {
+        m_players[player].volume = qBound(0, volume, MAX_PLAYER_VOLUME);
+    }
+}
+
+void
+SynthRenderer::setPlayerPaused(int player, bool paused)
+{
+    if (player >= 0 && player < MAX_PLAYERS) {
+        m_players[player].paused = paused;
+    }
+}
+
+void
+SynthRenderer::seekPlayer(int player, int milliseconds)
+{
+    if (player >= 0 && player < MAX_PLAYERS) {
+        m_players[player].pendingSeek = qMax(0, milliseconds);
+    }
+}
+
+int
+SynthRenderer::playerState(int player) const
+{
+    if (player < 0 || player >= MAX_PLAYERS) {
+        return PlayerClosed;
+    }
+    return m_players[player].state.load(std::memory_order_acquire);
+}
+
+int
+SynthRenderer::playerLocation(int player) const
+{
+    if (player < 0 || player >= MAX_PLAYERS) {
+        return 0;
+    }
+    return m_players[player].location;
+}
+
+int
+SynthRenderer::playerDuration(int player) const
+{
+    if (player < 0 || player >= MAX_PLAYERS) {
+        return 0;
+    }
+    return m_players[player].duration;
+}
+
+void
+SynthRenderer::locate(int milliseconds)
+{
+    EAS_RESULT result;
+    if (m_bouncing) {
+        /* instant, even beyond what is rendered yet */
+        m_bouncePosition = qint64(milliseconds) * m_sampleRate / 1000;
+    } else {
+        if (m_fileHandle == 0) {
+            return;
+        }
+        /* EAS_Locate resets the parser and parses from the start of the file
+           in both directions, so a forward seek costs as much as a backward
+           one; the current time only makes the forward offset relative */
+        int current = getPlaybackLocation();
+        if (milliseconds >= current) {
+            result = EAS_Locate(m_easData, m_fileHandle, milliseconds - current, EAS_TRUE);
+        } else {
+            result = EAS_Locate(m_easData, m_fileHandle, milliseconds, EAS_FALSE);
+        }
+        if (result != EAS_SUCCESS) {
+            m_engine.errors().report(RenderErrors::LocateFailed, result);
+        }
+    }
+    if (m_current == nullptr) {
+        return;
+    }
+    const auto &events = m_current->events;
+    auto it = std::lower_bound(events.cbegin(),
+                               events.cend(),
+                               milliseconds,
+                               [](const auto &ev, int time) { return ev.first < time; });
+    m_nextFileEvent = it - events.cbegin();
+}
+
+void
+SynthRenderer::applyPendingSeek()
+{
+    int target = m_pendingSeek.exchange(-1);
+    if (target >= 0) {
+        locate(target);
+    }
+}
+
+void
+SynthRenderer::applyPlaybackRate()
+{
+    EAS_U32 rate = m_playbackRate;
+    if (m_fileHandle != 0 && rate != m_appliedRate) {
+        EAS_RESULT result = EAS_SetPlaybackRate(m_easData, m_fileHandle, rate);
+        if (result != EAS_SUCCESS) {
+            /* not every file type supports it; do not retry on every callback */
+            m_engine.errors().report(RenderErrors::PlaybackRateFailed, result);
+        }
+        m_appliedRate = rate;
+    }
+}
+
+/* the layered players, on the render path; returns whether any of them is sounding */
+bool
+SynthRenderer::updatePlayers()
+{
+    bool active = false;
+    EAS_RESULT result;
+    PlayerFile *file;
+    while (m_readyPlayers.pop(file)) {
+        FilePlayer &player = m_players[file->player];
+        player.file = file;
+        /* opened in an instance replaced meanwhile, which took the stream along */
+        int next = PlayerPlaying;
+        if (file->serial != m_engine.instanceSerial()) {
+            file->handle = nullptr;
+            next = PlayerStopped;
+        }
+        /* a close requested meanwhile wins */
+        int state = PlayerOpening;
+        player.state.compare_exchange_strong(state, next, std::memory_order_acq_rel);
+    }
+    for (auto &player : m_players) {
+        int state = player.state.load(std::memory_order_acquire);
+        if (state == PlayerClosing) {
+            /* muted here and closed on the preparation thread, which cannot
+               borrow the instance before this callback ends */
+            if (player.file != nullptr) {
+                EAS_HANDLE handle = player.file->handle;
+                if (!m_returnedPlayers.push(player.file)) {
+                    continue;
+                }
+                player.file = nullptr;
+                /* a stopped stream has nothing to mute */
+                if (handle != nullptr) {
+                    EAS_Pause(m_easData, handle);
+                }
+            }
+            player.state.store(PlayerClosed, std::memory_order_release);
+            continue;
+        }
+        if (state != PlayerPlaying || player.file == nullptr || player.file->handle == nullptr) {
+            continue;
+        }
+        EAS_HANDLE handle = player.file->handle;
+        const int volume = player.volume;
+        if (volume != player.appliedVolume) {
+            if ((result = EAS_SetVolume(m_easData, handle, volume)) != EAS_SUCCESS) {
+                m_engine.errors().report(RenderErrors::SetVolumeFailed, result);
+            }
+            player.appliedVolume = volume;
+        }
+        const bool paused = player.paused;
+        if (paused != player.appliedPaused) {
+            result = paused ? EAS_Pause(m_easData, handle) : EAS_Resume(m_easData, handle);
+            if (result != EAS_SUCCESS) {
+                m_engine.errors().report(RenderErrors::PauseFailed, result);
+            }
+            player.appliedPaused = paused;
+        }
+        EAS_I32 location = 0;
+        if ((result = EAS_GetLocation(m_easData, handle, &location)) != EAS_SUCCESS) {
+            m_engine.errors().report(RenderErrors::LocationFailed, result);
+        }
+        const int target = player.pendingSeek.exchange(-1);
+        if (target >= 0) {
+            /* relative forward, as in locate(); EAS parses from the start either way */
+            result = target >= location ? EAS_Locate(m_easData, handle, target - location, EAS_TRUE)
+                                        : EAS_Locate(m_easData, handle, target, EAS_FALSE);
+            if (result != EAS_SUCCESS) {
+                m_engine.errors().report(RenderErrors::LocateFailed, result);
+            }
+            location = target;
+        }
+        player.location = location;
+        EAS_STATE easState = EAS_STATE_EMPTY;
+        if ((result = EAS_State(m_easData, handle, &easState)) != EAS_SUCCESS) {
+            m_engine.errors().report(RenderErrors::StateFailed, result);
+        }
+        if (easState == EAS_STATE_STOPPED || easState == EAS_STATE_ERROR
+            || easState == EAS_STATE_EMPTY) {
+            /* the stream stays open until the owner closes it */
+            player.state.compare_exchange_strong(state, PlayerStopped, std::memory_order_acq_rel);
+        } else if (!paused) {
+            active = true;
+        }
+    }
+    return active;
+}
+
+/* render path: the engine swapped out takes the layer streams along, and
+   shuts them down on the main thread */
+void
+SynthRenderer::detachPlayers()
+{
+    for (auto &player : m_players) {
+        if (player.file != nullptr && player.file->handle != nullptr) {
+            player.file->handle = nullptr;
+            int state = PlayerPlaying;
+            player.state.compare_exchange_strong(state, PlayerStopped, std::memory_order_acq_rel);
+        }
+    }
+}
+
+/* main thread, not rendering: the streams belong to the engine instance, so
+   they cannot survive its shutdown */
+void
+SynthRenderer::closePlayers()
+{
+    m_filePool.waitForDone();
+    /* the render path takes the files handed over, and gives back the closed ones */
+    if (m_engine.borrowInstance(0)) {
+        updatePlayers();
+        m_engine.returnInstance();
+    }
+    PlayerFile *file;
+    while (m_returnedPlayers.pop(file)) {
+        --m_playerFiles;
+        releasePlayerFile(file);
+    }
+    for (auto &player : m_players) {
+        if (player.file != nullptr && player.file->handle != nullptr) {
+            EAS_CloseFile(m_easData, player.file->handle);
+            player.file->handle = nullptr;
+            int state = PlayerPlaying;
+            player.state.compare_exchange_strong(state, PlayerStopped, std::memory_order_acq_rel);
+        }
+    }
+}
+
+void
+SynthRenderer::checkLoop(int location)
+{
+    const std::uint64_t loopPoints = m_loopPoints.load(std::memory_order_acquire);
+    int loopStart = std::int32_t(std::uint32_t(loopPoints >> 32));
+    int loopEnd = std::int32_t(std::uint32_t(loopPoints));
+    if (loopStart >= 0 && loopEnd > loopStart && m_pendingSeek < 0) {
+        if (location >= loopEnd) {
+            locate(loopStart);
+        }
+    }
+}
+
+qint64
+SynthRenderer::renderedFrames() const
+{
+    return m_engine.renderedFrames();
+}
+
+qint64
+SynthRenderer::deliveredFrames() const
+{
+    return m_deliveredFrames;
+}
+
+bool
+SynthRenderer::takeMetaEvent(qint64 untilFrame, MetaEvent &ev)
+{
+    const MetaEvent *next = m_metaEvents.front();
+    if (next == nullptr || next->frame > untilFrame) {
+        return false;
+    }
+    return m_metaEvents.pop(ev);
+}
+
+void
+SynthRenderer::queueMetaEvent(int type, const char *text, int value)
+{
+    MetaEvent ev;
+    /* the clock the controller subtracts the output latency from; the
+       engine count runs ahead of it by the unfinished EAS block */
+    ev.frame = m_deliveredFrames;
+    ev.type = type;
+    ev.value = value;
+    qstrncpy(ev.text, text, sizeof(ev.text));
+    if (!m_metaEvents.push(ev)) {
+        m_engine.errors().report(RenderErrors::MetaQueueFull, type);
+    }
+}
+
+void
+SynthRenderer::blockRendered(void *user, const EAS_PCM *samples, EAS_I32 frames)
+{
+    Q_UNUSED(samples);
+    Q_UNUSED(frames);
+    auto renderer = static_cast<SynthRenderer *>(user);
+    if (renderer->m_filePaused && !renderer->m_engine.isPrewarming()) {
+        renderer->m_filePaused = false;
+        EAS_Resume(renderer->m_easData, renderer->m_fileHandle);
+    }
+    if (renderer->m_isPlaying && !renderer->m_bouncing) {
+        int location = renderer->getPlaybackLocation();
+        renderer->dispatchFileEvents(location);
+        renderer->checkLoop(location);
+    }
+}
+
+void
+SynthRenderer::metaDataCallback(E_EAS_METADATA_TYPE type, char *buffer, EAS_VOID_PTR user)
+{
+    auto renderer = static_cast<SynthRenderer *>(user);
+    int eventType = MetaEvent::Unknown;
+    switch (type) {
+    case EAS_METADATA_TITLE:
+        eventType = MetaEvent::Title;
+        break;
+    case EAS_METADATA_AUTHOR:
+        eventType = MetaEvent::Author;
+        break;
+    case EAS_METADATA_COPYRIGHT:
+        eventType = MetaEvent::Copyright;
+        break;
+    case EAS_METADATA_LYRIC:
+        eventType = MetaEvent::Lyric;
+        break;
+    case EAS_METADATA_TEXT:
+        eventType = MetaEvent::Text;
+        break;
+    default:
+        break;
+    }
+    renderer->queueMetaEvent(eventType, buffer);
+}
+
+/* first use of every instrument, and of every octave of it, in the file */
+static std::vector<MidiMessage> prewarmMessages(const SmfScanner &smf)
+{
+    struct WarmNote {
+        std::uint32_t tick;
+        quint8 channel, bankMsb, bankLsb, program, key, velocity;
+    };
+    QHash<quint32, WarmNote> firstUse;
+    quint8 bankMsb[16] = {0}, bankLsb[16] = {0}, program[16] = {0};
+    smf.forEachEvent([&](const SmfEvent &ev) {
+        const int chan = ev.status & 0x0f;
+        switch (ev.status & 0xf0) {
+        case 0xb0:
+            if (ev.data1 == 0) {
+                bankMsb[chan] = ev.data2;
+            } else if (ev.data1 == 32) {
+                bankLsb[chan] = ev.data2;
+            }
+            break;
+        case 0xc0:
+            program[chan] = ev.data1;
+            break;
+        case 0x90:
+            if (ev.data2 > 0) {
+                const bool drums = chan == DRUM_CHANNEL;
+                const quint32 id = (quint32(drums) << 31) | (bankMsb[chan] << 22) | (bankLsb[chan] << 15)
+                                   | (program[chan] << 8) | (drums ? ev.data1 : ev.data1 / 12);
+                auto it = firstUse.find(id);
+                if (it == firstUse.end() || ev.tick < it->tick) {
+                    firstUse.insert(id, WarmNote{ev.tick, quint8(chan), bankMsb[chan], bankLsb[chan],
+                                                 program[chan], ev.data1, ev.data2});
+                }
+            }
+            break;
+        }
+        return true;
+    });
+
+    std::vector<WarmNote> notes(firstUse.cbegin(), firstUse.cend());
+    std::sort(notes.begin(), notes.end(), [](const WarmNote &a, const WarmNote &b) {
+        return a.tick < b.tick;
+    });
+
+    /* each melodic instrument gets a channel of its own; drums keep theirs */
+    std::vector<MidiMessage> messages;
+    quint32 channelInstrument[16] = {0};
+    bool channelUsed[16] = {false};
+    int count = 0;
+    for (const auto &note : notes) {
+        if (count >= PREWARM_MAX_NOTES) {
+            break;
+        }
+        const bool drums = note.channel == DRUM_CHANNEL;
+        const quint32 instrument = (note.bankMsb << 16) | (note.bankLsb << 8) | note.program;
+        int chan = -1;
+        for (int c = 0; c < 16 && chan < 0; ++c) {
+            if (channelUsed[c] && channelInstrument[c] == instrument && (c == DRUM_CHANNEL) == drums) {
+                chan = c;
+            }
+        }
+        if (chan < 0) {
+            for (int c = 0; c < 16 && chan < 0; ++c) {
+                if (!channelUsed[c] && (c == DRUM_CHANNEL) == drums) {
+                    chan = c;
+                }
+            }
+            if (chan < 0) {
+                continue;
+            }
+            channelUsed[chan] = true;
+            channelInstrument[chan] = instrument;
+            messages.push_back(MidiMessage{3, {quint8(0xb0 | chan), 0, note.bankMsb}});
+            messages.push_back(MidiMessage{3, {quint8(0xb0 | chan), 32, note.bankLsb}});
+            messages.push_back(MidiMessage{2, {quint8(0xc0 | chan), note.program}});
+        }
+        messages.push_back(MidiMessage{3, {quint8(0x90 | chan), note.key, note.velocity}});
+        ++count;
+    }
+    return messages;
+}
+
+/* EAS does not report markers nor tempo changes, so they are scheduled from the file */
+void
+SynthRenderer::loadFileEvents(PreparedFile *prepared)
+{
+    QFile file(prepared->fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const QByteArray data = file.readAll();
+    SmfScanner smf;
+    if (!smf.open(reinterpret_cast<const std::uint8_t *>(data.constData()), data.size())) {
+        return;
+    }
+    /* no live parser reports the lyrics of a bounce, so they come from the file too */
+    const bool withText = prepared->bouncer != nullptr;
+    auto &events = prepared->events;
+    prepared->prewarmMessages = prewarmMessages(smf);
+    const auto tempoMap = smf.tempoMap();
+    smf.forEachEvent([&](const SmfEvent &ev) {
+        const bool text = withText
+                          && (ev.metaType == SmfScanner::META_LYRIC
+                              || ev.metaType == SmfScanner::META_TEXT);
+        if (ev.status == 0xff
+            && (text || ev.metaType == SmfScanner::META_MARKER
+                || ev.metaType == SmfScanner::META_TEMPO)) {
+            MetaEvent meta{};
+            if (text || ev.metaType == SmfScanner::META_MARKER) {
+                meta.type = ev.metaType == SmfScanner::META_LYRIC  ? MetaEvent::Lyric
+                            : ev.metaType == SmfScanner::META_TEXT ? MetaEvent::Text
+                                                                   : MetaEvent::Marker;
+                int len = qMin<int>(ev.length, MetaEvent::MAX_TEXT - 1);
+                memcpy(meta.text, ev.payload, len);
+                meta.text[len] = 0;
+            } else if (ev.length == 3) {
+                meta.type = MetaEvent::Tempo;
+                meta.value = (ev.payload[0] << 16) | (ev.payload[1] << 8) | ev.payload[2];
+            } else {
+                return true;
+            }
+            events.emplace_back(qRound(smf.millis(ev.tick, tempoMap)), meta);
+        }
+        return true;
+    });
+    std::stable_sort(events.begin(), events.end(), [](const auto &a, const auto &b) {
+        return a.first < b.first;
+    });
+}
+
+void
+SynthRenderer::dispatchFileEvents(int location)
+{
+    if (m_current == nullptr) {
+        return;
+    }
+    const auto &events = m_current->events;
+    while (m_nextFileEvent < events.size() && events[m_nextFileEvent].first <= location) {
+        const MetaEvent &ev = events[m_nextFileEvent].second;
+        queueMetaEvent(ev.type, ev.text, ev.value);
+        ++m_nextFileEvent;
     }
 }
@@ -22,6 +22,12 @@
 #include <QObject>
 #include <QIODevice>
 #include <QAudioFormat>
+#include <QThreadPool>
+#include <QTimer>
+#include <atomic>
+#include <memory>
+#include <utility>
+#include <vector>
 
 #include <drumstick/backendmanager.h>
 #include <drumstick/rtmidiinput.h>
@@ -29,12 +35,25 @@
 #include "mp_svoxeas_visibility.h"
 #include "eas.h"
 #include "filewrapper.h"
+#include "flightrecorder.h"
+#include "lockfreering.h"
+#include "metaevents.h"
+#include "midicapture.h"
+#include "midiparser.h"
+#include "renderstats.h"
+#include "songbouncer.h"
+#include "synthengine.h"
+#include "synthsnapshot.h"
+
+class RawMidiInput;
 
 class MP_SVOXEAS_PUBLIC SynthRenderer : public QIODevice
 {
     Q_OBJECT
 
 public:
+    static const QString BUILTIN_MIDI_DRIVER;
+
     explicit SynthRenderer(QObject *parent = 0);
     virtual ~SynthRenderer();
 
@@ -57,19 +76,95 @@ public:
     /* Sonivox EAS*/
     void initReverb(int reverb_type);
     void initChorus(int chorus_type);
-    void initSoundLib(int sound_lib);
     void setReverbWet(int amount);
     void setChorusLevel(int amount);
+    /* these replace the EAS instance, so only while stopped(); the playlist
+       and the layers are stopped */
+    void initSoundLib(int sound_lib);
     void initSoundfont(const QString soundfont);
+    int soundLib() const;
+    QString soundfont() const;
+    /* queues a file, to be played after the others */
     void playFile(const QString fileName);
+    /* drops the playlist and the file being played, then plays this one */
     void startPlayback(const QString fileName);
     void stopPlayback();
+    void seek(int milliseconds);
+    void setLoopPoints(int startTime, int endTime);
+    void clearLoop();
+    void setPlaybackRate(qreal factor);
+    int playbackDuration() const;
+
+    /* extra files playing at the same time as the main one, through the same
+       engine, mix and effects. Their streams are opened and closed on the
+       preparation thread, with the instance borrowed, and played on the
+       render path. They get the EAS streams left by the live MIDI input and
+       the main file, but the last one while the prewarm holds it */
+    static const int MAX_PLAYERS = EngineProfile::MAX_STREAMS - 2;
+    static_assert(MAX_PLAYERS > 0, "no EAS stream left for the layers");
+    static const int MAX_PLAYER_VOLUME = 100;
+    enum PlayerState {
+        PlayerClosed,
+        PlayerPreparing,
+        PlayerOpening,
+        PlayerPlaying,
+        PlayerStopped,
+        PlayerClosing
+    };
+    /* false for a busy or unknown player; otherwise the file is checked in
+       the background, and the player goes on to PlayerOpening, or to
+       PlayerStopped if it cannot be played */
+    bool openPlayer(int player, const QString &fileName);
+    void closePlayer(int player);
+    /* 0 to MAX_PLAYER_VOLUME, as EAS_SetVolume */
+    void setPlayerVolume(int player, int volume);
+    void setPlayerPaused(int player, bool paused);
+    void seekPlayer(int player, int milliseconds);
+    int playerState(int player) const;
+    int playerLocation(int player) const;
+    int playerDuration(int player) const;
 
     /* Qt Multimedia */
     const QAudioFormat &format() const;
     qint64 lastBufferSize() const;
     void resetLastBufferSize();
-    void reserveBuffer(qsizetype size);
+
+    /* User interface polling */
+    const SynthSnapshot &snapshot() const;
+    /* main thread, periodically: emits the snapshot changes as signals */
+    void emitSnapshotSignals();
+    qint64 renderedFrames() const;
+    qint64 deliveredFrames() const;
+    bool takeMetaEvent(qint64 untilFrame, MetaEvent &ev);
+
+    /* Power saving and statistics */
+    void setIdleDetection(bool enabled);
+    bool idleDetection() const;
+    bool isIdle() const;
+    void warmUp(int blocks);
+    /* load the instruments of a file, muted, before it starts playing; off by default */
+    void setPrewarm(bool enabled);
+    bool prewarm() const;
+    /* play files from a whole-song render made ahead on a background thread */
+    void setBounce(bool enabled);
+    bool bounce() const;
+    /* reuse whole-song renders stored on disk by RenderCache */
+    void setRenderCache(bool enabled);
+    bool renderCache() const;
+    void requestStackPrefault(std::size_t bytes);
+    const RenderStats &stats() const;
+    RenderErrors &errors();
+    /* bit-exact file playback, each file starting from a fresh engine */
+    void setDeterministic(bool enabled);
+    bool deterministic() const;
+    RenderChecksum &checksum();
+    /* log the live MIDI input, parameter calls and audio callbacks, to be
+       replayed by mp_replaysynth; the owner flushes capture() periodically */
+    bool startCapture(const QString &fileName);
+    void stopCapture();
+    MidiCapture &capture();
+    /* recent history of the callbacks, files and parameters, always on */
+    FlightRecorder &flightRecorder();
 
     void uninitEAS();
 
@@ -81,18 +176,49 @@ public slots:
     void program(const int chan, const int program);
     void channelPressure(const int chan, const int value);
     void pitchBend(const int chan, const int value);
+    void midiMessage(const MidiMessage &msg);
 
 private:
-    void initMIDI();
+    void initMIDI() const;
+    void ensureMIDIInput();
     void initEAS();
-    void writeMIDIData(QByteArray &ev);
+    void reinitEAS();
+    void queueMIDIData(const EAS_U8 *data, int length);
 
-    void preparePlayback();
+    struct PreparedFile;
+    void serviceFiles(bool finished = false);
+    void prepareNextFile();
+    void filePrepared();
+    static void prepareFile(PreparedFile *file);
+    static void prepareBounce(PreparedFile *file);
+    static void prepareInstance(PreparedFile *file);
+    static void loadFileEvents(PreparedFile *file);
+    void startNextFile();
+    bool openCurrentFile();
     bool isPlaybackCompleted();
     void closePlayback();
     int getPlaybackLocation();
+    void locate(int milliseconds);
+    void applyPlaybackRate();
+    void applyPendingSeek();
+    void checkLoop(int location);
+    void startBounce();
+    void playBounce(std::int16_t *output, qint64 frames);
+    void dispatchFileEvents(int location);
+    struct PlayerFile;
+    void preparePlayer(PlayerFile *file);
+    void playerPrepared(PlayerFile *file);
+    void servicePlayers();
+    void releasePlayerFile(PlayerFile *file);
+    bool updatePlayers();
+    void detachPlayers();
+    void closePlayers();
+    void queueMetaEvent(int type, const char *text, int value = 0);
+    static void metaDataCallback(E_EAS_METADATA_TYPE type, char *buffer, EAS_VOID_PTR user);
+    static void blockRendered(void *user, const EAS_PCM *samples, EAS_I32 frames);
 
 signals:
+    /* coalesced from the snapshot by emitSnapshotSignals(), merging the channels */
     void midiNoteOn(const int note, const int vel);
     void midiNoteOff(const int note, const int vel);
     void playbackStopped();
@@ -104,23 +230,104 @@ private:
     /* Drumstick RT*/
     QString m_midiDriver;
     QString m_portName;
-    drumstick::rt::BackendManager m_man;
+    mutable drumstick::rt::BackendManager *m_man;
     drumstick::rt::MIDIInput *m_input;
+    RawMidiInput *m_rawInput;
 
     /* SONiVOX EAS */
-    int m_sampleRate, m_renderFrames, m_channels, m_sample_size;
+    SynthEngine m_engine;
+    int m_sampleRate, m_channels, m_sample_size;
     EAS_DATA_HANDLE m_easData;
-    EAS_HANDLE m_streamHandle;
     EAS_HANDLE m_fileHandle;
-    FileWrapper *m_currentFile;
-    QStringList m_files;
+    /* the stream of the last deterministic file, left paused in its
+       instance until the next swap takes both away */
+    EAS_HANDLE m_staleHandle;
     QString m_soundfont;
     E_EAS_SNDLIB_TYPE m_soundLib;
+    int m_reverbType, m_reverbWet, m_chorusType, m_chorusLevel;
+
+    /* Playlist, on the main thread. The next file is opened and scanned
+       ahead on m_filePool, handed over to the render path ready to play,
+       and given back through m_returnedFiles when it is done with */
+    static const std::size_t READY_FILES = 2;
+    static const std::size_t RETURNED_FILES = 4;
+    QStringList m_files;
+    PreparedFile *m_preparing;
+    QThreadPool m_filePool;
+    QTimer m_fileTimer;
+    int m_handedFiles;
+    int m_reclaimedFiles;
+    std::atomic<unsigned> m_generation;
+    SpscRing<PreparedFile *, READY_FILES> m_readyFiles;
+    SpscRing<PreparedFile *, RETURNED_FILES> m_returnedFiles;
+    PreparedFile *m_current;
+
+    /* File playback transport, applied on the render path */
+    std::atomic<int> m_pendingSeek;
+    /* start and end together, so the render path never sees half of a change */
+    std::atomic<std::uint64_t> m_loopPoints;
+    std::atomic<EAS_U32> m_playbackRate;
+    EAS_U32 m_appliedRate;
+    std::atomic<int> m_duration;
+
+    /* Layered file players; the state tells each one's stage to both
+       threads. The opened files go to the render path through
+       m_readyPlayers, and come back through m_returnedPlayers to have their
+       streams closed on the preparation thread */
+    static const std::size_t PLAYER_FILES = 32;
+    static_assert(std::size_t(2 * MAX_PLAYERS) <= PLAYER_FILES, "too many layers for the player rings");
+    struct FilePlayer {
+        std::atomic<int> state{PlayerClosed};
+        /* main thread: the file being opened, and whether it was closed meanwhile */
+        PlayerFile *preparing{nullptr};
+        bool cancelled{false};
+        /* render path */
+        PlayerFile *file{nullptr};
+        std::atomic<int> volume{MAX_PLAYER_VOLUME};
+        int appliedVolume{MAX_PLAYER_VOLUME};
+        std::atomic<bool> paused{false};
+        bool appliedPaused{false};
+        std::atomic<int> pendingSeek{-1};
+        std::atomic<int> location{0};
+        std::atomic<int> duration{0};
+    };
+    FilePlayer m_players[MAX_PLAYERS];
+    SpscRing<PlayerFile *, PLAYER_FILES> m_readyPlayers;
+    SpscRing<PlayerFile *, PLAYER_FILES> m_returnedPlayers;
+    /* main thread: pushed to m_readyPlayers and not taken back yet */
+    int m_playerFiles;
 
     // Qt Multimedia
     QAudioFormat m_format;
-    qint64 m_lastBufferSize;
-    QByteArray m_audioBuffer;
+    std::atomic<qint64> m_lastBufferSize;
+
+    // UI polling
+    SynthSnapshot m_snapshot;
+    /* main thread: what emitSnapshotSignals() reported last */
+    SynthSnapshot::State m_signalState{};
+    std::uint32_t m_signalSerial{0};
+    int m_signalTime{-1};
+
+    // Metadata events, stamped with the first frame of the buffer they are heard in
+    std::atomic<qint64> m_deliveredFrames;
+    MetaEventQueue m_metaEvents;
+    char m_metaDataBuffer[MetaEvent::MAX_TEXT];
+    std::size_t m_nextFileEvent;
+
+    // Instrument pre-warm of the next file
+    std::atomic<bool> m_prewarm;
+    bool m_filePaused;
+
+    // Render-ahead playback; the bounce of the last file is kept for replays
+    std::unique_ptr<SongBouncer> m_lastBounce;
+    std::atomic<bool> m_bounce;
+    std::atomic<bool> m_renderCache;
+    bool m_bouncing;
+    qint64 m_bouncePosition;
+
+    // Incident capture
+    MidiCapture m_capture;
+    FlightRecorder m_flightRecorder;
 };
 
 #endif /*SYNTHRENDERER_H_*/
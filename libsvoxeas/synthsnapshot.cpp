@@ -0,0 +1,138 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "synthsnapshot.h"
+
+static bool isValid(int chan, int note)
+{
+    return chan >= 0 && chan < SynthSnapshot::NUM_CHANNELS && note >= 0 && note < SynthSnapshot::NUM_KEYS;
+}
+
+bool SynthSnapshot::State::isNoteOn(int chan, int note) const
+{
+    if (!isValid(chan, note)) {
+        return false;
+    }
+    return (keys[chan][note / 64] >> (note % 64)) & 1;
+}
+
+bool SynthSnapshot::State::isNoteOn(int note) const
+{
+    return noteVelocity(note) > 0;
+}
+
+int SynthSnapshot::State::noteVelocity(int note) const
+{
+    for (int chan = 0; chan < NUM_CHANNELS; ++chan) {
+        if (isNoteOn(chan, note)) {
+            /* a note on with velocity 0 is a note off, so this is never 0 */
+            return velocity[chan][note];
+        }
+    }
+    return 0;
+}
+
+SynthSnapshot::SynthSnapshot()
+    : m_playbackTime{0}
+    , m_playing{false}
+    , m_serial{0}
+{
+    for (auto &chan : m_keys) {
+        for (auto &k : chan) {
+            k.store(0, std::memory_order_relaxed);
+        }
+    }
+    for (auto &chan : m_velocity) {
+        for (auto &v : chan) {
+            v.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void SynthSnapshot::noteOn(int chan, int note, int vel)
+{
+    if (!isValid(chan, note)) {
+        return;
+    }
+    if ((vel & 0x7f) == 0) {
+        noteOff(chan, note);
+        return;
+    }
+    m_velocity[chan][note].store(vel & 0x7f, std::memory_order_relaxed);
+    m_keys[chan][note / 64].fetch_or(std::uint64_t(1) << (note % 64), std::memory_order_release);
+    m_serial.fetch_add(1, std::memory_order_release);
+}
+
+void SynthSnapshot::noteOff(int chan, int note)
+{
+    if (!isValid(chan, note)) {
+        return;
+    }
+    m_keys[chan][note / 64].fetch_and(~(std::uint64_t(1) << (note % 64)), std::memory_order_release);
+    m_serial.fetch_add(1, std::memory_order_release);
+}
+
+void SynthSnapshot::allNotesOff(int chan)
+{
+    if (chan < 0 || chan >= NUM_CHANNELS) {
+        return;
+    }
+    for (auto &k : m_keys[chan]) {
+        k.store(0, std::memory_order_release);
+    }
+    m_serial.fetch_add(1, std::memory_order_release);
+}
+
+void SynthSnapshot::allNotesOff()
+{
+    for (auto &chan : m_keys) {
+        for (auto &k : chan) {
+            k.store(0, std::memory_order_release);
+        }
+    }
+    m_serial.fetch_add(1, std::memory_order_release);
+}
+
+void SynthSnapshot::setPlaybackTime(int time)
+{
+    m_playbackTime.store(time, std::memory_order_relaxed);
+}
+
+void SynthSnapshot::setPlaying(bool playing)
+{
+    m_playing.store(playing, std::memory_order_relaxed);
+}
+
+void SynthSnapshot::read(State &state) const
+{
+    for (int chan = 0; chan < NUM_CHANNELS; ++chan) {
+        for (int i = 0; i < KEY_WORDS; ++i) {
+            state.keys[chan][i] = m_keys[chan][i].load(std::memory_order_acquire);
+        }
+        for (int i = 0; i < NUM_KEYS; ++i) {
+            state.velocity[chan][i] = m_velocity[chan][i].load(std::memory_order_relaxed);
+        }
+    }
+    state.playbackTime = m_playbackTime.load(std::memory_order_relaxed);
+    state.playing = m_playing.load(std::memory_order_relaxed);
+}
+
+std::uint32_t SynthSnapshot::serial() const
+{
+    return m_serial.load(std::memory_order_acquire);
+}
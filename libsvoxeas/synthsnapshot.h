@@ -0,0 +1,74 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SYNTHSNAPSHOT_H
+#define SYNTHSNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "mp_svoxeas_core_visibility.h"
+
+/**
+ * Lock-free view of the synthesizer state for user interfaces.
+ *
+ * The renderer updates it from the MIDI and audio paths without emitting
+ * signals; consumers poll it at their own refresh rate using read().
+ */
+class MP_SVOXEAS_CORE_PUBLIC SynthSnapshot
+{
+public:
+    static const int NUM_CHANNELS = 16;
+    static const int NUM_KEYS = 128;
+    static const int KEY_WORDS = NUM_KEYS / 64;
+
+    struct State {
+        /* keyed per channel: a note off only releases its own channel */
+        std::uint64_t keys[NUM_CHANNELS][KEY_WORDS];
+        std::uint8_t velocity[NUM_CHANNELS][NUM_KEYS];
+        int playbackTime;
+        bool playing;
+
+        bool isNoteOn(int chan, int note) const;
+        /* on any channel */
+        bool isNoteOn(int note) const;
+        /* of the lowest channel holding the note, 0 if none */
+        int noteVelocity(int note) const;
+    };
+
+    SynthSnapshot();
+
+    void noteOn(int chan, int note, int vel);
+    void noteOff(int chan, int note);
+    void allNotesOff(int chan);
+    void allNotesOff();
+    void setPlaybackTime(int time);
+    void setPlaying(bool playing);
+
+    void read(State &state) const;
+    std::uint32_t serial() const;
+
+private:
+    std::atomic<std::uint64_t> m_keys[NUM_CHANNELS][KEY_WORDS];
+    std::atomic<std::uint8_t> m_velocity[NUM_CHANNELS][NUM_KEYS];
+    std::atomic<int> m_playbackTime;
+    std::atomic<bool> m_playing;
+    std::atomic<std::uint32_t> m_serial;
+};
+
+#endif // SYNTHSNAPSHOT_H
@@ -0,0 +1,234 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#include "lockfreering.h"
+#include "tracer.h"
+
+#if defined(__GNUC__)
+/* initial-exec TLS never allocates on first use */
+#define TRACER_TLS __attribute__((tls_model("initial-exec"))) thread_local
+#else
+#define TRACER_TLS thread_local
+#endif
+
+namespace {
+
+struct TraceEvent {
+    const char *name;
+    std::int64_t start;
+    std::int64_t end;
+};
+
+/* about 20 callbacks with their EAS blocks per flush period, and room to spare */
+const std::size_t THREAD_BUFFER_SIZE = 2048;
+
+/* a slot goes Free -> Claimed -> Used, Retired when its thread exits,
+   and back to Free once the writer has drained it */
+enum SlotState { Free, Claimed, Used, Retired };
+
+struct ThreadBuffer {
+    std::atomic<int> state{Free};
+    int tid = 0; // written while Claimed
+    std::atomic<const char *> name{nullptr};
+    SpscRing<TraceEvent, THREAD_BUFFER_SIZE> events;
+};
+
+ThreadBuffer buffers[Tracer::MAX_THREADS];
+std::atomic<int> nextTid{1};
+std::atomic<bool> enabled{false};
+std::atomic<std::uint64_t> droppedEvents{0};
+std::atomic<std::uint64_t> untraced{0};
+std::int64_t origin = 0;
+
+/* guards the file against concurrent flush() and close() */
+std::mutex fileMutex;
+std::FILE *traceFile = nullptr;
+bool firstEvent = true;
+
+TRACER_TLS int t_buffer = -1;
+TRACER_TLS bool t_untraced = false;
+
+/* gives the slot back when its thread exits */
+struct SlotGuard {
+    ~SlotGuard()
+    {
+        if (t_buffer >= 0) {
+            buffers[t_buffer].state.store(Retired, std::memory_order_release);
+            t_buffer = -1;
+        }
+    }
+};
+
+ThreadBuffer *threadBuffer()
+{
+    if (t_buffer < 0) {
+        for (int i = 0; i < Tracer::MAX_THREADS; ++i) {
+            int expected = Free;
+            if (buffers[i].state.compare_exchange_strong(expected, Claimed,
+                                                         std::memory_order_acquire)) {
+                buffers[i].tid = nextTid.fetch_add(1, std::memory_order_relaxed);
+                buffers[i].name.store(nullptr, std::memory_order_relaxed);
+                buffers[i].state.store(Used, std::memory_order_release);
+                t_buffer = i;
+                /* registering the exit hook may allocate, once per thread */
+                static thread_local SlotGuard guard;
+                (void) guard;
+                return &buffers[i];
+            }
+        }
+        if (!t_untraced) {
+            t_untraced = true;
+            untraced.fetch_add(1, std::memory_order_relaxed);
+        }
+        return nullptr;
+    }
+    return &buffers[t_buffer];
+}
+
+void writeEvent(int tid, const TraceEvent &event)
+{
+    std::fprintf(traceFile,
+                 "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                 firstEvent ? "" : ",",
+                 event.name, tid,
+                 (event.start - origin) / 1e3,
+                 (event.end - event.start) / 1e3);
+    firstEvent = false;
+}
+
+void writeThreadName(int tid, const char *name)
+{
+    std::fprintf(traceFile,
+                 "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                 firstEvent ? "" : ",", tid, name != nullptr ? name : "thread");
+    firstEvent = false;
+}
+
+/* the slots of exited threads are freed once drained */
+void drainBuffers()
+{
+    for (auto &buffer : buffers) {
+        const int state = buffer.state.load(std::memory_order_acquire);
+        if (state != Used && state != Retired) {
+            continue;
+        }
+        TraceEvent event;
+        while (buffer.events.pop(event)) {
+            if (traceFile != nullptr) {
+                writeEvent(buffer.tid, event);
+            }
+        }
+        if (state == Retired) {
+            if (traceFile != nullptr) {
+                writeThreadName(buffer.tid, buffer.name.load(std::memory_order_acquire));
+            }
+            buffer.state.store(Free, std::memory_order_release);
+        }
+    }
+}
+
+} // namespace
+
+bool Tracer::open(const char *path)
+{
+    std::lock_guard<std::mutex> locker(fileMutex);
+    if (traceFile != nullptr) {
+        return false;
+    }
+    traceFile = std::fopen(path, "w");
+    if (traceFile == nullptr) {
+        return false;
+    }
+    drainBuffers();
+    std::fputs("[", traceFile);
+    firstEvent = true;
+    droppedEvents = 0;
+    origin = now();
+    enabled.store(true, std::memory_order_release);
+    TracePoints::setSink(&Tracer::complete);
+    return true;
+}
+
+void Tracer::close()
+{
+    TracePoints::setSink(nullptr);
+    enabled.store(false, std::memory_order_release);
+    std::lock_guard<std::mutex> locker(fileMutex);
+    if (traceFile == nullptr) {
+        return;
+    }
+    drainBuffers();
+    for (const auto &buffer : buffers) {
+        if (buffer.state.load(std::memory_order_acquire) == Used) {
+            writeThreadName(buffer.tid, buffer.name.load(std::memory_order_acquire));
+        }
+    }
+    std::fputs("\n]\n", traceFile);
+    std::fclose(traceFile);
+    traceFile = nullptr;
+}
+
+bool Tracer::isEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::flush()
+{
+    std::lock_guard<std::mutex> locker(fileMutex);
+    drainBuffers();
+    if (traceFile != nullptr) {
+        std::fflush(traceFile);
+    }
+}
+
+std::uint64_t Tracer::dropped()
+{
+    return droppedEvents.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Tracer::untracedThreads()
+{
+    return untraced.load(std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const char *name)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    if (buffer != nullptr) {
+        buffer->name.store(name, std::memory_order_release);
+    }
+}
+
+std::int64_t Tracer::now()
+{
+    return TracePoints::now();
+}
+
+void Tracer::complete(const char *name, std::int64_t start, std::int64_t end)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    if (buffer == nullptr || !buffer->events.push(TraceEvent{name, start, end})) {
+        droppedEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+}
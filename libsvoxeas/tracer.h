@@ -0,0 +1,60 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <cstdint>
+
+#include "mp_svoxeas_tools_visibility.h"
+#include "tracescope.h"
+
+/**
+ * Timeline tracing of the audio pipeline, exported in the Chrome trace
+ * event format (chrome://tracing, ui.perfetto.dev). Each thread records
+ * complete events into its own lock-free buffer, taken from a static pool
+ * so that tracing never allocates on the audio thread; flush() moves them
+ * to the file from a non real-time thread. A buffer is given back when its
+ * thread exits. While open, it is the sink of the TraceScope trace points.
+ *
+ * Event and thread names must be string literals, or live as long as the
+ * trace.
+ */
+class MP_SVOXEAS_TOOLS_PUBLIC Tracer
+{
+public:
+    /* threads tracing at the same time */
+    static const int MAX_THREADS = 16;
+
+    /* starts recording into a new trace file */
+    static bool open(const char *path);
+    /* writes the pending events and terminates the file */
+    static void close();
+    static bool isEnabled();
+    /* writer thread, periodically: events beyond a buffer capacity are dropped */
+    static void flush();
+    static std::uint64_t dropped();
+    /* threads that found every buffer taken; their events are dropped */
+    static std::uint64_t untracedThreads();
+
+    static void setThreadName(const char *name);
+    static std::int64_t now();
+    static void complete(const char *name, std::int64_t start, std::int64_t end);
+};
+
+#endif // TRACER_H
@@ -0,0 +1,54 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <atomic>
+#include <chrono>
+
+#include "tracescope.h"
+
+namespace {
+
+std::atomic<TracePoints::Sink> sink{nullptr};
+
+} // namespace
+
+void TracePoints::setSink(Sink newSink)
+{
+    sink.store(newSink, std::memory_order_release);
+}
+
+bool TracePoints::isEnabled()
+{
+    return sink.load(std::memory_order_relaxed) != nullptr;
+}
+
+std::int64_t TracePoints::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/* a scope still open when tracing stops is dropped */
+void TracePoints::complete(const char *name, std::int64_t start, std::int64_t end)
+{
+    Sink current = sink.load(std::memory_order_acquire);
+    if (current != nullptr) {
+        current(name, start, end);
+    }
+}
@@ -0,0 +1,65 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACESCOPE_H
+#define TRACESCOPE_H
+
+#include <cstdint>
+
+#include "mp_svoxeas_core_visibility.h"
+
+/**
+ * Trace points of the engine. Until a tracer (Tracer, in mp_svoxeas_tools)
+ * installs its sink, a TraceScope only loads one atomic pointer, and the
+ * core library does not depend on the tracer.
+ */
+class MP_SVOXEAS_CORE_PUBLIC TracePoints
+{
+public:
+    typedef void (*Sink)(const char *name, std::int64_t start, std::int64_t end);
+
+    /* nullptr stops tracing; the sink must be callable from any thread */
+    static void setSink(Sink sink);
+    static bool isEnabled();
+    /* steady clock, in nanoseconds */
+    static std::int64_t now();
+    static void complete(const char *name, std::int64_t start, std::int64_t end);
+};
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : m_name(name)
+        , m_start(TracePoints::isEnabled() ? TracePoints::now() : -1)
+    {}
+    ~TraceScope()
+    {
+        if (m_start >= 0) {
+            TracePoints::complete(m_name, m_start, TracePoints::now());
+        }
+    }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *m_name;
+    std::int64_t m_start;
+};
+
+#endif // TRACESCOPE_H
@@ -0,0 +1,155 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "wavwriter.h"
+
+/* samples converted per fwrite() call */
+static const std::size_t WRITE_CHUNK = 4096;
+static const std::uint32_t HEADER_SIZE = 44;
+
+static void putU16(unsigned char *p, std::uint32_t value)
+{
+    p[0] = static_cast<unsigned char>(value);
+    p[1] = static_cast<unsigned char>(value >> 8);
+}
+
+static void putU32(unsigned char *p, std::uint32_t value)
+{
+    putU16(p, value);
+    putU16(p + 2, value >> 16);
+}
+
+WavWriter::WavWriter()
+    : m_file(nullptr)
+    , m_sampleRate(0)
+    , m_channels(0)
+    , m_frames(0)
+    , m_ok(false)
+{}
+
+WavWriter::~WavWriter()
+{
+    close();
+}
+
+bool WavWriter::open(const char *path, int sampleRate, int channels)
+{
+    close();
+    if (sampleRate <= 0 || channels <= 0) {
+        return false;
+    }
+    m_file = std::fopen(path, "wb");
+    if (m_file == nullptr) {
+        return false;
+    }
+    m_sampleRate = sampleRate;
+    m_channels = channels;
+    m_frames = 0;
+    m_ok = true;
+    writeHeader();
+    return m_ok;
+}
+
+/* with the sizes known so far; RIFF sizes are limited to 32 bits */
+void WavWriter::writeHeader()
+{
+    const std::uint64_t bytes = m_frames * m_channels * sizeof(std::int16_t);
+    const std::uint32_t dataSize = std::uint32_t(std::min<std::uint64_t>(bytes, 0xffffffffu - HEADER_SIZE));
+    unsigned char header[HEADER_SIZE] = {'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E',
+                                         'f', 'm', 't', ' ', 0, 0, 0, 0, 0, 0, 0, 0,
+                                         0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                         'd', 'a', 't', 'a', 0, 0, 0, 0};
+    putU32(header + 4, dataSize + HEADER_SIZE - 8);
+    putU32(header + 16, 16);
+    putU16(header + 20, 1); // PCM
+    putU16(header + 22, m_channels);
+    putU32(header + 24, m_sampleRate);
+    putU32(header + 28, m_sampleRate * m_channels * sizeof(std::int16_t));
+    putU16(header + 32, m_channels * sizeof(std::int16_t));
+    putU16(header + 34, 16);
+    putU32(header + 40, dataSize);
+    if (std::fwrite(header, 1, sizeof(header), m_file) != sizeof(header)) {
+        m_ok = false;
+    }
+}
+
+bool WavWriter::write(const std::int16_t *samples, std::size_t frames)
+{
+    if (m_file == nullptr) {
+        return false;
+    }
+    /* little endian whatever the host is */
+    unsigned char bytes[WRITE_CHUNK * sizeof(std::int16_t)];
+    const std::size_t count = frames * m_channels;
+    for (std::size_t done = 0; done < count;) {
+        const std::size_t n = std::min(WRITE_CHUNK, count - done);
+        for (std::size_t i = 0; i < n; ++i) {
+            putU16(bytes + i * 2, std::uint16_t(samples[done + i]));
+        }
+        if (std::fwrite(bytes, sizeof(std::int16_t), n, m_file) != n) {
+            m_ok = false;
+            return false;
+        }
+        done += n;
+    }
+    m_frames += frames;
+    return true;
+}
+
+bool WavWriter::writeSilence(std::size_t frames)
+{
+    static const std::int16_t silence[WRITE_CHUNK] = {0};
+    const std::size_t chunkFrames = WRITE_CHUNK / std::max(m_channels, 1);
+    while (frames > 0) {
+        const std::size_t n = std::min(frames, chunkFrames);
+        if (!write(silence, n)) {
+            return false;
+        }
+        frames -= n;
+    }
+    return true;
+}
+
+bool WavWriter::close()
+{
+    if (m_file == nullptr) {
+        return false;
+    }
+    if (std::fseek(m_file, 0, SEEK_SET) == 0) {
+        writeHeader();
+    } else {
+        m_ok = false;
+    }
+    if (std::fclose(m_file) != 0) {
+        m_ok = false;
+    }
+    m_file = nullptr;
+    return m_ok;
+}
+
+bool WavWriter::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+std::uint64_t WavWriter::frames() const
+{
+    return m_frames;
+}
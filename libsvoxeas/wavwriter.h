@@ -0,0 +1,56 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WAVWRITER_H
+#define WAVWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "mp_svoxeas_tools_visibility.h"
+
+/**
+ * Writer of 16-bit PCM WAVE files. The chunk sizes in the header are
+ * fixed up by close(), so the file is only complete after it.
+ */
+class MP_SVOXEAS_TOOLS_PUBLIC WavWriter
+{
+public:
+    WavWriter();
+    ~WavWriter();
+
+    bool open(const char *path, int sampleRate, int channels);
+    bool write(const std::int16_t *samples, std::size_t frames);
+    bool writeSilence(std::size_t frames);
+    /* returns false if anything failed since open() */
+    bool close();
+    bool isOpen() const;
+    std::uint64_t frames() const;
+
+private:
+    void writeHeader();
+
+    std::FILE *m_file;
+    int m_sampleRate;
+    int m_channels;
+    std::uint64_t m_frames;
+    bool m_ok;
+};
+
+#endif // WAVWRITER_H
@@ -0,0 +1,238 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "midicapture.h"
+#include "programsettings.h"
+#include "synthcontroller.h"
+#include "synthrenderer.h"
+
+/* time left for the release and reverb tails after the last record */
+static const int TAIL_MILLIS = 2000;
+
+/* the same calls, in the same order, the live synthesizer received */
+template<typename Synth>
+static void applyRecord(Synth &synth, const CaptureRecord &record)
+{
+    switch (record.type) {
+    case CaptureRecord::Midi: {
+        MidiMessage msg;
+        msg.length = record.length;
+        memcpy(msg.data, record.data, record.length);
+        synth.midiMessage(msg);
+        break;
+    }
+    case CaptureRecord::Reverb:
+        synth.initReverb(record.value);
+        break;
+    case CaptureRecord::ReverbWet:
+        synth.setReverbWet(record.value);
+        break;
+    case CaptureRecord::Chorus:
+        synth.initChorus(record.value);
+        break;
+    case CaptureRecord::ChorusLevel:
+        synth.setChorusLevel(record.value);
+        break;
+    case CaptureRecord::PlaybackRate:
+        synth.setPlaybackRate(record.value / 1000.0);
+        break;
+    case CaptureRecord::Seek:
+        synth.seek(record.value);
+        break;
+    default:
+        break;
+    }
+}
+
+static void printRenderStats(const RenderStats::Values &stats)
+{
+    fprintf(stderr,
+            "Rendered blocks: %llu (%.3f ms, average %.3f us, peak %.3f us)\n"
+            "Idle blocks: %llu\n"
+            "Pre-warm blocks: %llu\n",
+            (unsigned long long) stats.renderedBlocks, stats.renderNanos / 1e6,
+            stats.renderedBlocks > 0 ? stats.renderNanos / 1e3 / stats.renderedBlocks : 0.0,
+            stats.peakRenderNanos / 1e3,
+            (unsigned long long) stats.idleBlocks,
+            (unsigned long long) stats.prewarmBlocks);
+}
+
+/* the audio callbacks of the log drive a renderer with no audio device, as
+   fast as possible; the MIDI and parameter calls are applied between them */
+static int replayOffline(MidiCaptureReader &reader)
+{
+    SynthRenderer renderer;
+    renderer.initSoundLib(ProgramSettings::instance()->soundLib());
+    renderer.initSoundfont(ProgramSettings::instance()->Soundfont());
+    if (renderer.format().sampleRate() != int(reader.header().sampleRate)) {
+        fprintf(stderr, "Warning: captured at %u Hz, replaying at %d Hz\n",
+                reader.header().sampleRate, renderer.format().sampleRate());
+    }
+    renderer.start();
+    QByteArray buffer;
+    std::vector<qint64> callbackNanos;
+    qint64 frames = 0;
+    QElapsedTimer wallClock;
+    QElapsedTimer callbackClock;
+    wallClock.start();
+    CaptureRecord record;
+    while (reader.next(record)) {
+        if (record.type != CaptureRecord::Render) {
+            applyRecord(renderer, record);
+            continue;
+        }
+        const qint64 bytes = renderer.format().bytesForFrames(record.value);
+        buffer.resize(bytes);
+        callbackClock.start();
+        renderer.read(buffer.data(), bytes);
+        callbackNanos.push_back(callbackClock.nsecsElapsed());
+        frames += record.value;
+    }
+    const qint64 elapsed = wallClock.nsecsElapsed();
+    renderer.stop();
+
+    RenderStats::Values stats;
+    renderer.stats().read(stats);
+    printRenderStats(stats);
+    if (!callbackNanos.empty()) {
+        std::sort(callbackNanos.begin(), callbackNanos.end());
+        const auto percentile = [&](double p) {
+            return callbackNanos[std::size_t(p * (callbackNanos.size() - 1))] / 1e3;
+        };
+        fprintf(stderr,
+                "Callbacks: %zu (median %.3f us, 99%% %.3f us, max %.3f us)\n",
+                callbackNanos.size(), percentile(0.5), percentile(0.99), callbackNanos.back() / 1e3);
+    }
+    const double audioSeconds = double(frames) / renderer.format().sampleRate();
+    fprintf(stderr, "Replayed %.3f s of audio in %.3f s (%.1fx real time)\n",
+            audioSeconds, elapsed / 1e9, elapsed > 0 ? audioSeconds * 1e9 / elapsed : 0.0);
+    return EXIT_SUCCESS;
+}
+
+/* the records are applied at their captured times, and the audio device
+   requests the audio, as it did when the log was captured */
+static int replayRealTime(QCoreApplication &app, MidiCaptureReader &reader)
+{
+    SynthController synth(ProgramSettings::instance()->bufferTime());
+    synth.initSoundLib(ProgramSettings::instance()->soundLib());
+    synth.initSoundfont(ProgramSettings::instance()->Soundfont());
+    synth.setAudioDeviceName(ProgramSettings::instance()->audioDeviceName());
+    int underruns = 0;
+    QObject::connect(&synth, &SynthController::underrunDetected, &app, [&underruns] { ++underruns; });
+    synth.start();
+
+    CaptureRecord record;
+    bool pending = reader.next(record);
+    QElapsedTimer clock;
+    QTimer timer;
+    timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&timer, &QTimer::timeout, &app, [&] {
+        const qint64 now = clock.nsecsElapsed();
+        while (pending && record.nanos <= now) {
+            applyRecord(synth, record);
+            pending = reader.next(record);
+        }
+        if (!pending) {
+            timer.stop();
+            QTimer::singleShot(TAIL_MILLIS, &app, &QCoreApplication::quit);
+        }
+    });
+    clock.start();
+    timer.start(1);
+    app.exec();
+
+    RenderStats::Values stats;
+    if (synth.readRenderStats(stats)) {
+        printRenderStats(stats);
+    }
+    fprintf(stderr, "Underruns: %d\n", underruns);
+    synth.stop();
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("SonivoxEAS");
+    QCoreApplication::setApplicationName("mp_replaysynth");
+    QCoreApplication::setApplicationVersion(QT_STRINGIFY(VERSION));
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a MIDI capture of mp_cmdlnsynth --capture");
+    parser.addVersionOption();
+    parser.addHelpOption();
+    QCommandLineOption offlineOption({"o", "offline"}, "Render without an audio device, as fast as possible.");
+    QCommandLineOption bufferOption({"b", "buffer"},"Audio buffer time in milliseconds.", "buffer_time", "100");
+    QCommandLineOption dlsOption({"d", "dls"}, "DLS Soundfont.", "file.dls");
+    QCommandLineOption deviceOption({"a", "audiodevice"}, "Audio Device Name (alsa:<pcm> for direct ALSA output)", "device_name", "default");
+    QCommandLineOption sndLibOption({"s", "soundlib"}, "Sound Library (1=WT, 2=FM)", "sound_lib", "1");
+    parser.addOption(offlineOption);
+    parser.addOption(bufferOption);
+    parser.addOption(dlsOption);
+    parser.addOption(deviceOption);
+    parser.addOption(sndLibOption);
+    parser.addPositionalArgument("capture", "MIDI capture file", "file.svcp");
+    parser.process(app);
+    ProgramSettings::instance()->ReadFromNativeStorage();
+    if (parser.isSet(bufferOption)) {
+        int n = parser.value(bufferOption).toInt();
+        if (n > 0)
+            ProgramSettings::instance()->setBufferTime(n);
+        else {
+            fputs("Wrong buffer time.\n", stderr);
+            parser.showHelp(1);
+        }
+    }
+    if (parser.isSet(dlsOption)) {
+        ProgramSettings::instance()->setSoundfont(parser.value(dlsOption));
+    }
+    if (parser.isSet(deviceOption)) {
+        ProgramSettings::instance()->setAudioDeviceName(parser.value(deviceOption));
+    }
+    if (parser.isSet(sndLibOption)) {
+        int s = parser.value(sndLibOption).toInt();
+        if (s >= 1 && s <= 2) {
+            ProgramSettings::instance()->setSoundLib(s);
+        } else {
+            fputs("Wrong sound library type.\n", stderr);
+            parser.showHelp(1);
+        }
+    }
+    const QStringList args = parser.positionalArguments();
+    if (args.length() != 1) {
+        parser.showHelp(1);
+    }
+    MidiCaptureReader reader;
+    if (!reader.open(QFile::encodeName(args.first()).constData())) {
+        fprintf(stderr, "Cannot read the capture %s\n", qPrintable(args.first()));
+        return EXIT_FAILURE;
+    }
+    if (parser.isSet(offlineOption)) {
+        return replayOffline(reader);
+    }
+    return replayRealTime(app, reader);
+}
@@ -0,0 +1,364 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+
+#include "synthcontroller.h"
+#include "synthrenderer.h"
+
+enum StormKind {
+    NoteStorm,
+    ControllerStorm,
+    PitchBendStorm
+};
+
+/* cycles through the kinds of storm, one message per call, over the 16 channels */
+class StormGenerator
+{
+public:
+    explicit StormGenerator(const std::vector<StormKind> &kinds)
+        : m_kinds(kinds)
+    {
+        std::fill(std::begin(m_held), std::end(m_held), -1);
+    }
+
+    template<typename Synth>
+    void send(Synth &synth)
+    {
+        static const int CONTROLS[] = {1, 10, 11, 74, 91, 93};
+        const StormKind kind = m_kinds[m_count % m_kinds.size()];
+        const int chan = int(m_count / m_kinds.size() % 16);
+        switch (kind) {
+        case NoteStorm:
+            /* each note is released by the next note event of its channel */
+            if (m_held[chan] >= 0) {
+                synth.noteOff(chan, m_held[chan], 0);
+                m_held[chan] = -1;
+            } else {
+                m_held[chan] = 36 + int(m_count % 60);
+                synth.noteOn(chan, m_held[chan], 100);
+            }
+            break;
+        case ControllerStorm:
+            synth.controller(chan, CONTROLS[m_count % 6], int(m_count % 128));
+            break;
+        case PitchBendStorm:
+            synth.pitchBend(chan, int(m_count * 97 % 16384) - 8192);
+            break;
+        }
+        ++m_count;
+    }
+
+    template<typename Synth>
+    void release(Synth &synth)
+    {
+        for (int chan = 0; chan < 16; ++chan) {
+            if (m_held[chan] >= 0) {
+                synth.noteOff(chan, m_held[chan], 0);
+                m_held[chan] = -1;
+            }
+        }
+    }
+
+private:
+    std::vector<StormKind> m_kinds;
+    quint64 m_count{0};
+    int m_held[16];
+};
+
+struct StressConfig {
+    QString name;
+    int soundLib;
+    QString soundfont;
+};
+
+struct StepResult {
+    double rate;
+    quint64 events;
+    quint64 callbacks;
+    double meanMicros;
+    double p99Micros;
+    double maxMicros;
+    quint64 dropped;
+    quint64 glitches;
+    const char *knee;
+};
+
+static void printHeader(const QString &title)
+{
+    fprintf(stdout, "# %s\n", qPrintable(title));
+    fprintf(stdout, "%10s %10s %10s %10s %10s %10s %8s %8s\n",
+            "events/s", "events", "callbacks", "mean us", "p99 us", "max us", "dropped", "glitches");
+}
+
+static void printStep(const StepResult &r)
+{
+    fprintf(stdout, "%10.0f %10llu %10llu %10.1f %10.1f %10.1f %8llu %8llu%s%s\n",
+            r.rate, (unsigned long long) r.events, (unsigned long long) r.callbacks,
+            r.meanMicros, r.p99Micros, r.maxMicros,
+            (unsigned long long) r.dropped, (unsigned long long) r.glitches,
+            r.knee ? "  <- " : "", r.knee ? r.knee : "");
+    fflush(stdout);
+}
+
+/* the renderer is read directly, as fast as possible, one period at a time;
+   the storm of each period is queued just before the callback that takes it */
+static StepResult runNullStep(SynthRenderer &renderer, StormGenerator &storm,
+                              double rate, int seconds, int period)
+{
+    const int sampleRate = renderer.format().sampleRate();
+    const qint64 bytes = renderer.format().bytesForFrames(period);
+    const qint64 blocks = qint64(seconds) * sampleRate / period;
+    const double perCallback = rate * period / sampleRate;
+    const double deadlineMicros = period * 1e6 / sampleRate;
+    QByteArray buffer(bytes, 0);
+    std::vector<qint64> callbackNanos;
+    callbackNanos.reserve(blocks);
+    RenderErrors::Counters before;
+    RenderErrors::Counters after;
+    renderer.errors().read(before);
+
+    StepResult result{rate, 0, 0, 0.0, 0.0, 0.0, 0, 0, nullptr};
+    QElapsedTimer clock;
+    double due = 0.0;
+    for (qint64 i = 0; i < blocks; ++i) {
+        for (due += perCallback; due >= 1.0; due -= 1.0) {
+            storm.send(renderer);
+            ++result.events;
+        }
+        clock.start();
+        renderer.read(buffer.data(), bytes);
+        callbackNanos.push_back(clock.nsecsElapsed());
+    }
+    storm.release(renderer);
+    renderer.errors().read(after);
+
+    qint64 total = 0;
+    for (qint64 nanos : callbackNanos) {
+        total += nanos;
+    }
+    std::sort(callbackNanos.begin(), callbackNanos.end());
+    result.callbacks = callbackNanos.size();
+    if (result.callbacks > 0) {
+        result.meanMicros = total / 1e3 / result.callbacks;
+        result.p99Micros = callbackNanos[std::size_t(0.99 * (result.callbacks - 1))] / 1e3;
+        result.maxMicros = callbackNanos.back() / 1e3;
+    }
+    result.dropped = after.count[RenderErrors::MidiQueueFull] - before.count[RenderErrors::MidiQueueFull];
+    if (result.dropped > 0) {
+        result.knee = "events dropped";
+    } else if (result.p99Micros > deadlineMicros) {
+        result.knee = "over the deadline";
+    }
+    return result;
+}
+
+/* the audio device requests the audio at its own pace while a timer sends
+   the storm; the callback times come from the render statistics */
+static StepResult runAudioStep(SynthController &synth, StormGenerator &storm, double rate, int seconds)
+{
+    RenderStats::Values before{};
+    RenderStats::Values after{};
+    RenderErrors::Counters errorsBefore{};
+    RenderErrors::Counters errorsAfter{};
+    synth.readRenderStats(before);
+    synth.readRenderErrors(errorsBefore);
+    const quint64 glitches = synth.underruns() + synth.stalls();
+
+    StepResult result{rate, 0, 0, 0.0, 0.0, 0.0, 0, 0, nullptr};
+    QEventLoop loop;
+    QTimer timer;
+    QElapsedTimer clock;
+    timer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&timer, &QTimer::timeout, &loop, [&] {
+        const quint64 due = quint64(rate * clock.nsecsElapsed() / 1e9);
+        while (result.events < due) {
+            storm.send(synth);
+            ++result.events;
+        }
+        if (clock.elapsed() >= seconds * 1000) {
+            loop.quit();
+        }
+    });
+    clock.start();
+    timer.start(1);
+    loop.exec();
+    storm.release(synth);
+
+    synth.readRenderStats(after);
+    synth.readRenderErrors(errorsAfter);
+    result.callbacks = after.callbacks - before.callbacks;
+    if (result.callbacks > 0) {
+        result.meanMicros = (after.callbackNanos - before.callbackNanos) / 1e3 / result.callbacks;
+        std::uint64_t buckets[RenderStats::CALLBACK_BUCKETS];
+        for (int i = 0; i < RenderStats::CALLBACK_BUCKETS; ++i) {
+            buckets[i] = after.callbackBuckets[i] - before.callbackBuckets[i];
+        }
+        result.p99Micros = RenderStats::callbackPercentile(buckets, 0.99);
+    }
+    result.dropped = errorsAfter.count[RenderErrors::MidiQueueFull]
+                     - errorsBefore.count[RenderErrors::MidiQueueFull];
+    result.glitches = synth.underruns() + synth.stalls() - glitches;
+    if (result.dropped > 0) {
+        result.knee = "events dropped";
+    } else if (result.glitches > 0) {
+        result.knee = "audio glitches";
+    }
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("SonivoxEAS");
+    QCoreApplication::setApplicationName("mp_stresssynth");
+    QCoreApplication::setApplicationVersion(QT_STRINGIFY(VERSION));
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Floods the synthesizer with MIDI at increasing rates, "
+                                     "to find the highest rate it can sustain");
+    parser.addVersionOption();
+    parser.addHelpOption();
+    QCommandLineOption stormOption("storm", "Comma separated kinds of events: notes, controllers, bend.", "kinds", "notes");
+    QCommandLineOption startOption("start", "First rate, in events per second.", "rate", "1000");
+    QCommandLineOption maxOption("max", "Last rate, in events per second.", "rate", "512000");
+    QCommandLineOption factorOption("factor", "Rate multiplier between steps.", "factor", "2");
+    QCommandLineOption secondsOption("seconds", "Duration of each step.", "seconds", "2");
+    QCommandLineOption periodOption({"p", "period"}, "Frames per callback without an audio device.", "frames", "128");
+    QCommandLineOption deviceOption({"a", "audiodevice"}, "Use this audio device instead of the null sink (alsa:<pcm> for direct ALSA output)", "device_name");
+    QCommandLineOption bufferOption({"b", "buffer"}, "Audio buffer time in milliseconds, with an audio device.", "buffer_time", "100");
+    QCommandLineOption sndLibOption({"s", "soundlib"}, "Sound Library (1=WT, 2=FM); may be repeated. Both by default.", "sound_lib");
+    QCommandLineOption dlsOption({"d", "dls"}, "DLS Soundfont, measured with the WT library; may be repeated.", "file.dls");
+    parser.addOption(stormOption);
+    parser.addOption(startOption);
+    parser.addOption(maxOption);
+    parser.addOption(factorOption);
+    parser.addOption(secondsOption);
+    parser.addOption(periodOption);
+    parser.addOption(deviceOption);
+    parser.addOption(bufferOption);
+    parser.addOption(sndLibOption);
+    parser.addOption(dlsOption);
+    parser.process(app);
+
+    std::vector<StormKind> kinds;
+    foreach(const QString &kind, parser.value(stormOption).split(',', Qt::SkipEmptyParts)) {
+        if (kind == QLatin1String("notes")) {
+            kinds.push_back(NoteStorm);
+        } else if (kind == QLatin1String("controllers")) {
+            kinds.push_back(ControllerStorm);
+        } else if (kind == QLatin1String("bend")) {
+            kinds.push_back(PitchBendStorm);
+        } else {
+            fprintf(stderr, "Wrong kind of storm: %s\n", qPrintable(kind));
+            parser.showHelp(1);
+        }
+    }
+    if (kinds.empty()) {
+        parser.showHelp(1);
+    }
+    const double startRate = parser.value(startOption).toDouble();
+    const double maxRate = parser.value(maxOption).toDouble();
+    const double factor = parser.value(factorOption).toDouble();
+    const int seconds = parser.value(secondsOption).toInt();
+    const int period = parser.value(periodOption).toInt();
+    const int bufferTime = parser.value(bufferOption).toInt();
+    if (startRate <= 0 || maxRate < startRate || factor <= 1.0 || seconds <= 0 || period <= 0 || bufferTime <= 0) {
+        fputs("Wrong rates, duration, period or buffer time.\n", stderr);
+        parser.showHelp(1);
+    }
+
+    QList<StressConfig> configs;
+    const QStringList soundLibs = parser.isSet(sndLibOption) ? parser.values(sndLibOption)
+                                                             : QStringList{"1", "2"};
+    foreach(const QString &lib, soundLibs) {
+        const int s = lib.toInt();
+        if (s < 1 || s > 2) {
+            fputs("Wrong sound library type.\n", stderr);
+            parser.showHelp(1);
+        }
+        configs.append(StressConfig{s == 1 ? QStringLiteral("WT") : QStringLiteral("FM"), s, QString()});
+    }
+    foreach(const QString &dls, parser.values(dlsOption)) {
+        configs.append(StressConfig{QStringLiteral("WT + ") + dls, 1, dls});
+    }
+
+    QStringList summary;
+    foreach(const StressConfig &config, configs) {
+        StormGenerator storm(kinds);
+        QList<StepResult> results;
+        if (parser.isSet(deviceOption)) {
+            SynthController synth(bufferTime);
+            synth.initSoundLib(config.soundLib);
+            synth.initSoundfont(config.soundfont);
+            synth.setAudioDeviceName(parser.value(deviceOption));
+            synth.start();
+            printHeader(QStringLiteral("%1, %2 ms buffer on %3")
+                            .arg(config.name).arg(bufferTime).arg(parser.value(deviceOption)));
+            for (double rate = startRate; rate <= maxRate; rate *= factor) {
+                results.append(runAudioStep(synth, storm, rate, seconds));
+                printStep(results.last());
+                if (results.last().knee) {
+                    break;
+                }
+            }
+            synth.stop();
+        } else {
+            SynthRenderer renderer;
+            renderer.initSoundLib(config.soundLib);
+            renderer.initSoundfont(config.soundfont);
+            renderer.warmUp(32);
+            renderer.start();
+            printHeader(QStringLiteral("%1, %2 frames per callback at %3 Hz, deadline %4 us")
+                            .arg(config.name).arg(period).arg(renderer.format().sampleRate())
+                            .arg(period * 1e6 / renderer.format().sampleRate(), 0, 'f', 0));
+            for (double rate = startRate; rate <= maxRate; rate *= factor) {
+                results.append(runNullStep(renderer, storm, rate, seconds, period));
+                printStep(results.last());
+                if (results.last().knee) {
+                    break;
+                }
+            }
+            renderer.stop();
+        }
+        if (results.isEmpty() || !results.last().knee) {
+            summary.append(QStringLiteral("%1: no knee up to %2 events/s")
+                               .arg(config.name).arg(results.isEmpty() ? 0.0 : results.last().rate, 0, 'f', 0));
+        } else if (results.size() == 1) {
+            summary.append(QStringLiteral("%1: %2 already at %3 events/s")
+                               .arg(config.name, QString::fromLatin1(results.last().knee)).arg(results.last().rate, 0, 'f', 0));
+        } else {
+            summary.append(QStringLiteral("%1: sustains %2 events/s, %3 at %4 events/s")
+                               .arg(config.name).arg(results.at(results.size() - 2).rate, 0, 'f', 0)
+                               .arg(QString::fromLatin1(results.last().knee)).arg(results.last().rate, 0, 'f', 0));
+        }
+        fputs("\n", stdout);
+    }
+    fputs("# Summary\n", stdout);
+    foreach(const QString &line, summary) {
+        fprintf(stdout, "%s\n", qPrintable(line));
+    }
+    return EXIT_SUCCESS;
+}
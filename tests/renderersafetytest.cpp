@@ -0,0 +1,183 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "rtsafety.h"
+#include "synthrenderer.h"
+
+/* drives SynthRenderer::readData() from an audio thread, as the outputs do,
+   while the main thread plays layers, a bounced file and a pre-warmed file.
+   readData() checks itself with an RtScope. EAS parses a MIDI file while it
+   plays it, reading it through stdio, so the file reads are only printed
+   where an EAS stream plays; any other violation fails the test */
+
+static const std::size_t CALL_FRAMES[] = {64, 100, 128, 333, 512};
+/* faster than real time, so that the song ends soon */
+static const int CALL_INTERVAL = 2;
+static const int PREPARE_TIMEOUT = 5000;
+static const int PLAYBACK_TIMEOUT = 30000;
+
+static std::atomic<bool> rendering{true};
+
+static void renderLoop(SynthRenderer *renderer)
+{
+    const QAudioFormat &format = renderer->format();
+    std::vector<char> buffer(format.bytesForFrames(512));
+    for (int call = 0; rendering.load(std::memory_order_acquire); ++call) {
+        const std::size_t frames = CALL_FRAMES[call % (sizeof(CALL_FRAMES) / sizeof(CALL_FRAMES[0]))];
+        renderer->readData(buffer.data(), format.bytesForFrames(qint64(frames)));
+        std::this_thread::sleep_for(std::chrono::milliseconds(CALL_INTERVAL));
+    }
+}
+
+/* runs the main thread events, as the timers and queued calls of the renderer need */
+static bool waitFor(const std::function<bool()> &done, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.hasExpired(timeout)) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        QThread::msleep(5);
+    }
+    return true;
+}
+
+static void runEvents(int duration)
+{
+    waitFor([] { return false; }, duration);
+}
+
+static bool checkCounters(const char *phase, bool fileReads)
+{
+    RtSafety::Counters counters;
+    RtSafety::read(counters);
+    RtSafety::reset();
+    std::printf("%s: allocations %" PRIu64 " deallocations %" PRIu64 " locks %" PRIu64
+                " file opens %" PRIu64 " file reads and writes %" PRIu64 "\n",
+                phase,
+                counters.allocations,
+                counters.deallocations,
+                counters.locks,
+                counters.fileOpens,
+                counters.fileIo);
+    return counters.allocations == 0 && counters.deallocations == 0 && counters.locks == 0
+           && counters.fileOpens == 0 && (fileReads || counters.fileIo == 0);
+}
+
+static bool allPlayers(const SynthRenderer &renderer, int state)
+{
+    for (int i = 0; i < SynthRenderer::MAX_PLAYERS; ++i) {
+        if (renderer.playerState(i) != state) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* every layer opened, paused, resumed, moved and closed while rendering */
+static bool playLayers(SynthRenderer &renderer, const QString &fileName)
+{
+    for (int i = 0; i < SynthRenderer::MAX_PLAYERS; ++i) {
+        if (!renderer.openPlayer(i, fileName)) {
+            std::fprintf(stderr, "cannot open player %d\n", i);
+            return false;
+        }
+    }
+    if (!waitFor([&] { return allPlayers(renderer, SynthRenderer::PlayerPlaying); }, PREPARE_TIMEOUT)) {
+        std::fprintf(stderr, "the layers did not start\n");
+        return false;
+    }
+    renderer.setPlayerVolume(0, SynthRenderer::MAX_PLAYER_VOLUME / 2);
+    renderer.setPlayerPaused(0, true);
+    runEvents(100);
+    renderer.setPlayerPaused(0, false);
+    renderer.seekPlayer(0, 1000);
+    runEvents(300);
+    for (int i = 0; i < SynthRenderer::MAX_PLAYERS; ++i) {
+        renderer.closePlayer(i);
+    }
+    if (!waitFor([&] { return allPlayers(renderer, SynthRenderer::PlayerClosed); }, PREPARE_TIMEOUT)) {
+        std::fprintf(stderr, "the layers did not close\n");
+        return false;
+    }
+    return true;
+}
+
+static bool playFile(SynthRenderer &renderer, const QString &fileName)
+{
+    bool stopped = false;
+    QMetaObject::Connection connection = QObject::connect(&renderer,
+                                                          &SynthRenderer::playbackStopped,
+                                                          [&] { stopped = true; });
+    renderer.startPlayback(fileName);
+    const bool ok = waitFor([&] { return stopped; }, PLAYBACK_TIMEOUT);
+    QObject::disconnect(connection);
+    if (!ok) {
+        std::fprintf(stderr, "the playback did not end\n");
+    }
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s file.mid\n", argv[0]);
+        return 1;
+    }
+    const QString fileName = QString::fromLocal8Bit(argv[1]);
+    SynthRenderer renderer;
+    renderer.start();
+    RtSafety::reset();
+    std::thread audio(renderLoop, &renderer);
+
+    bool ok = playLayers(renderer, fileName);
+    ok = checkCounters("layers", true) && ok;
+
+    /* the song is rendered ahead, and only mixed on the audio thread */
+    renderer.setBounce(true);
+    ok = ok && playFile(renderer, fileName);
+    renderer.setBounce(false);
+    ok = checkCounters("bounce", false) && ok;
+
+    /* the file is opened with its engine on the preparation thread */
+    renderer.setDeterministic(true);
+    renderer.setPrewarm(true);
+    ok = ok && playFile(renderer, fileName);
+    renderer.setPrewarm(false);
+    renderer.setDeterministic(false);
+
+    rendering.store(false, std::memory_order_release);
+    audio.join();
+    ok = checkCounters("prewarm", true) && ok;
+    renderer.stop();
+    return ok ? 0 : 1;
+}
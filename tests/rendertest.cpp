@@ -0,0 +1,212 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "smfscanner.h"
+#include "svoxeascore.h"
+
+/* renders a MIDI file in deterministic mode through the C interface, and
+   prints or compares the checksums of the output */
+
+static const int EXIT_SKIP = 77;
+static const int CHECKSUM_BLOCKS = 16;
+static const int TAIL_SECONDS = 1;
+static const int LOOKAHEAD_FRAMES = 4096;
+
+struct TimedMessage {
+    std::int64_t micros;
+    std::uint8_t data[3];
+    std::size_t length;
+};
+
+static bool loadFile(const char *path, std::vector<TimedMessage> &messages, std::int64_t &lengthMicros)
+{
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)),
+                                         std::istreambuf_iterator<char>());
+    SmfScanner smf;
+    if (!smf.open(data.data(), data.size())) {
+        return false;
+    }
+    const auto tempoMap = smf.tempoMap();
+    lengthMicros = 0;
+    smf.forEachEvent([&](const SmfEvent &ev) {
+        const std::int64_t micros = std::llround(smf.millis(ev.tick, tempoMap) * 1000.0);
+        lengthMicros = std::max(lengthMicros, micros);
+        if (ev.status >= 0x80 && ev.status < 0xf0) {
+            const int type = ev.status & 0xf0;
+            messages.push_back({micros,
+                                {ev.status, ev.data1, ev.data2},
+                                std::size_t((type == 0xc0 || type == 0xd0) ? 2 : 3)});
+        }
+        return true;
+    });
+    std::stable_sort(messages.begin(), messages.end(), [](const auto &a, const auto &b) {
+        return a.micros < b.micros;
+    });
+    return true;
+}
+
+/* one line per checksum window, and the checksum of the whole render */
+static bool render(svoxeas_engine *engine,
+                   const std::vector<TimedMessage> &messages,
+                   std::int64_t lengthMicros,
+                   std::size_t chunk,
+                   std::vector<std::string> &lines)
+{
+    const int rate = svoxeas_sample_rate(engine);
+    std::vector<std::int16_t> buffer(chunk * svoxeas_channels(engine));
+    if (svoxeas_reset(engine) != 0) {
+        return false;
+    }
+    const std::int64_t base = svoxeas_rendered_frames(engine);
+    const std::int64_t end = base + (lengthMicros * rate) / 1000000 + TAIL_SECONDS * rate;
+    std::size_t next = 0;
+    char line[64];
+    lines.clear();
+    for (std::int64_t frame = base; frame < end;) {
+        const std::size_t frames = std::size_t(std::min<std::int64_t>(chunk, end - frame));
+        /* the messages are queued a little ahead, enough for the EAS block
+           that ends after this chunk, but never so many that the queue fills */
+        while (next < messages.size()) {
+            const std::int64_t at = base + (messages[next].micros * rate) / 1000000;
+            if (at >= frame + std::int64_t(frames) + LOOKAHEAD_FRAMES) {
+                break;
+            }
+            if (svoxeas_write_midi_at(engine, messages[next].data, messages[next].length, at) != 0) {
+                std::fprintf(stderr, "MIDI queue full at frame %" PRId64 "\n", at);
+                return false;
+            }
+            ++next;
+        }
+        frame += std::int64_t(svoxeas_render_s16(engine, buffer.data(), frames));
+        std::uint64_t first, value;
+        while (svoxeas_take_checksum(engine, &first, &value)) {
+            std::snprintf(line, sizeof(line), "%" PRIu64 " %016" PRIx64, first, value);
+            lines.push_back(line);
+        }
+    }
+    std::snprintf(line, sizeof(line), "total %016" PRIx64, svoxeas_checksum(engine));
+    lines.push_back(line);
+    return true;
+}
+
+static void usage()
+{
+    std::fprintf(stderr,
+                 "usage: mp_rendertest [--repeat | --compare golden.txt | --write golden.txt] file.mid\n");
+}
+
+int main(int argc, char *argv[])
+{
+    enum { Print, Repeat, Compare, Write } mode = Print;
+    const char *golden = nullptr;
+    const char *midiFile = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--repeat") == 0) {
+            mode = Repeat;
+        } else if ((std::strcmp(argv[i], "--compare") == 0 || std::strcmp(argv[i], "--write") == 0)
+                   && i + 1 < argc) {
+            mode = (argv[i][2] == 'c') ? Compare : Write;
+            golden = argv[++i];
+        } else if (midiFile == nullptr) {
+            midiFile = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (midiFile == nullptr) {
+        usage();
+        return 2;
+    }
+
+    std::vector<TimedMessage> messages;
+    std::int64_t lengthMicros;
+    if (!loadFile(midiFile, messages, lengthMicros)) {
+        std::fprintf(stderr, "cannot read %s\n", midiFile);
+        return 1;
+    }
+    svoxeas_engine *engine = svoxeas_create(1, nullptr);
+    if (engine == nullptr) {
+        std::fprintf(stderr, "cannot create the engine\n");
+        return 1;
+    }
+    svoxeas_set_deterministic(engine, 1);
+    svoxeas_set_checksum_interval(engine, CHECKSUM_BLOCKS);
+
+    int status = 0;
+    std::vector<std::string> lines;
+    if (!render(engine, messages, lengthMicros, 512, lines)) {
+        status = 1;
+    } else if (mode == Repeat) {
+        /* the same engine again, after a reset and with another buffer size */
+        std::vector<std::string> again;
+        if (!render(engine, messages, lengthMicros, 333, again)) {
+            status = 1;
+        } else if (again != lines) {
+            std::fprintf(stderr, "the second render differs from the first one\n");
+            status = 1;
+        }
+    } else if (mode == Compare) {
+        std::ifstream file(golden);
+        if (!file) {
+            std::fprintf(stderr, "no reference checksums in %s\n", golden);
+            status = EXIT_SKIP;
+        } else {
+            std::vector<std::string> expected;
+            std::string line;
+            while (std::getline(file, line)) {
+                if (!line.empty()) {
+                    expected.push_back(line);
+                }
+            }
+            if (expected != lines) {
+                std::fprintf(stderr, "the checksums differ from %s\n", golden);
+                for (const auto &l : lines) {
+                    std::fprintf(stderr, "%s\n", l.c_str());
+                }
+                status = 1;
+            }
+        }
+    } else {
+        FILE *out = (mode == Write) ? std::fopen(golden, "w") : stdout;
+        if (out == nullptr) {
+            std::fprintf(stderr, "cannot write %s\n", golden);
+            status = 1;
+        } else {
+            for (const auto &l : lines) {
+                std::fprintf(out, "%s\n", l.c_str());
+            }
+            if (out != stdout) {
+                std::fclose(out);
+            }
+        }
+    }
+    svoxeas_destroy(engine);
+    return status;
+}
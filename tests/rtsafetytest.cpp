@@ -0,0 +1,138 @@
+/*
+    Sonivox EAS Synthesizer for Qt applications
+    Copyright (C) 2016-2025, Pedro Lopez-Cabanillas <plcl@users.sf.net>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+#include "rtsafety.h"
+#include "synthengine.h"
+
+/* renders and writes MIDI on a checked real-time thread; the first heap
+   allocation, lock, file open, read or write aborts the test with a
+   backtrace */
+
+static const int RENDER_CALLS = 200;
+static const std::size_t CALL_FRAMES[] = {64, 100, 128, 333, 512};
+/* how often the prewarm run starts a prewarm, and for how many blocks */
+static const int PREWARM_INTERVAL = 25;
+static const int PREWARM_BLOCKS = 4;
+
+static bool writeMessages(SynthEngine &engine, int call, std::int64_t frame)
+{
+    /* the same messages as the MIDI input: notes, controllers, bends and SysEx */
+    const std::uint8_t channel = call % 16;
+    const std::uint8_t note = 36 + call % 48;
+    const std::uint8_t noteOn[] = {std::uint8_t(0x90 | channel), note, 100};
+    const std::uint8_t noteOff[] = {std::uint8_t(0x80 | channel), note, 0};
+    const std::uint8_t controller[] = {std::uint8_t(0xb0 | channel), 7, std::uint8_t(call % 128)};
+    const std::uint8_t bend[] = {std::uint8_t(0xe0 | channel), 0, std::uint8_t(call % 128)};
+    const std::uint8_t program[] = {std::uint8_t(0xc0 | channel), std::uint8_t(call % 128)};
+    const std::uint8_t gmReset[] = {0xf0, 0x7e, 0x7f, 0x09, 0x01, 0xf7};
+    return engine.writeMIDI(noteOn, sizeof(noteOn), frame)
+           && engine.writeMIDI(controller, sizeof(controller), frame)
+           && engine.writeMIDI(bend, sizeof(bend), frame)
+           && engine.writeMIDI(program, sizeof(program), frame)
+           && engine.writeMIDI(noteOff, sizeof(noteOff), frame)
+           && (call % 50 != 0 || engine.writeMIDI(gmReset, sizeof(gmReset), frame));
+}
+
+/* the first notes of a song, as the renderer plays them on the warm stream */
+static const MidiMessage PREWARM_MESSAGES[] = {
+    {2, {0xc0, 0}},
+    {3, {0x90, 60, 1}},
+    {2, {0xc1, 48}},
+    {3, {0x91, 67, 1}},
+    {3, {0x99, 36, 1}},
+    {3, {0x99, 38, 1}},
+};
+
+static bool run(SynthEngine &engine, bool deterministic, bool prewarm)
+{
+    std::vector<std::int16_t> buffer(512 * engine.channels());
+    engine.setDeterministic(deterministic);
+    engine.checksum().setInterval(deterministic ? 4 : 0);
+    for (int call = 0; call < RENDER_CALLS; ++call) {
+        const std::size_t frames = CALL_FRAMES[call % (sizeof(CALL_FRAMES) / sizeof(CALL_FRAMES[0]))];
+        bool written, rendered;
+        {
+            /* the writer is checked too: the MIDI input must not block the render path */
+            RtScope rtScope;
+            const std::int64_t frame = deterministic ? engine.renderedFrames() + std::int64_t(frames) / 2
+                                                     : -1;
+            written = writeMessages(engine, call, frame);
+            if (call % 20 == 0) {
+                engine.setReverbWet(call % 32768);
+                engine.setChorusLevel(call % 32768);
+            }
+            /* the render path only writes to the warm stream opened beforehand */
+            if (prewarm && call % PREWARM_INTERVAL == 0
+                && !engine.prewarm(PREWARM_MESSAGES,
+                                   sizeof(PREWARM_MESSAGES) / sizeof(PREWARM_MESSAGES[0]),
+                                   PREWARM_BLOCKS)) {
+                std::fprintf(stderr, "prewarm refused at call %d\n", call);
+                return false;
+            }
+            rendered = engine.render(buffer.data(), frames) == frames;
+        }
+        if (!written || !rendered) {
+            std::fprintf(stderr, "%s at call %d\n", written ? "short render" : "MIDI queue full", call);
+            return false;
+        }
+        RenderChecksumEntry entry;
+        while (engine.checksum().take(entry)) {
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    SynthEngine engine;
+    if (!engine.init()) {
+        std::fprintf(stderr, "cannot initialize the engine\n");
+        return 1;
+    }
+    if (!engine.openWarmStream()) {
+        std::fprintf(stderr, "cannot open the warm stream\n");
+        return 1;
+    }
+    RtSafety::setAbortOnViolation(true);
+    RtSafety::reset();
+    const bool ok = run(engine, false, false) && run(engine, true, false) && run(engine, false, true);
+    RtSafety::setAbortOnViolation(false);
+
+    RtSafety::Counters counters;
+    RtSafety::read(counters);
+    std::printf("allocations %" PRIu64 " deallocations %" PRIu64 " locks %" PRIu64
+                " file opens %" PRIu64 " file reads and writes %" PRIu64 "\n",
+                counters.allocations,
+                counters.deallocations,
+                counters.locks,
+                counters.fileOpens,
+                counters.fileIo);
+    engine.shutdown();
+    if (!ok) {
+        return 1;
+    }
+    if (RtSafety::violations() != 0) {
+        std::fprintf(stderr, "%" PRIu64 " real-time safety violations\n", RtSafety::violations());
+        return 1;
+    }
+    return 0;
+}